@@ -0,0 +1,710 @@
+#include "../rlib/rlib.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <malloc.h>
+
+class BenchmarkTimer
+{
+public:
+    BenchmarkTimer() : m_start(std::chrono::steady_clock::now()) {}
+
+    double elapsedSeconds() const
+    {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+    }
+private:
+    std::chrono::steady_clock::time_point m_start;
+};
+
+/*
+Builds an MDP with numStates states, each one with numSuccessors transitions to random states with random probabilities.
+*/
+void generateRandomMdp(rlib::MDP& mdp, uint32_t numStates, uint32_t numSuccessors, uint32_t seed)
+{
+    urng_t engine(seed);
+    std::uniform_real_distribution<real_t> probDist(0.01, 1.0);
+    std::uniform_int_distribution<uint32_t> stateDist(0, numStates - 1);
+    std::vector<real_t> weights(numSuccessors);
+
+    uint32_t transitionId = 0;
+
+    for (uint32_t s = 0; s < numStates; ++s)
+    {
+        real_t totalWeight = 0.0;
+        for (uint32_t i = 0; i < numSuccessors; ++i)
+        {
+            weights[i] = probDist(engine);
+            totalWeight += weights[i];
+        }
+
+        rlib::MDP::State* state = mdp.getStateAt(s);
+        real_t assignedProb = 0.0;
+
+        for (uint32_t i = 0; i < numSuccessors; ++i)
+        {
+            // The last transition takes the remainder so that every row adds up to 1.0
+            real_t prob = (i + 1 < numSuccessors) ? weights[i] / totalWeight : 1.0 - assignedProb;
+            assignedProb += prob;
+
+            state->addTransition(new rlib::MDP::StateTransition(transitionId++, stateDist(engine), prob, 1.0));
+        }
+    }
+}
+
+/*
+Builds a compiled model where every state has numSuccessors transitions to random states plus an absorption transition
+with probability absorptionProb to the terminal state numStates - 1.
+*/
+std::shared_ptr<rlib::MdpModel> generateAbsorbingModel(uint32_t numStates, uint32_t numSuccessors, real_t absorptionProb, uint32_t seed)
+{
+    urng_t engine(seed);
+    std::uniform_real_distribution<real_t> costDist(1.0, 10.0);
+    std::uniform_int_distribution<uint32_t> stateDist(0, numStates - 2);
+
+    std::shared_ptr<rlib::MdpModel> model = std::make_shared<rlib::MdpModel>();
+    model->reserve(numStates, static_cast<size_t>(numStates) * (numSuccessors + 1));
+
+    for (uint32_t s = 0; s + 1 < numStates; ++s)
+    {
+        model->addState();
+
+        for (uint32_t i = 0; i < numSuccessors; ++i)
+            model->addTransition(stateDist(engine), (1.0 - absorptionProb) / numSuccessors, costDist(engine));
+
+        model->addTransition(numStates - 1, absorptionProb, costDist(engine));
+    }
+
+    model->addState();
+    model->addTransition(numStates - 1, 1.0, 0.0);
+
+    model->validate();
+    model->compile();
+
+    return model;
+}
+
+/*
+Measures the cost per value of filling blocks of random numbers through the virtual RngBase interface,
+with one call per value and with one bulk call per block.
+Not inlined, so that the compiler cannot devirtualize the calls as it would for a generator of known type.
+*/
+__attribute__((noinline)) void measureRng(const char* name, rlib::RngBase& rng, size_t numDraws)
+{
+    const size_t blockSize = 1024;
+    std::vector<real_t> block(blockSize);
+
+    BenchmarkTimer timer;
+    real_t checksum = 0.0;
+    for (size_t i = 0; i < numDraws; i += blockSize)
+    {
+        for (size_t j = 0; j < blockSize; ++j)
+            block[j] = rng.getRandomReal();
+        checksum += block[(i / blockSize) % blockSize];
+    }
+    double seconds = timer.elapsedSeconds();
+
+    BenchmarkTimer bulkTimer;
+    real_t bulkChecksum = 0.0;
+    for (size_t i = 0; i < numDraws; i += blockSize)
+    {
+        rng.fillUniform(block.data(), blockSize);
+        bulkChecksum += block[(i / blockSize) % blockSize];
+    }
+    double bulkSeconds = bulkTimer.elapsedSeconds();
+
+    printf("%-12s %6.2f ns/value single, %6.2f ns/value bulk (checksums %.1f %.1f)\n", name, seconds / numDraws * 1e9, bulkSeconds / numDraws * 1e9, checksum, bulkChecksum);
+}
+
+void rngBenchmark()
+{
+    printf("------RNG benchmark------\n");
+
+    const size_t numDraws = 20000000;
+
+    rlib::SeededRng seededRng(1);
+    rlib::XoshiroRng xoshiroRng(1);
+    rlib::Pcg64Rng pcgRng(1);
+    rlib::PhiloxRng philoxRng(1);
+
+    measureRng("default", seededRng, numDraws);
+    measureRng("xoshiro256++", xoshiroRng, numDraws);
+    measureRng("pcg64", pcgRng, numDraws);
+    measureRng("philox4x32-10", philoxRng, numDraws);
+    measureRng("thread local", rlib::getThreadRng(), numDraws);
+
+    std::vector<real_t> exponentials(numDraws);
+    BenchmarkTimer exponentialTimer;
+    xoshiroRng.fillExponential(exponentials.data(), exponentials.size());
+    double exponentialSeconds = exponentialTimer.elapsedSeconds();
+
+    printf("exponential  %6.2f ns/value bulk\n", exponentialSeconds / numDraws * 1e9);
+}
+
+void samplingBenchmark()
+{
+    printf("------MDP sampling benchmark------\n");
+
+    const uint32_t numStates = 10000;
+    const uint32_t numSuccessorsList[3] = { 4, 64, 512 };
+    const size_t numSteps = 5000000;
+
+    const rlib::MdpSamplingMode modes[3] = { rlib::MdpSamplingMode::kSamplingLinear, rlib::MdpSamplingMode::kSamplingCumulative, rlib::MdpSamplingMode::kSamplingAlias };
+    const char* modeNames[3] = { "linear", "cumulative", "alias" };
+
+    for (int k = 0; k < 3; ++k)
+    {
+        rlib::MDP mdp(numStates);
+        generateRandomMdp(mdp, numStates, numSuccessorsList[k], 42);
+
+        for (int m = 0; m < 3; ++m)
+        {
+            mdp.setSamplingMode(modes[m]);
+            mdp.initialize();
+
+            BenchmarkTimer timer;
+            for (size_t i = 0; i < numSteps; ++i)
+                mdp.update();
+            double seconds = timer.elapsedSeconds();
+
+            printf("successors=%4u mode=%-10s %8.2f Msteps/s (total cost %.0f)\n", numSuccessorsList[k], modeNames[m], numSteps / seconds * 1e-6, mdp.getTotalCost());
+        }
+    }
+}
+
+/*
+Returns the number of bytes currently allocated through malloc, including the large blocks served by mmap.
+*/
+size_t getAllocatedBytes()
+{
+    struct mallinfo2 info = mallinfo2();
+    return info.uordblks + info.hblkhd;
+}
+
+/*
+Steps an MDP through the virtual generator interface. Not inlined, so that the calls cannot be devirtualized.
+*/
+__attribute__((noinline)) void stepWithRngBase(rlib::MDP& mdp, rlib::RngBase& rng, size_t numSteps)
+{
+    for (size_t i = 0; i < numSteps; ++i)
+        mdp.update(rng);
+}
+
+void generatorPolicyBenchmark()
+{
+    printf("------MDP generator policy benchmark------\n");
+
+    // A small model stays in L1, so that the generator is a visible part of the step
+    const uint32_t numStates = 64;
+    const size_t numSteps = 20000000;
+
+    rlib::MDP mdp(numStates);
+    generateRandomMdp(mdp, numStates, 4, 42);
+    mdp.setSamplingMode(rlib::MdpSamplingMode::kSamplingAlias);
+    mdp.initialize();
+
+    rlib::XoshiroRng rng(1);
+    rlib::Xoshiro256PlusPlus engine(1);
+
+    BenchmarkTimer virtualTimer;
+    stepWithRngBase(mdp, rng, numSteps);
+    double virtualSeconds = virtualTimer.elapsedSeconds();
+
+    BenchmarkTimer threadTimer;
+    for (size_t i = 0; i < numSteps; ++i)
+        mdp.update();
+    double threadSeconds = threadTimer.elapsedSeconds();
+
+    BenchmarkTimer inlinedTimer;
+    for (size_t i = 0; i < numSteps; ++i)
+        mdp.update(engine);
+    double inlinedSeconds = inlinedTimer.elapsedSeconds();
+
+    printf("RngBase&            %8.2f Msteps/s\n", numSteps / virtualSeconds * 1e-6);
+    printf("thread generator    %8.2f Msteps/s\n", numSteps / threadSeconds * 1e-6);
+    printf("inlined engine      %8.2f Msteps/s (total cost %.0f)\n", numSteps / inlinedSeconds * 1e-6, mdp.getTotalCost());
+}
+
+void batchRunnerBenchmark()
+{
+    printf("------MDP batch runner benchmark------\n");
+
+    const uint32_t numStates = 10000;
+    const size_t numChainsList[2] = { 1024, 16384 };
+    const size_t numChainSteps = 20000000;
+
+    rlib::MDP mdp(numStates);
+    generateRandomMdp(mdp, numStates, 8, 42);
+    mdp.setSamplingMode(rlib::MdpSamplingMode::kSamplingAlias);
+    mdp.initialize();
+
+    BenchmarkTimer timer;
+    for (size_t i = 0; i < numChainSteps; ++i)
+        mdp.update();
+    double seconds = timer.elapsedSeconds();
+
+    printf("MDP::update()          %8.2f M chain-steps/s\n", numChainSteps / seconds * 1e-6);
+
+    for (int k = 0; k < 2; ++k)
+    {
+        rlib::MdpBatchRunner batch(mdp.getSharedModel(), numChainsList[k], 42);
+
+        BenchmarkTimer batchTimer;
+        for (size_t i = 0; i < numChainSteps / numChainsList[k]; ++i)
+            batch.update();
+        double batchSeconds = batchTimer.elapsedSeconds();
+
+        printf("batch chains=%6zu     %8.2f M chain-steps/s (cost of chain 0: %.0f)\n", numChainsList[k], numChainSteps / batchSeconds * 1e-6, batch.getTotalCosts()[0]);
+    }
+}
+
+/*
+Builds numStates states with up to numSuccessors transitions each, looking states up by ID and checking for existing transitions
+as models are typically built. Heap allocates every state and transition unless useArena is set.
+Returns:
+- The number of transitions created.
+*/
+uint32_t buildMdp(rlib::MDP& mdp, uint32_t numStates, uint32_t numSuccessors, bool useArena)
+{
+    urng_t engine(3);
+    std::uniform_int_distribution<uint32_t> stateDist(0, numStates - 1);
+
+    for (uint32_t s = 0; s < numStates; ++s)
+    {
+        if (useArena)
+            mdp.createState(s);
+        else
+            mdp.addState(new rlib::MDP::State(&mdp, s));
+    }
+
+    uint32_t transitionId = 0;
+    for (uint32_t s = 0; s < numStates; ++s)
+    {
+        for (uint32_t i = 0; i < numSuccessors; ++i)
+        {
+            uint32_t next = stateDist(engine);
+            rlib::MDP::State* state = mdp.getState(s);
+
+            if (state->getTransitionToState(next) != nullptr)
+                continue;
+
+            if (useArena)
+                state->createTransition(transitionId++, next, 0.0, 1.0);
+            else
+                state->addTransition(new rlib::MDP::StateTransition(transitionId++, next, 0.0, 1.0));
+        }
+    }
+
+    return transitionId;
+}
+
+void mdpBuildBenchmark()
+{
+    printf("------MDP build benchmark------\n");
+
+    const uint32_t numStates = 100000;
+    const uint32_t numSuccessors = 10;
+
+    for (int k = 0; k < 2; ++k)
+    {
+        const bool useArena = k == 1;
+
+        size_t heapBefore = getAllocatedBytes();
+        BenchmarkTimer timer;
+
+        rlib::MDP mdp;
+        uint32_t numTransitions = buildMdp(mdp, numStates, numSuccessors, useArena);
+
+        double buildSeconds = timer.elapsedSeconds();
+        size_t heapBytes = getAllocatedBytes() - heapBefore;
+
+        BenchmarkTimer finalizeTimer;
+        mdp.finalize();
+        double finalizeSeconds = finalizeTimer.elapsedSeconds();
+
+        // The lookup table and the model are the same in both cases, the difference comes from the states and transitions
+        printf("%-5s states=%u transitions=%u build: %.3f s finalize: %.3f s heap: %.1f bytes/transition\n", useArena ? "arena" : "heap",
+            numStates, numTransitions, buildSeconds, finalizeSeconds, (double)heapBytes / numTransitions);
+    }
+}
+
+void solverBenchmark()
+{
+    printf("------MDP solver benchmark------\n");
+
+    const uint32_t numStatesList[2] = { 10000, 1000000 };
+
+    for (int n = 0; n < 2; ++n)
+    {
+        std::shared_ptr<rlib::MdpModel> model = generateAbsorbingModel(numStatesList[n], 4, 0.05, 7);
+
+        rlib::MdpCostSolver solver(model);
+        rlib::MdpSolverOptions options;
+        options.tolerance = 1e-6;
+
+        BenchmarkTimer solverTimer;
+        rlib::MdpSolverResult solution = solver.solve(options);
+        double solverSeconds = solverTimer.elapsedSeconds();
+
+        printf("states=%7u solver:      v[0]=%10.4f  %5u sweeps   %8.3f s\n", numStatesList[n], solution.values[0], solution.numIterations, solverSeconds);
+
+        rlib::MdpRolloutEngine engine(model);
+        rlib::MdpRolloutOptions rolloutOptions;
+        rolloutOptions.numTrajectories = 100000;
+        rolloutOptions.seed = 1;
+
+        BenchmarkTimer rolloutTimer;
+        rlib::MdpRolloutResult estimate = engine.run(rolloutOptions);
+        double rolloutSeconds = rolloutTimer.elapsedSeconds();
+
+        real_t halfWidth = 1.96 * estimate.stddevCost / std::sqrt((real_t)estimate.numTrajectories);
+        printf("states=%7u monte carlo: v[0]=%10.4f +- %.4f (95%%, %zu trajectories) %8.3f s\n", numStatesList[n], estimate.meanCost, halfWidth, estimate.numTrajectories, rolloutSeconds);
+    }
+}
+
+void varianceReductionBenchmark()
+{
+    printf("------MDP variance reduction benchmark------\n");
+
+    const char* names[3] = { "plain", "antithetic", "quasi random" };
+    const rlib::MdpVarianceReduction schemes[3] = { rlib::MdpVarianceReduction::kNone, rlib::MdpVarianceReduction::kAntithetic, rlib::MdpVarianceReduction::kQuasiRandom };
+
+    std::shared_ptr<rlib::MdpModel> model = generateAbsorbingModel(1000, 4, 0.2, 7);
+    rlib::MdpRolloutEngine engine(model);
+    rlib::MdpRolloutOptions options;
+    options.numTrajectories = 1 << 18;
+    options.seed = 1;
+
+    for (int k = 0; k < 3; ++k)
+    {
+        options.varianceReduction = schemes[k];
+
+        BenchmarkTimer timer;
+        rlib::MdpRolloutResult estimate = engine.run(options);
+        double seconds = timer.elapsedSeconds();
+
+        // Trajectories plain Monte Carlo would need for the same confidence interval, divided by the variance reduction factor
+        printf("%-13s v[0]=%9.4f +- %.4f (95%%) factor %7.2f -> %8.0f equivalent trajectories %8.3f s\n", names[k], estimate.meanCost, 1.96 * estimate.stderrCost,
+            estimate.varianceReductionFactor, estimate.numTrajectories * estimate.varianceReductionFactor, seconds);
+    }
+
+    // A slightly less absorbing variant of the same model, drawn from the same engine state
+    rlib::MdpRolloutEngine otherEngine(generateAbsorbingModel(1000, 4, 0.19, 7));
+    options.varianceReduction = rlib::MdpVarianceReduction::kNone;
+
+    BenchmarkTimer timer;
+    rlib::MdpRolloutComparison comparison = engine.compare(otherEngine, options);
+    double seconds = timer.elapsedSeconds();
+
+    printf("common random numbers: difference %8.4f +- %.4f (95%%) factor %7.2f %8.3f s\n", comparison.meanDifference, 1.96 * comparison.stderrDifference, comparison.varianceReductionFactor, seconds);
+}
+
+void mdpFileBenchmark()
+{
+    printf("------MDP file benchmark------\n");
+
+    // 10^6 states with 10 transitions each
+    std::shared_ptr<rlib::MdpModel> model = generateAbsorbingModel(1000000, 9, 0.05, 11);
+
+    BenchmarkTimer saveTimer;
+    model->saveToFile("benchmarkModel.mdp");
+    double saveSeconds = saveTimer.elapsedSeconds();
+
+    BenchmarkTimer mapTimer;
+    std::shared_ptr<rlib::MdpModel> mapped = rlib::MdpModel::mapFromFile("benchmarkModel.mdp");
+    double mapSeconds = mapTimer.elapsedSeconds();
+
+    // Touching every transition faults all the pages in
+    BenchmarkTimer touchTimer;
+    real_t totalCost = 0.0;
+    for (uint32_t t = 0; t < mapped->getNumTransitions(); ++t)
+        totalCost += mapped->getCost(t) * mapped->getProbability(t);
+    double touchSeconds = touchTimer.elapsedSeconds();
+
+    printf("transitions=%zu save: %.3f s map: %.6f s first full pass: %.3f s (checksum %.1f)\n", mapped->getNumTransitions(), saveSeconds, mapSeconds, touchSeconds, totalCost);
+
+    std::remove("benchmarkModel.mdp");
+}
+
+/*
+Writes a parameter file with numStates states and numSuccessors transition definitions per state.
+*/
+void writeTransitionFile(const char* filename, uint32_t numStates, uint32_t numSuccessors)
+{
+    urng_t engine(5);
+    std::uniform_int_distribution<uint32_t> stateDist(0, numStates - 1);
+
+    FILE* file = fopen(filename, "w");
+    fprintf(file, "N %u\n", numStates);
+
+    for (uint32_t s = 0; s < numStates; ++s)
+    {
+        for (uint32_t i = 0; i < numSuccessors; ++i)
+            fprintf(file, "A %u %u %.17g %.17g\n", s, stateDist(engine), 1.0 / numSuccessors, 1.0 + i);
+    }
+
+    fclose(file);
+}
+
+void mdpBuilderBenchmark()
+{
+    printf("------MDP builder benchmark------\n");
+
+    const uint32_t numStatesList[2] = { 5000, 1000000 };
+    const uint32_t numSuccessors = 4;
+
+    for (int n = 0; n < 2; ++n)
+    {
+        writeTransitionFile("benchmarkParameters.txt", numStatesList[n], numSuccessors);
+        const size_t numTransitions = static_cast<size_t>(numStatesList[n]) * numSuccessors;
+
+        {
+            size_t heapBefore = getAllocatedBytes();
+            BenchmarkTimer timer;
+
+            rlib::ParameterManager parameters;
+            parameters.registerParameterType("N", rlib::ParameterType::kParamInt);
+            parameters.registerParameterType("A", rlib::ParameterType::kParamMdpStateTransitionDef);
+            parameters.loadFromFile("benchmarkParameters.txt");
+
+            double seconds = timer.elapsedSeconds();
+            size_t heapBytes = getAllocatedBytes() - heapBefore;
+
+            printf("parameters transitions=%8zu load: %.3f s heap: %.1f bytes/transition (before building any model)\n", numTransitions, seconds, (double)heapBytes / numTransitions);
+        }
+
+        size_t heapBefore = getAllocatedBytes();
+        BenchmarkTimer timer;
+
+        rlib::MdpModelBuilder builder("A");
+        std::shared_ptr<rlib::MdpModel> model = builder.buildFromFile("benchmarkParameters.txt");
+
+        double seconds = timer.elapsedSeconds();
+        size_t heapBytes = getAllocatedBytes() - heapBefore;
+
+        printf("builder    transitions=%8zu load: %.3f s heap: %.1f bytes/transition (compiled model)\n", model->getNumTransitions(), seconds, (double)heapBytes / numTransitions);
+    }
+
+    std::remove("benchmarkParameters.txt");
+}
+
+void parameterManagerBenchmark()
+{
+    printf("------Parameter manager benchmark------\n");
+
+    // 250000 states with 4 transitions each, plus the number of states: 10^6 lines
+    const uint32_t numStates = 250000;
+    const size_t numLookups = 1000000;
+
+    writeTransitionFile("benchmarkParameters.txt", numStates, 4);
+
+    const size_t bytesBefore = getAllocatedBytes();
+    BenchmarkTimer loadTimer;
+    rlib::ParameterManager parameters;
+    parameters.registerParameterType("N", rlib::ParameterType::kParamInt);
+    parameters.registerParameterType("A", rlib::ParameterType::kParamMdpStateTransitionDef);
+    parameters.loadFromFile("benchmarkParameters.txt");
+    double loadSeconds = loadTimer.elapsedSeconds();
+    const size_t loadedBytes = getAllocatedBytes() - bytesBefore;
+
+    urng_t engine(9);
+    std::uniform_int_distribution<size_t> indexDist(1, parameters.getNumParametersOfTypeName("A"));
+    std::vector<std::string> names(numLookups);
+    for (size_t i = 0; i < numLookups; ++i)
+        names[i] = "A_" + std::to_string(indexDist(engine));
+
+    BenchmarkTimer lookupTimer;
+    size_t numFound = 0;
+    for (size_t i = 0; i < numLookups; ++i)
+        numFound += parameters.getParameter(names[i]) != nullptr ? 1 : 0;
+    double lookupSeconds = lookupTimer.elapsedSeconds();
+
+    // Finding the handle only probes the name index, getParameter() also creates the Parameter view on its first access
+    BenchmarkTimer handleTimer;
+    size_t numHandles = 0;
+    for (size_t i = 0; i < numLookups; ++i)
+        numHandles += parameters.findParameter(names[i]).isValid() ? 1 : 0;
+    double handleSeconds = handleTimer.elapsedSeconds();
+
+    printf("parameters=%zu load: %.3f s (%.0f ns/line) lookup by name: %.0f ns (%zu found) handle: %.0f ns (%zu found)\n", parameters.getNumParameters(), loadSeconds,
+        loadSeconds * 1e9 / parameters.getNumParameters(), lookupSeconds * 1e9 / numLookups, numFound, handleSeconds * 1e9 / numLookups, numHandles);
+
+    // The values are read from the transition column through handles, without a Parameter object per transition
+    std::vector<rlib::ParameterHandle> handles;
+    parameters.getHandlesOfType(rlib::ParameterType::kParamMdpStateTransitionDef, handles);
+
+    BenchmarkTimer scanTimer;
+    real_t totalProbability = 0.0;
+    for (rlib::ParameterHandle handle : handles)
+        totalProbability += parameters.getTransition(handle).probability;
+    double scanSeconds = scanTimer.elapsedSeconds();
+
+    printf("memory: %.1f MB (%.0f bytes/parameter) scan of the transitions: %.1f ns/parameter (total probability %.0f)\n", loadedBytes / 1e6,
+        static_cast<double>(loadedBytes) / parameters.getNumParameters(), scanSeconds * 1e9 / handles.size(), totalProbability);
+
+    // Reads of 1024 transitions in a loop: by name through the Parameter objects, through checked handles, then through typed handles
+    const size_t numReads = 10000000;
+    const size_t kNumHotParameters = 1024;
+    std::vector<rlib::ParameterHandle> hotHandles(kNumHotParameters);
+    std::vector<rlib::ParamHandle<rlib::MdpTransitionValue>> hotParams(kNumHotParameters);
+
+    for (size_t i = 0; i < kNumHotParameters; ++i)
+    {
+        hotHandles[i] = parameters.findParameter(names[i]);
+        hotParams[i] = parameters.bindParameter<rlib::MdpTransitionValue>(names[i]);
+    }
+
+    double readSeconds[3];
+    real_t readSums[3] = { 0.0, 0.0, 0.0 };
+
+    BenchmarkTimer nameReadTimer;
+    for (size_t i = 0; i < numReads; ++i)
+        readSums[0] += static_cast<const rlib::MdpStateTransitionDefParameter*>(parameters.getParameter(names[i % kNumHotParameters]))->getProbability();
+    readSeconds[0] = nameReadTimer.elapsedSeconds();
+
+    BenchmarkTimer handleReadTimer;
+    for (size_t i = 0; i < numReads; ++i)
+        readSums[1] += parameters.getTransition(hotHandles[i % kNumHotParameters]).probability;
+    readSeconds[1] = handleReadTimer.elapsedSeconds();
+
+    BenchmarkTimer typedReadTimer;
+    for (size_t i = 0; i < numReads; ++i)
+        readSums[2] += hotParams[i % kNumHotParameters].get().probability;
+    readSeconds[2] = typedReadTimer.elapsedSeconds();
+
+    printf("read by name: %.2f ns handle: %.2f ns typed handle: %.2f ns (sums %.0f %.0f %.0f)\n", readSeconds[0] * 1e9 / numReads, readSeconds[1] * 1e9 / numReads,
+        readSeconds[2] * 1e9 / numReads, readSums[0], readSums[1], readSums[2]);
+
+    // Parallel chunked load, only faster than the sequential one with as many cores as threads
+    for (unsigned numThreads = 2; numThreads <= 4; numThreads *= 2)
+    {
+        BenchmarkTimer parallelTimer;
+        rlib::ParameterManager parallelParameters;
+        parallelParameters.registerParameterType("N", rlib::ParameterType::kParamInt);
+        parallelParameters.registerParameterType("A", rlib::ParameterType::kParamMdpStateTransitionDef);
+        parallelParameters.loadFromFile("benchmarkParameters.txt", numThreads);
+        double parallelSeconds = parallelTimer.elapsedSeconds();
+
+        printf("threads=%u load: %.3f s (%.0f ns/line, %.2fx, %u hardware threads)\n", numThreads, parallelSeconds, parallelSeconds * 1e9 / parallelParameters.getNumParameters(),
+            loadSeconds / parallelSeconds, std::thread::hardware_concurrency());
+    }
+
+    // Cold start parsing the file and writing its snapshot, then warm start restoring the snapshot
+    std::remove("benchmarkParameters.bin");
+    double cachedSeconds[2];
+
+    for (int warm = 0; warm < 2; ++warm)
+    {
+        BenchmarkTimer cachedTimer;
+        rlib::ParameterManager cachedParameters;
+        cachedParameters.registerParameterType("N", rlib::ParameterType::kParamInt);
+        cachedParameters.registerParameterType("A", rlib::ParameterType::kParamMdpStateTransitionDef);
+        cachedParameters.loadFromFileCached("benchmarkParameters.txt", "benchmarkParameters.bin");
+        cachedSeconds[warm] = cachedTimer.elapsedSeconds();
+    }
+
+    printf("snapshot cold start: %.3f s warm start: %.3f s (%.0f ns/parameter, %.1fx faster than parsing)\n", cachedSeconds[0], cachedSeconds[1],
+        cachedSeconds[1] * 1e9 / parameters.getNumParameters(), loadSeconds / cachedSeconds[1]);
+
+    std::remove("benchmarkParameters.bin");
+
+    // Hot reload: publishing a new version, then pinning the current version and reading a value through it
+    rlib::LiveParameterManager live("benchmarkParameters.txt", [](rlib::ParameterManager& manager)
+    {
+        manager.registerParameterType("N", rlib::ParameterType::kParamInt);
+        manager.registerParameterType("A", rlib::ParameterType::kParamMdpStateTransitionDef);
+    });
+
+    BenchmarkTimer reloadTimer;
+    live.reload();
+    double reloadSeconds = reloadTimer.elapsedSeconds();
+
+    // Handles are ids within a version, no reload happens during the loop
+    rlib::ParameterHandle numStatesHandle;
+    {
+        rlib::LiveParameterManager::ReadGuard guard(live);
+        numStatesHandle = guard->findParameter("N_1");
+    }
+
+    BenchmarkTimer guardTimer;
+    int64_t guardSum = 0;
+    for (size_t i = 0; i < numReads; ++i)
+    {
+        rlib::LiveParameterManager::ReadGuard guard(live);
+        guardSum += guard->getInt(numStatesHandle);
+    }
+    double guardSeconds = guardTimer.elapsedSeconds();
+
+    printf("live reload: %.3f s guard and read: %.2f ns (sum %lld)\n", reloadSeconds, guardSeconds * 1e9 / numReads, static_cast<long long>(guardSum));
+
+    std::remove("benchmarkParameters.txt");
+}
+
+void parameterLazyLoadBenchmark()
+{
+    printf("------Parameter lazy load benchmark------\n");
+
+    // A few hot scalars among 2000 cold arrays of 1000 values, about 20 MB
+    const int numHotParameters = 16;
+    const int numColdParameters = 2000;
+    const int arraySize = 1000;
+
+    urng_t engine(5);
+    std::uniform_real_distribution<double> valueDist(-1.0, 1.0);
+
+    FILE* file = fopen("benchmarkLazyParameters.txt", "w");
+    for (int i = 0; i < numHotParameters; ++i)
+        fprintf(file, "N %d\n", i);
+
+    for (int i = 0; i < numColdParameters; ++i)
+    {
+        fprintf(file, "doubleArray");
+        for (int j = 0; j < arraySize; ++j)
+            fprintf(file, " %.9g", valueDist(engine));
+        fprintf(file, "\n");
+    }
+
+    fclose(file);
+
+    double seconds[2];
+    int64_t sums[2] = { 0, 0 };
+
+    for (int lazy = 0; lazy < 2; ++lazy)
+    {
+        BenchmarkTimer timer;
+        rlib::ParameterManager parameters;
+        parameters.registerParameterType("N", rlib::ParameterType::kParamInt);
+
+        if (lazy)
+            parameters.loadFromFileLazy("benchmarkLazyParameters.txt");
+        else
+            parameters.loadFromFile("benchmarkLazyParameters.txt");
+
+        for (int i = 0; i < numHotParameters; ++i)
+            sums[lazy] += parameters.getInt(parameters.findParameter("N_" + std::to_string(i + 1)));
+
+        seconds[lazy] = timer.elapsedSeconds();
+    }
+
+    printf("load and read the hot parameters: eager %.3f s lazy %.4f s (%.0fx faster, sums %lld %lld)\n", seconds[0], seconds[1], seconds[0] / seconds[1],
+        static_cast<long long>(sums[0]), static_cast<long long>(sums[1]));
+
+    std::remove("benchmarkLazyParameters.txt");
+}
+
+int main()
+{
+    rngBenchmark();
+    samplingBenchmark();
+    generatorPolicyBenchmark();
+    batchRunnerBenchmark();
+    mdpBuildBenchmark();
+    solverBenchmark();
+    varianceReductionBenchmark();
+    mdpFileBenchmark();
+    mdpBuilderBenchmark();
+    parameterManagerBenchmark();
+    parameterLazyLoadBenchmark();
+
+    return EXIT_SUCCESS;
+}
\ No newline at end of file
@@ -23,4 +23,24 @@ real_t OnlineDataAnalysis::stddev() const {
         sqrt(m_2__ / number_of_data_points) : 0;
 }
 
+size_t OnlineDataAnalysis::numberOfDataPoints() const {
+    return number_of_data_points;
+}
+
+void OnlineDataAnalysis::merge(const OnlineDataAnalysis &other) {
+    if (other.number_of_data_points == 0)
+        return;
+
+    size_t merged_size = 
+        number_of_data_points + other.number_of_data_points;
+    real_t delta = other.mean_ - mean_;
+
+    m_2__ += 
+        other.m_2__ +
+        delta * delta * 
+        ((real_t)number_of_data_points * other.number_of_data_points / merged_size);
+    mean_ += delta * ((real_t)other.number_of_data_points / merged_size);
+    number_of_data_points = merged_size;
+}
+
 // clang-format on
@@ -31,4 +31,14 @@ class OnlineDataAnalysis {
 
     /* Returns the "standard deviation" of the data points inserted. */
     real_t stddev() const;
+
+    /* Returns the number of data points inserted. */
+    size_t numberOfDataPoints() const;
+
+    /* Merges the data points of another object into this one, as if they had
+     * been inserted here, by using the parallel variant of Welford's algo.
+     * (Chan et al.). It allows partial results computed on different threads
+     * to be combined.
+     * */
+    void merge(const OnlineDataAnalysis &other);
 };
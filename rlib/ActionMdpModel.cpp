@@ -0,0 +1,134 @@
+#include "ActionMdpModel.h"
+#include "ParameterManager.h"
+
+#include "Debug.h"
+#include "GeneralUtil.h"
+
+#include <algorithm>
+
+namespace rlib
+{
+    const uint32_t ActionMdpModel::kInvalidIndex;
+
+    uint32_t ActionMdpModel::addState()
+    {
+        m_stateOffsets.push_back(m_stateOffsets.back());
+        m_isValidated = false;
+
+        return static_cast<uint32_t>(getNumStates() - 1);
+    }
+
+    uint32_t ActionMdpModel::addAction(uint32_t actionID)
+    {
+        if (getNumStates() == 0)
+            REPORT_PANIC("ActionMdpModel::addAction: no state to add the action to");
+
+        m_actionOffsets.push_back(m_actionOffsets.back());
+        m_actionIDs.push_back(actionID);
+        m_stateOffsets.back()++;
+        m_isValidated = false;
+
+        return static_cast<uint32_t>(getNumActions() - 1);
+    }
+
+    void ActionMdpModel::addTransition(uint32_t nextState, real_t prob, real_t cost)
+    {
+        if (getNumActions() == 0)
+            REPORT_PANIC("ActionMdpModel::addTransition: no action to add the transition to");
+
+        m_nextStates.push_back(nextState);
+        m_probabilities.push_back(prob);
+        m_costs.push_back(cost);
+        m_actionOffsets.back()++;
+        m_isValidated = false;
+    }
+
+    bool ActionMdpModel::validate()
+    {
+        bool isValid = true;
+
+        if (m_discountFactor <= 0.0 || m_discountFactor > 1.0)
+        {
+            LOG_ERROR("ActionMdpModel::validate: discount factor %f is not in (0, 1]\n", m_discountFactor);
+            isValid = false;
+        }
+
+        for (uint32_t s = 0; s < getNumStates(); ++s)
+        {
+            for (uint32_t a = getActionBegin(s); a < getActionEnd(s); ++a)
+            {
+                real_t totalProb = 0.0;
+                bool hasInvalidTransition = false;
+
+                for (uint32_t t = getTransitionBegin(a); t < getTransitionEnd(a); ++t)
+                {
+                    totalProb += m_probabilities[t];
+                    hasInvalidTransition = hasInvalidTransition || m_probabilities[t] < 0.0 || m_nextStates[t] >= getNumStates();
+                }
+
+                if (hasInvalidTransition || !ARE_REALS_EQUAL(totalProb, 1.0))
+                {
+                    LOG_ERROR("ActionMdpModel::validate: action %u of state %u has invalid transitions\n", m_actionIDs[a], s);
+                    isValid = false;
+                }
+            }
+        }
+
+        m_isValidated = isValid;
+
+        return isValid;
+    }
+
+    std::shared_ptr<ActionMdpModel> ActionMdpModel::fromParameters(const ParameterManager& parameters, real_t discountFactor)
+    {
+        // The transitions are read straight from the value columns, without creating a Parameter per transition
+        std::vector<ParameterHandle> handles;
+        parameters.getHandlesOfType(ParameterType::kParamMdpStateTransitionDef, handles);
+
+        std::vector<const MdpTransitionValue*> defs;
+        defs.reserve(handles.size());
+
+        uint32_t numStates = 0;
+
+        for (size_t i = 0; i < handles.size(); ++i)
+        {
+            const MdpTransitionValue* def = &parameters.getTransition(handles[i]);
+
+            if (def->stateID < 0 || def->nextStateID < 0 || def->actionID < 0)
+                REPORT_PANIC("ActionMdpModel::fromParameters: negative ID in parameter " + parameters.getName(handles[i]));
+
+            numStates = std::max(numStates, static_cast<uint32_t>(std::max(def->stateID, def->nextStateID)) + 1);
+            defs.push_back(def);
+        }
+
+        // Group the transitions by (state, action), keeping the file order within each group
+        std::stable_sort(defs.begin(), defs.end(), [](const MdpTransitionValue* a, const MdpTransitionValue* b)
+        {
+            return a->stateID != b->stateID ? a->stateID < b->stateID : a->actionID < b->actionID;
+        });
+
+        std::shared_ptr<ActionMdpModel> model = std::make_shared<ActionMdpModel>();
+        model->setDiscountFactor(discountFactor);
+
+        size_t next = 0;
+
+        for (uint32_t s = 0; s < numStates; ++s)
+        {
+            model->addState();
+
+            while (next < defs.size() && static_cast<uint32_t>(defs[next]->stateID) == s)
+            {
+                const int actionID = defs[next]->actionID;
+                model->addAction(actionID);
+
+                for (; next < defs.size() && static_cast<uint32_t>(defs[next]->stateID) == s && defs[next]->actionID == actionID; ++next)
+                    model->addTransition(defs[next]->nextStateID, defs[next]->probability, defs[next]->cost);
+            }
+        }
+
+        if (!model->validate())
+            REPORT_PANIC("ActionMdpModel::fromParameters: invalid model");
+
+        return model;
+    }
+} // namespace rlib
\ No newline at end of file
@@ -0,0 +1,111 @@
+#ifndef ACTION_MDP_MODEL_H
+#define ACTION_MDP_MODEL_H
+
+#include <memory>
+#include <vector>
+#include <cstdint>
+
+#include "../mocc/mocc.hpp"
+
+namespace rlib
+{
+    class ParameterManager;
+
+    /*
+    Compiled representation of a Markov decision process with actions.
+    Every state owns a contiguous range of actions and every action owns a contiguous range of successors,
+    both stored in CSR form: the actions of state s are [getActionBegin(s), getActionEnd(s)) and the successors
+    of action a are [getTransitionBegin(a), getTransitionEnd(a)). Actions keep the user defined action ID they were added with.
+    States without actions are terminal.
+    */
+    class ActionMdpModel
+    {
+    public:
+        static const uint32_t kInvalidIndex = UINT32_MAX;
+
+        ActionMdpModel() : m_stateOffsets(1, 0), m_actionOffsets(1, 0), m_discountFactor(1.0), m_isValidated(false) {}
+        ~ActionMdpModel() = default;
+
+        /*
+        Appends a new state. Subsequent calls to addAction() add actions to this state.
+        Returns:
+        - The index of the new state.
+        */
+        uint32_t addState();
+
+        /*
+        Appends an action to the last added state. Subsequent calls to addTransition() add successors to this action.
+        Parameters:
+        - actionID: The user defined ID of the action.
+        Returns:
+        - The global index of the new action.
+        */
+        uint32_t addAction(uint32_t actionID);
+
+        /*
+        Appends a successor to the last added action.
+        Parameters:
+        - nextState: The index of the destination state.
+        - prob: The transition probability.
+        - cost: The cost of the transition.
+        */
+        void addTransition(uint32_t nextState, real_t prob, real_t cost);
+
+        /*
+        Checks that every action has non negative transition probabilities adding up to 1.0 and valid destination states.
+        Every invalid action is logged.
+        Returns:
+        - true if the model is valid, false otherwise.
+        */
+        bool validate();
+        bool isValidated() const { return m_isValidated; }
+
+        /*
+        Sets the discount factor applied to the value of the next state, in (0, 1]. Undiscounted models must reach a terminal state under every policy.
+        */
+        void setDiscountFactor(real_t discountFactor) { m_discountFactor = discountFactor; }
+        real_t getDiscountFactor() const { return m_discountFactor; }
+
+        size_t getNumStates() const { return m_stateOffsets.size() - 1; }
+        size_t getNumActions() const { return m_actionOffsets.size() - 1; }
+        size_t getNumTransitions() const { return m_nextStates.size(); }
+
+        uint32_t getActionBegin(uint32_t state) const { return m_stateOffsets[state]; }
+        uint32_t getActionEnd(uint32_t state) const { return m_stateOffsets[state + 1]; }
+        uint32_t getActionID(uint32_t action) const { return m_actionIDs[action]; }
+
+        uint32_t getTransitionBegin(uint32_t action) const { return m_actionOffsets[action]; }
+        uint32_t getTransitionEnd(uint32_t action) const { return m_actionOffsets[action + 1]; }
+
+        uint32_t getNextState(uint32_t transition) const { return m_nextStates[transition]; }
+        real_t getProbability(uint32_t transition) const { return m_probabilities[transition]; }
+        real_t getCost(uint32_t transition) const { return m_costs[transition]; }
+
+        bool isTerminal(uint32_t state) const { return m_stateOffsets[state] == m_stateOffsets[state + 1]; }
+
+        /*
+        Builds a model from the mdpStateTransitionDef parameters of a ParameterManager.
+        Every (state, action) pair becomes an action, states are numbered from 0 to the largest state ID found
+        and states without outgoing transitions are terminal.
+        Parameters:
+        - parameters: The parameter manager holding the transition definitions.
+        - discountFactor: The discount factor of the model.
+        Returns:
+        - The validated model.
+        */
+        static std::shared_ptr<ActionMdpModel> fromParameters(const ParameterManager& parameters, real_t discountFactor = 1.0);
+
+    private:
+        std::vector<uint32_t> m_stateOffsets;
+        std::vector<uint32_t> m_actionOffsets;
+        std::vector<uint32_t> m_actionIDs;
+        std::vector<uint32_t> m_nextStates;
+        std::vector<real_t> m_probabilities;
+        std::vector<real_t> m_costs;
+
+        real_t m_discountFactor;
+        bool m_isValidated;
+    };
+} // namespace rlib
+
+#endif // ACTION_MDP_MODEL_H
\ No newline at end of file
@@ -0,0 +1,150 @@
+#include "ActionMdpSolver.h"
+
+#include "Debug.h"
+#include "GeneralUtil.h"
+
+#include <algorithm>
+
+namespace rlib
+{
+    ActionMdpSolver::ActionMdpSolver(std::shared_ptr<const ActionMdpModel> model) : m_model(model)
+    {
+        if (m_model == nullptr || !m_model->isValidated())
+            REPORT_PANIC("ActionMdpSolver::ActionMdpSolver: the model must be validated");
+    }
+
+    real_t ActionMdpSolver::actionValue(uint32_t action, const std::vector<real_t>& values) const
+    {
+        const ActionMdpModel& model = *m_model;
+        const real_t discount = model.getDiscountFactor();
+        real_t q = 0.0;
+
+        for (uint32_t t = model.getTransitionBegin(action); t < model.getTransitionEnd(action); ++t)
+            q += model.getProbability(t) * (model.getCost(t) + discount * values[model.getNextState(t)]);
+
+        return q;
+    }
+
+    real_t ActionMdpSolver::bellmanBackup(ThreadPool& pool, const std::vector<real_t>& values, std::vector<real_t>& outValues, std::vector<uint32_t>& outPolicy) const
+    {
+        const ActionMdpModel& model = *m_model;
+        std::vector<real_t> maxChanges(pool.getNumThreads(), 0.0);
+
+        pool.parallelFor(model.getNumStates(), [&](size_t begin, size_t end, unsigned threadIndex)
+        {
+            real_t maxChange = 0.0;
+
+            for (uint32_t s = static_cast<uint32_t>(begin); s < end; ++s)
+            {
+                real_t best = 0.0;
+                uint32_t bestAction = ActionMdpModel::kInvalidIndex;
+
+                for (uint32_t a = model.getActionBegin(s); a < model.getActionEnd(s); ++a)
+                {
+                    real_t q = actionValue(a, values);
+
+                    if (bestAction == ActionMdpModel::kInvalidIndex || q < best)
+                    {
+                        best = q;
+                        bestAction = a;
+                    }
+                }
+
+                outValues[s] = best;
+                outPolicy[s] = bestAction;
+                maxChange = std::max(maxChange, std::fabs(best - values[s]));
+            }
+
+            maxChanges[threadIndex] = maxChange;
+        });
+
+        return *std::max_element(maxChanges.begin(), maxChanges.end());
+    }
+
+    real_t ActionMdpSolver::policyBackup(ThreadPool& pool, const std::vector<uint32_t>& policy, const std::vector<real_t>& values, std::vector<real_t>& outValues) const
+    {
+        std::vector<real_t> maxChanges(pool.getNumThreads(), 0.0);
+
+        pool.parallelFor(m_model->getNumStates(), [&](size_t begin, size_t end, unsigned threadIndex)
+        {
+            real_t maxChange = 0.0;
+
+            for (size_t s = begin; s < end; ++s)
+            {
+                outValues[s] = policy[s] != ActionMdpModel::kInvalidIndex ? actionValue(policy[s], values) : 0.0;
+                maxChange = std::max(maxChange, std::fabs(outValues[s] - values[s]));
+            }
+
+            maxChanges[threadIndex] = maxChange;
+        });
+
+        return *std::max_element(maxChanges.begin(), maxChanges.end());
+    }
+
+    ActionMdpSolution ActionMdpSolver::valueIteration(const ActionMdpSolverOptions& options) const
+    {
+        const size_t numStates = m_model->getNumStates();
+        ThreadPool pool(options.numThreads);
+
+        ActionMdpSolution solution;
+        solution.values.assign(numStates, 0.0);
+        solution.policy.assign(numStates, ActionMdpModel::kInvalidIndex);
+        std::vector<real_t> nextValues(numStates, 0.0);
+
+        while (solution.numIterations < options.maxIterations)
+        {
+            solution.residual = bellmanBackup(pool, solution.values, nextValues, solution.policy);
+            solution.values.swap(nextValues);
+            solution.numIterations++;
+
+            if (solution.residual < options.tolerance)
+            {
+                solution.converged = true;
+                break;
+            }
+        }
+
+        LOG_DEBUG("ActionMdpSolver::valueIteration: %s after %u backups (residual %g)\n", solution.converged ? "converged" : "not converged", solution.numIterations, solution.residual);
+
+        return solution;
+    }
+
+    ActionMdpSolution ActionMdpSolver::policyIteration(const ActionMdpSolverOptions& options) const
+    {
+        const size_t numStates = m_model->getNumStates();
+        ThreadPool pool(options.numThreads);
+
+        ActionMdpSolution solution;
+        solution.values.assign(numStates, 0.0);
+        solution.policy.assign(numStates, ActionMdpModel::kInvalidIndex);
+        std::vector<real_t> nextValues(numStates, 0.0);
+
+        while (solution.numIterations < options.maxIterations)
+        {
+            // Improvement: greedy policy and Bellman residual of the current values
+            solution.residual = bellmanBackup(pool, solution.values, nextValues, solution.policy);
+            solution.values.swap(nextValues);
+            solution.numIterations++;
+
+            if (solution.residual < options.tolerance)
+            {
+                solution.converged = true;
+                break;
+            }
+
+            // Partial evaluation of the greedy policy
+            for (uint32_t i = 0; i < options.evaluationSweeps; ++i)
+            {
+                real_t change = policyBackup(pool, solution.policy, solution.values, nextValues);
+                solution.values.swap(nextValues);
+
+                if (change < options.tolerance)
+                    break;
+            }
+        }
+
+        LOG_DEBUG("ActionMdpSolver::policyIteration: %s after %u improvements (residual %g)\n", solution.converged ? "converged" : "not converged", solution.numIterations, solution.residual);
+
+        return solution;
+    }
+} // namespace rlib
\ No newline at end of file
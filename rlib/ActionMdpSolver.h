@@ -0,0 +1,76 @@
+#ifndef ACTION_MDP_SOLVER_H
+#define ACTION_MDP_SOLVER_H
+
+#include <memory>
+#include <vector>
+
+#include "ActionMdpModel.h"
+#include "ThreadPool.h"
+
+namespace rlib
+{
+    struct ActionMdpSolverOptions
+    {
+        real_t tolerance;               // The iteration stops when the Bellman residual falls below this value
+        uint32_t maxIterations;         // Maximum number of Bellman backups (value iteration) or improvement steps (policy iteration)
+        uint32_t evaluationSweeps;      // Policy evaluation sweeps per improvement step of modified policy iteration
+        unsigned numThreads;            // Number of threads sharing the backups, 0 uses all the available cores
+
+        ActionMdpSolverOptions() : tolerance(1e-9), maxIterations(100000), evaluationSweeps(20), numThreads(0) {}
+    };
+
+    struct ActionMdpSolution
+    {
+        std::vector<real_t> values;     // Optimal expected discounted cost of every state
+        std::vector<uint32_t> policy;   // Optimal action index of every state (see ActionMdpModel::getActionID), kInvalidIndex for terminal states
+        uint32_t numIterations;
+        real_t residual;                // Bellman residual of the returned values
+        bool converged;
+
+        ActionMdpSolution() : numIterations(0), residual(0.0), converged(false) {}
+    };
+
+    /*
+    Computes cost minimizing policies of an ActionMdpModel.
+    Bellman backups are Jacobi style (each sweep reads the previous value vector), so the states can be split across threads
+    and the result does not depend on the number of threads.
+    */
+    class ActionMdpSolver
+    {
+    public:
+        ActionMdpSolver(std::shared_ptr<const ActionMdpModel> model);
+        ~ActionMdpSolver() = default;
+
+        /*
+        Runs value iteration until the Bellman residual is below the tolerance.
+        */
+        ActionMdpSolution valueIteration(const ActionMdpSolverOptions& options = ActionMdpSolverOptions()) const;
+
+        /*
+        Runs modified policy iteration: each step makes the policy greedy with respect to the current values
+        and then evaluates it with a fixed number of sweeps.
+        */
+        ActionMdpSolution policyIteration(const ActionMdpSolverOptions& options = ActionMdpSolverOptions()) const;
+
+    private:
+        /*
+        Computes one Bellman optimality backup of every state into outValues and the greedy policy into outPolicy.
+        Returns:
+        - The largest absolute difference between outValues and values.
+        */
+        real_t bellmanBackup(ThreadPool& pool, const std::vector<real_t>& values, std::vector<real_t>& outValues, std::vector<uint32_t>& outPolicy) const;
+
+        /*
+        Computes one backup of every state under a fixed policy into outValues.
+        Returns:
+        - The largest absolute difference between outValues and values.
+        */
+        real_t policyBackup(ThreadPool& pool, const std::vector<uint32_t>& policy, const std::vector<real_t>& values, std::vector<real_t>& outValues) const;
+
+        real_t actionValue(uint32_t action, const std::vector<real_t>& values) const;
+
+        std::shared_ptr<const ActionMdpModel> m_model;
+    };
+} // namespace rlib
+
+#endif // ACTION_MDP_SOLVER_H
\ No newline at end of file
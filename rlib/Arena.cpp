@@ -0,0 +1,67 @@
+#include "Arena.h"
+
+#include <cstdint>
+#include <cstdlib>
+
+#include "GeneralUtil.h"
+
+namespace rlib
+{
+    const size_t Arena::kDefaultBlockSize;
+
+    void* Arena::allocate(size_t size, size_t alignment)
+    {
+        uintptr_t aligned = (reinterpret_cast<uintptr_t>(m_current) + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+
+        if (m_current == nullptr || aligned + size > reinterpret_cast<uintptr_t>(m_end))
+        {
+            // Oversized requests get a dedicated block
+            size_t blockSize = size + alignment > m_blockSize ? size + alignment : m_blockSize;
+
+            Block block;
+            block.data = static_cast<char*>(malloc(blockSize));
+            block.size = blockSize;
+
+            if (block.data == nullptr)
+                REPORT_PANIC("Arena::allocate: out of memory");
+
+            m_blocks.push_back(block);
+            m_bytesReserved += blockSize;
+
+            m_current = block.data;
+            m_end = block.data + blockSize;
+
+            aligned = (reinterpret_cast<uintptr_t>(m_current) + alignment - 1) & ~(static_cast<uintptr_t>(alignment) - 1);
+        }
+
+        m_current = reinterpret_cast<char*>(aligned + size);
+        m_bytesUsed += size;
+
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    void Arena::release()
+    {
+        for (size_t i = 0; i < m_blocks.size(); ++i)
+            free(m_blocks[i].data);
+
+        m_blocks.clear();
+        m_current = nullptr;
+        m_end = nullptr;
+        m_bytesUsed = 0;
+        m_bytesReserved = 0;
+    }
+
+    bool Arena::owns(const void* ptr) const
+    {
+        const char* p = static_cast<const char*>(ptr);
+
+        for (size_t i = 0; i < m_blocks.size(); ++i)
+        {
+            if (p >= m_blocks[i].data && p < m_blocks[i].data + m_blocks[i].size)
+                return true;
+        }
+
+        return false;
+    }
+} // namespace rlib
\ No newline at end of file
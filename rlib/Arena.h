@@ -0,0 +1,102 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace rlib
+{
+    /*
+    A bump allocator carving objects out of large memory blocks.
+    Allocation is a pointer increment, individual objects are never freed: release() returns all the blocks at once.
+    Objects with non trivial destructors must be destroyed by their owner before the arena is released,
+    unless their destructor only frees memory coming from the same arena.
+    */
+    class Arena
+    {
+    public:
+        static const size_t kDefaultBlockSize = 1024 * 1024;
+
+        Arena(size_t blockSize = kDefaultBlockSize) : m_blockSize(blockSize), m_current(nullptr), m_end(nullptr), m_bytesUsed(0), m_bytesReserved(0) {}
+        ~Arena() { release(); }
+
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+
+        /*
+        Allocates uninitialized memory.
+        Parameters:
+        - size: The number of bytes.
+        - alignment: The required alignment, a power of two.
+        Returns:
+        - A pointer to the allocated memory.
+        */
+        void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+        /*
+        Constructs an object inside the arena.
+        */
+        template <typename T, typename... Args>
+        T* create(Args&&... args) { return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...); }
+
+        /*
+        Frees all the blocks. Every pointer obtained from the arena becomes invalid.
+        */
+        void release();
+
+        /*
+        Checks if a pointer points inside one of the blocks of the arena.
+        */
+        bool owns(const void* ptr) const;
+
+        size_t getBytesUsed() const { return m_bytesUsed; }
+        size_t getBytesReserved() const { return m_bytesReserved; }
+        size_t getNumBlocks() const { return m_blocks.size(); }
+
+    private:
+        struct Block
+        {
+            char* data;
+            size_t size;
+        };
+
+        size_t m_blockSize;
+        std::vector<Block> m_blocks;
+        char* m_current;
+        char* m_end;
+        size_t m_bytesUsed;
+        size_t m_bytesReserved;
+    };
+
+    /*
+    Standard library allocator drawing memory from an Arena. Deallocation is a no-op: the memory is reclaimed by Arena::release().
+    */
+    template <typename T>
+    class ArenaAllocator
+    {
+        template <typename U> friend class ArenaAllocator;
+    public:
+        typedef T value_type;
+
+        ArenaAllocator(Arena* arena) : m_arena(arena) {}
+
+        template <typename U>
+        ArenaAllocator(const ArenaAllocator<U>& other) : m_arena(other.m_arena) {}
+
+        T* allocate(size_t n) { return static_cast<T*>(m_arena->allocate(n * sizeof(T), alignof(T))); }
+        void deallocate(T*, size_t) {}
+
+        template <typename U>
+        bool operator==(const ArenaAllocator<U>& other) const { return m_arena == other.m_arena; }
+
+        template <typename U>
+        bool operator!=(const ArenaAllocator<U>& other) const { return m_arena != other.m_arena; }
+
+    private:
+        Arena* m_arena;
+    };
+} // namespace rlib
+
+#endif // ARENA_H
\ No newline at end of file
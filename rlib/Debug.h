@@ -2,6 +2,7 @@
 #define DEBUG_H
 
 #include "GeneralUtil.h"
+#include <cstring>
 
 #ifdef DEBUG
 #define OUTPUT_DEBUG_MSG(msg, ...) printf(msg, ##__VA_ARGS__);
@@ -9,6 +10,12 @@
 #define OUTPUT_DEBUG_MSG(msg, ...)
 #endif
 
+#ifdef DEBUG
+#define DEBUG_ASSERT(expr, msg) do { if (!(expr)) REPORT_PANIC(msg); } while(0)
+#else
+#define DEBUG_ASSERT(expr, msg)
+#endif
+
 #define TYPE_COL_WIDTH 10
 
 #define PRINT_DEBUG_COLOR(color, type, fmt, ...) \
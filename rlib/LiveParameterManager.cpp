@@ -0,0 +1,236 @@
+#include "LiveParameterManager.h"
+
+#include <cerrno>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include "Debug.h"
+#include "MappedFile.h"
+
+namespace rlib
+{
+    namespace
+    {
+        // Spreads the threads over the reader slots, so that a guard usually gets the slot it had last time
+        std::atomic<size_t> g_nextReaderSlot(0);
+    }
+
+    const size_t LiveParameterManager::kNumReaderSlots;
+
+    LiveParameterManager::LiveParameterManager(const std::string& filename, const TypeRegistration& registerTypes, unsigned numThreads)
+        : m_filename(filename), m_registerTypes(registerTypes), m_numThreads(numThreads), m_current(nullptr), m_inotifyFD(-1)
+    {
+        m_stopPipe[0] = -1;
+        m_stopPipe[1] = -1;
+
+        for (size_t i = 0; i < kNumReaderSlots; ++i)
+        {
+            m_readerSlots[i].hazard.store(nullptr);
+            m_readerSlots[i].isBusy.store(false);
+        }
+
+        Version* version = new Version();
+        version->number = 0;
+        m_registerTypes(version->manager);
+        m_current.store(version);
+    }
+
+    LiveParameterManager::~LiveParameterManager()
+    {
+        stopWatching();
+
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+
+        if (reclaimLocked() > 0)
+            REPORT_PANIC("LiveParameterManager: destroyed while versions are pinned by guards");
+
+        delete m_current.load();
+    }
+
+    LiveParameterManager::ReaderSlot* LiveParameterManager::acquireReaderSlot() const
+    {
+        thread_local size_t preferredSlot = g_nextReaderSlot++ % kNumReaderSlots;
+
+        for (size_t i = preferredSlot; ; i = (i + 1) % kNumReaderSlots)
+        {
+            ReaderSlot& slot = m_readerSlots[i];
+
+            if (!slot.isBusy.load(std::memory_order_relaxed) && !slot.isBusy.exchange(true, std::memory_order_acquire))
+            {
+                preferredSlot = i;
+                return &slot;
+            }
+        }
+    }
+
+    LiveParameterManager::ReadGuard::ReadGuard(const LiveParameterManager& live) : m_slot(live.acquireReaderSlot())
+    {
+        // The hazard is published before the version is checked again: either the writer sees the hazard before destroying
+        // the version, or the guard sees the new version and pins that one instead
+        const Version* version = live.m_current.load();
+
+        for (;;)
+        {
+            m_slot->hazard.store(version);
+
+            const Version* current = live.m_current.load();
+            if (current == version)
+                break;
+
+            version = current;
+        }
+
+        m_version = version;
+    }
+
+    LiveParameterManager::ReadGuard::~ReadGuard()
+    {
+        m_slot->hazard.store(nullptr, std::memory_order_release);
+        m_slot->isBusy.store(false, std::memory_order_release);
+    }
+
+    bool LiveParameterManager::reload()
+    {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+
+        // A file being replaced may be missing for a moment, the current version is then kept
+        MappedFile file;
+        if (!file.open(m_filename))
+            return false;
+
+        std::unique_ptr<Version> version(new Version());
+        version->number = m_current.load()->number + 1;
+        m_registerTypes(version->manager);
+
+        // A file with an unregistered type name is rejected as a whole rather than published in part
+        if (!version->manager.loadFromBuffer(file.getData(), file.getSize(), m_numThreads))
+        {
+            LOG_ERROR("LiveParameterManager::reload: file '%s' has an unknown parameter type, version %llu is kept\n", m_filename.c_str(),
+                static_cast<unsigned long long>(version->number - 1));
+            return false;
+        }
+
+        m_retired.push_back(m_current.exchange(version.get()));
+        reclaimLocked();
+
+        LOG_DEBUG("Published version %llu of file '%s' with %zu parameters\n", static_cast<unsigned long long>(version->number), m_filename.c_str(),
+            version->manager.getNumParameters());
+
+        version.release();
+
+        return true;
+    }
+
+    size_t LiveParameterManager::reclaim()
+    {
+        std::lock_guard<std::mutex> lock(m_writeMutex);
+        return reclaimLocked();
+    }
+
+    size_t LiveParameterManager::reclaimLocked()
+    {
+        size_t numPinned = 0;
+
+        for (size_t r = 0; r < m_retired.size(); ++r)
+        {
+            bool isPinned = false;
+            for (size_t i = 0; i < kNumReaderSlots && !isPinned; ++i)
+                isPinned = m_readerSlots[i].hazard.load() == m_retired[r];
+
+            if (isPinned)
+                m_retired[numPinned++] = m_retired[r];
+            else
+                delete m_retired[r];
+        }
+
+        m_retired.resize(numPinned);
+
+        return numPinned;
+    }
+
+    bool LiveParameterManager::startWatching()
+    {
+        if (isWatching())
+            return true;
+
+        // Editors and deployment tools often replace the file with a rename, so the directory is watched rather than the file
+        const size_t separator = m_filename.find_last_of('/');
+        const std::string directory = separator == std::string::npos ? "." : (separator == 0 ? "/" : m_filename.substr(0, separator));
+        const std::string watchedName = separator == std::string::npos ? m_filename : m_filename.substr(separator + 1);
+
+        m_inotifyFD = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (m_inotifyFD < 0 || inotify_add_watch(m_inotifyFD, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0 || pipe(m_stopPipe) != 0)
+        {
+            LOG_ERROR("LiveParameterManager::startWatching: failed to watch directory '%s'\n", directory.c_str());
+            stopWatching();
+            return false;
+        }
+
+        m_watchThread = std::thread(&LiveParameterManager::watchLoop, this, watchedName);
+
+        return true;
+    }
+
+    void LiveParameterManager::stopWatching()
+    {
+        if (m_watchThread.joinable())
+        {
+            const char stop = 1;
+            if (write(m_stopPipe[1], &stop, 1) != 1)
+                REPORT_PANIC("LiveParameterManager::stopWatching: failed to signal the watch thread");
+
+            m_watchThread.join();
+        }
+
+        for (int* fd : { &m_inotifyFD, &m_stopPipe[0], &m_stopPipe[1] })
+        {
+            if (*fd >= 0)
+                close(*fd);
+
+            *fd = -1;
+        }
+    }
+
+    void LiveParameterManager::watchLoop(std::string watchedName)
+    {
+        alignas(struct inotify_event) char buffer[4096];
+
+        for (;;)
+        {
+            struct pollfd fds[2] = { { m_inotifyFD, POLLIN, 0 }, { m_stopPipe[0], POLLIN, 0 } };
+
+            if (poll(fds, 2, -1) < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+
+                LOG_ERROR("LiveParameterManager: stopped watching file '%s' after a poll error\n", m_filename.c_str());
+                return;
+            }
+
+            if (fds[1].revents != 0)
+                return;
+
+            // Drains every pending event, a burst of writes to the file triggers a single reload
+            bool isChanged = false;
+            ssize_t size;
+
+            while ((size = read(m_inotifyFD, buffer, sizeof(buffer))) > 0)
+            {
+                for (char* p = buffer; p < buffer + size; )
+                {
+                    const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(p);
+
+                    if (event->len > 0 && watchedName == event->name)
+                        isChanged = true;
+
+                    p += sizeof(struct inotify_event) + event->len;
+                }
+            }
+
+            if (isChanged)
+                reload();
+        }
+    }
+} // namespace rlib
\ No newline at end of file
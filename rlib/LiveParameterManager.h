@@ -0,0 +1,159 @@
+#ifndef LIVE_PARAMETER_MANAGER_H
+#define LIVE_PARAMETER_MANAGER_H
+
+#include "ParameterManager.h"
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace rlib
+{
+    /*
+    Parameters of a configuration file that can be reloaded while many threads read them, for long running services.
+    Every load produces a new immutable ParameterManager, the version, which is published with an atomic pointer swap.
+    Readers pin the current version with a ReadGuard: they never take a lock and never see a partially loaded file, and a
+    version stays alive as long as a guard pins it. Retired versions are reclaimed once no guard points to them, with one
+    hazard pointer per concurrent guard.
+    The file can be watched with inotify: a background thread reloads it whenever it is rewritten or replaced.
+    */
+    class LiveParameterManager
+    {
+        struct Version;
+        struct ReaderSlot;
+
+    public:
+        /*
+        Registers the parameter types of a version before its file is parsed.
+        */
+        typedef std::function<void(ParameterManager&)> TypeRegistration;
+
+        /*
+        Maximum number of guards alive at the same time. A guard waits for a free slot beyond that number.
+        */
+        static const size_t kNumReaderSlots = 128;
+
+        /*
+        Creates the manager with an empty version 0. Nothing is loaded before the first call to reload().
+        Parameters:
+        - filename: The path to the configuration file.
+        - registerTypes: Registers the parameter types in every new version.
+        - numThreads: The number of threads parsing the file, see ParameterManager::loadFromFile().
+        */
+        LiveParameterManager(const std::string& filename, const TypeRegistration& registerTypes, unsigned numThreads = 1);
+
+        /*
+        Stops watching the file and destroys every version. No guard may be alive.
+        */
+        ~LiveParameterManager();
+
+        LiveParameterManager(const LiveParameterManager&) = delete;
+        LiveParameterManager& operator=(const LiveParameterManager&) = delete;
+
+        /*
+        Pins the current version for the lifetime of the guard. The version is read through the const accessors, preferably
+        handles, typed getters and typed handles, which may be bound to the pinned version and read while it is pinned.
+        getParameter() creates its views under a lock and is slower, and changing the value of a view is not safe while other
+        threads read the same version.
+        */
+        class ReadGuard
+        {
+        public:
+            explicit ReadGuard(const LiveParameterManager& live);
+            ~ReadGuard();
+
+            ReadGuard(const ReadGuard&) = delete;
+            ReadGuard& operator=(const ReadGuard&) = delete;
+
+            const ParameterManager& operator*() const { return m_version->manager; }
+            const ParameterManager* operator->() const { return &m_version->manager; }
+
+            /*
+            Gets the number of the pinned version, incremented by every successful reload.
+            */
+            uint64_t getVersion() const { return m_version->number; }
+
+        private:
+            ReaderSlot* m_slot;
+            const Version* m_version;
+        };
+
+        /*
+        Parses the file into a new version in the calling thread and publishes it. Calls are serialized, the readers are
+        not blocked.
+        Returns:
+        - true if the new version was published, false if the file could not be read or has an unknown parameter type and the
+          current version was kept.
+        */
+        bool reload();
+
+        /*
+        Starts a background thread reloading the file whenever it is closed after writing or moved in place.
+        Returns:
+        - true if the file is watched, false if the watch could not be set up.
+        */
+        bool startWatching();
+
+        /*
+        Stops the background thread, if any. A reload in progress is completed first.
+        */
+        void stopWatching();
+
+        bool isWatching() const { return m_watchThread.joinable(); }
+
+        /*
+        Gets the number of the current version.
+        */
+        uint64_t getVersion() const { return m_current.load()->number; }
+
+        /*
+        Destroys the retired versions that are no longer pinned by a guard. Also done by every reload.
+        Returns:
+        - The number of retired versions still pinned.
+        */
+        size_t reclaim();
+
+    private:
+        struct Version
+        {
+            ParameterManager manager;
+            uint64_t number;
+        };
+
+        // One slot per guard alive, padded to a cache line so that the readers do not share lines
+        struct ReaderSlot
+        {
+            std::atomic<const Version*> hazard;
+            std::atomic<bool> isBusy;
+            char padding[64 - sizeof(std::atomic<const Version*>) - sizeof(std::atomic<bool>)];
+        };
+
+        std::string m_filename;
+        TypeRegistration m_registerTypes;
+        unsigned m_numThreads;
+
+        std::atomic<Version*> m_current;
+        mutable ReaderSlot m_readerSlots[kNumReaderSlots];
+
+        // Writer side, guarded by m_writeMutex
+        std::mutex m_writeMutex;
+        std::vector<Version*> m_retired;
+
+        std::thread m_watchThread;
+        int m_inotifyFD;
+        int m_stopPipe[2];
+
+        ReaderSlot* acquireReaderSlot() const;
+
+        /*
+        Destroys the unpinned retired versions. m_writeMutex must be held.
+        */
+        size_t reclaimLocked();
+
+        void watchLoop(std::string watchedName);
+    };
+} // namespace rlib
+
+#endif // LIVE_PARAMETER_MANAGER_H
\ No newline at end of file
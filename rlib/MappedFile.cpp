@@ -0,0 +1,75 @@
+#include "MappedFile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Debug.h"
+
+namespace rlib
+{
+    const char MappedFile::kEmptyData[1] = { '\0' };
+
+    bool MappedFile::open(const std::string& filename)
+    {
+        close();
+
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0)
+        {
+            LOG_ERROR("MappedFile::open: failed to open file '%s'\n", filename.c_str());
+            return false;
+        }
+
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size < 0)
+        {
+            LOG_ERROR("MappedFile::open: file '%s' cannot be read\n", filename.c_str());
+            ::close(fd);
+            return false;
+        }
+
+        // An empty file cannot be mapped, it is open with no data
+        if (info.st_size == 0)
+        {
+            ::close(fd);
+
+            m_data = kEmptyData;
+            m_size = 0;
+
+            return true;
+        }
+
+        void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+
+        // The mapping keeps its own reference to the file
+        ::close(fd);
+
+        if (data == MAP_FAILED)
+        {
+            LOG_ERROR("MappedFile::open: failed to map file '%s'\n", filename.c_str());
+            return false;
+        }
+
+        // Start reading the pages ahead instead of faulting them in one by one
+        madvise(data, static_cast<size_t>(info.st_size), MADV_WILLNEED);
+
+        m_data = static_cast<const char*>(data);
+        m_size = static_cast<size_t>(info.st_size);
+
+        return true;
+    }
+
+    void MappedFile::close()
+    {
+        if (m_data == nullptr)
+            return;
+
+        if (m_size > 0)
+            munmap(const_cast<char*>(m_data), m_size);
+
+        m_data = nullptr;
+        m_size = 0;
+    }
+} // namespace rlib
\ No newline at end of file
@@ -0,0 +1,50 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+namespace rlib
+{
+    /*
+    A read only memory mapping of a whole file. The pages are loaded lazily by the operating system,
+    so opening a file costs a system call regardless of its size.
+    */
+    class MappedFile
+    {
+    public:
+        MappedFile() : m_data(nullptr), m_size(0) {}
+        ~MappedFile() { close(); }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        /*
+        Maps a file into memory, closing the previous mapping if any. An empty file is open with a size of 0.
+        Parameters:
+        - filename: The path to the file.
+        Returns:
+        - true if the file was mapped, false otherwise.
+        */
+        bool open(const std::string& filename);
+
+        /*
+        Unmaps the file. Every pointer obtained from getData() becomes invalid.
+        */
+        void close();
+
+        bool isOpen() const { return m_data != nullptr; }
+
+        const char* getData() const { return m_data; }
+        size_t getSize() const { return m_size; }
+
+    private:
+        // Data of the open empty files, which have no mapping
+        static const char kEmptyData[1];
+
+        const char* m_data;
+        size_t m_size;
+    };
+} // namespace rlib
+
+#endif // MAPPED_FILE_H
\ No newline at end of file
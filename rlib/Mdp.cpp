@@ -4,12 +4,18 @@
 #include "Debug.h"
 #include "GeneralUtil.h"
 
+#include <algorithm>
+
 namespace rlib
 {
     MDP::State::~State()
     {
+        // Arena transitions are trivially destructible and released with the arena
         for (size_t i = 0; i < m_transitions.size(); ++i)
-            delete m_transitions[i];
+        {
+            if (!m_owner->m_arena.owns(m_transitions[i]))
+                delete m_transitions[i];
+        }
         
         m_transitions.clear();
     }
@@ -24,15 +30,42 @@ namespace rlib
 
     MDP::StateTransition* MDP::State::getTransitionToState(uint32_t nextStateID)
     {
-        for (size_t i = 0; i < m_transitions.size(); ++i)
+        auto it = std::lower_bound(m_transitions.begin(), m_transitions.end(), nextStateID, [](const StateTransition* transition, uint32_t id)
         {
-            if (m_transitions[i]->getNextStateID() == nextStateID)
-                return m_transitions[i];
-        }
+            return transition->getNextStateID() < id;
+        });
+
+        if (it != m_transitions.end() && (*it)->getNextStateID() == nextStateID)
+            return *it;
 
         return nullptr;
     }
 
+    void MDP::State::addTransition(StateTransition* transition)
+    {
+        insertTransition(transition);
+        m_owner->m_numHeapObjects++;
+    }
+
+    MDP::StateTransition* MDP::State::createTransition(uint32_t id, uint32_t nextStateID, real_t prob, real_t cost)
+    {
+        StateTransition* transition = m_owner->m_arena.create<StateTransition>(id, nextStateID, prob, cost);
+        insertTransition(transition);
+
+        return transition;
+    }
+
+    void MDP::State::insertTransition(StateTransition* transition)
+    {
+        auto it = std::upper_bound(m_transitions.begin(), m_transitions.end(), transition->getNextStateID(), [](uint32_t id, const StateTransition* other)
+        {
+            return id < other->getNextStateID();
+        });
+
+        m_transitions.insert(it, transition);
+        m_owner->m_isSealed = false;
+    }
+
     bool MDP::State::isTerminal() const
     {
         bool hasTransitionsToOtherStates = false;
@@ -51,27 +84,7 @@ namespace rlib
     
     void MDP::State::update() const
     {
-        if (!areTransitionsValid())
-            REPORT_PANIC("MDP::State::update: transition probabilities do not add up to 1.0");
-      
-        real_t randValue = DefaultRng::getInstance()->getRandomReal(0.f, 1.f);
-        real_t cumulativeProb = 0.f;
-
-        for (size_t i = 0; i < m_transitions.size(); ++i)
-        {
-            cumulativeProb += m_transitions[i]->getTransitProbability();
-
-            if (randValue <= cumulativeProb)
-            {
-                m_owner->m_totalCost += m_transitions[i]->getCost();
-                m_owner->m_currentState = m_transitions[i]->getNextStateID();
-
-                LOG_DEBUG("MDP transitioning from state %u to state %u with cost %.3f\n", m_id, m_transitions[i]->getNextStateID(), m_transitions[i]->getCost());
-                return;
-            }
-        }
-
-        REPORT_PANIC("MDP::State::update: failed to determine next state for transition");
+        update(getThreadRng());
     }
 
     bool MDP::State::areTransitionsValid() const
@@ -84,12 +97,13 @@ namespace rlib
         return ARE_REALS_EQUAL(totalProb, 1.f);
     }
 
-    MDP::MDP(int numStates)
+    MDP::MDP(int numStates) : m_numHeapObjects(0), m_totalCost(0.0), m_model(std::make_shared<MdpModel>()), m_samplingMode(MdpSamplingMode::kSamplingLinear), m_isSealed(false)
     {
         m_states.reserve(numStates);
+        m_stateIndexById.reserve(numStates);
 
         for (int i = 0; i < numStates; i++)
-            m_states.push_back(new State(this, i));
+            createState(i);
 
         m_currentState = 0;
     }
@@ -101,15 +115,39 @@ namespace rlib
 
     MDP::State* MDP::getState(const uint32_t id)
     {
-        for (size_t i = 0; i < m_states.size(); i++)
-        {
-            if (m_states[i]->getId() == id)
-                return m_states[i];
-        }
+        auto it = m_stateIndexById.find(id);
+        if (it != m_stateIndexById.end())
+            return m_states[it->second];
 
         REPORT_PANIC("MDP::getState: state ID not found");
     }
 
+    MDP::State* MDP::createState(uint32_t id)
+    {
+        State* state = m_arena.create<State>(this, id);
+        insertState(state);
+
+        return state;
+    }
+
+    void MDP::addState(State* state)
+    {
+        insertState(state);
+        m_numHeapObjects++;
+    }
+
+    void MDP::insertState(State* state)
+    {
+        const uint32_t index = static_cast<uint32_t>(m_states.size());
+
+        if (!m_stateIndexById.emplace(state->getId(), index).second)
+            REPORT_PANIC("MDP::insertState: duplicate state ID " + std::to_string(state->getId()));
+
+        state->m_index = index;
+        m_states.push_back(state);
+        m_isSealed = false;
+    }
+
     MDP::State* MDP::getStateAt(const uint32_t index)
     {
         if (index < static_cast<uint32_t>(m_states.size()))
@@ -128,26 +166,100 @@ namespace rlib
 
     void MDP::initialize()
     {
+        seal();
         reset();
     }
 
+    void MDP::seal()
+    {
+        const uint32_t numStates = static_cast<uint32_t>(m_states.size());
+        size_t numTransitions = 0;
+
+        for (uint32_t i = 0; i < numStates; i++)
+            numTransitions += m_states[i]->getNumTransitions();
+
+        // Models handed out by getSharedModel() are immutable, a new one is built instead of clearing the current one
+        std::shared_ptr<MdpModel> model = std::make_shared<MdpModel>();
+        model->setSamplingMode(m_samplingMode);
+        model->reserve(numStates, numTransitions);
+
+        for (uint32_t i = 0; i < numStates; i++)
+        {
+            const State* state = m_states[i];
+
+            model->addState();
+
+            for (size_t j = 0; j < state->m_transitions.size(); j++)
+            {
+                const StateTransition* transition = state->m_transitions[j];
+
+                auto it = m_stateIndexById.find(transition->getNextStateID());
+                if (it == m_stateIndexById.end())
+                    REPORT_PANIC("MDP::seal: transition to unknown state ID " + std::to_string(transition->getNextStateID()));
+
+                model->addTransition(it->second, transition->getTransitProbability(), transition->getCost());
+            }
+        }
+
+        std::vector<uint32_t> invalidStates;
+        if (!model->validate(&invalidStates))
+        {
+            for (size_t i = 0; i < invalidStates.size(); i++)
+                LOG_ERROR("MDP::seal: transition probabilities of state %u do not add up to 1.0\n", m_states[invalidStates[i]]->getId());
+
+            REPORT_PANIC("MDP::seal: " + std::to_string(invalidStates.size()) + " state(s) with invalid transition probabilities");
+        }
+
+        model->compile();
+        m_model = model;
+        m_isSealed = true;
+    }
+
+    std::shared_ptr<const MdpModel> MDP::getSharedModel()
+    {
+        if (!m_isSealed)
+            seal();
+
+        return m_model;
+    }
+
     void MDP::finalize()
     {
-        for (size_t i = 0; i < getNumStates(); i++)
-            delete m_states[i];
+        // Only heap allocated states and transitions need to be visited, arena objects go away with the arena
+        if (m_numHeapObjects > 0)
+        {
+            for (size_t i = 0; i < getNumStates(); i++)
+            {
+                if (m_arena.owns(m_states[i]))
+                    m_states[i]->~State();
+                else
+                    delete m_states[i];
+            }
+        }
         
         m_states.clear();
+        m_arena.release();
+        m_numHeapObjects = 0;
+        m_stateIndexById.clear();
+        m_model = std::make_shared<MdpModel>();
+        m_isSealed = false;
 
         reset();
     }
 
     void MDP::update()
     {
-        if (m_states.empty()) return;
+        update(getThreadRng());
+    }
+
+    bool MDP::isTerminal()
+    {
+        if (!m_isSealed)
+            seal();
 
-        State* currentState = getCurrentState();
+        DEBUG_ASSERT(m_currentState < m_model->getNumStates(), "MDP::isTerminal: current state index out of range");
 
-        currentState->update();
+        return m_model->isTerminal(m_currentState);
     }
 
     void MDP::reset()
@@ -3,6 +3,13 @@
 
 #include "../mocc/mocc.hpp"
 #include "Parameter.h"
+#include "MdpModel.h"
+#include "Arena.h"
+#include "Rng.h"
+#include "Debug.h"
+
+#include <unordered_map>
+#include <memory>
 
 namespace rlib
 {
@@ -29,34 +36,98 @@ namespace rlib
 
         class State
         {
+            friend class MDP;
         private:
+            typedef std::vector<StateTransition*, ArenaAllocator<StateTransition*>> TransitionList;
+
             MDP* m_owner;
             uint32_t m_id;
-            std::vector<StateTransition*> m_transitions;
+            uint32_t m_index;
+            TransitionList m_transitions;
+
+            void insertTransition(StateTransition* transition);
         public:
-            State(MDP* owner, uint32_t id) : m_owner(owner), m_id(id) {}
+            State(MDP* owner, uint32_t id) : m_owner(owner), m_id(id), m_index(MdpModel::kInvalidIndex), m_transitions(ArenaAllocator<StateTransition*>(&owner->m_arena)) {}
             ~State();
 
             uint32_t getId() const { return m_id; }
             
             size_t getNumTransitions() const { return m_transitions.size(); }
             StateTransition* getTransition(size_t index);
+            /*
+            Returns the transition to the given next state, or nullptr if there is none. Transitions are kept sorted by
+            next state ID, so the lookup is a binary search.
+            */
             StateTransition* getTransitionToState(uint32_t nextStateID);
 
-            void addTransition(StateTransition* transition) { m_transitions.push_back(transition); }
+            /*
+            Adds a heap allocated transition, keeping the transitions sorted by next state ID (transitions to the same state keep their insertion order).
+            The state takes ownership of the transition.
+            */
+            void addTransition(StateTransition* transition);
+
+            /*
+            Creates a transition inside the arena of the owning MDP and adds it to the state.
+            Returns:
+            - A pointer to the new transition, owned by the MDP.
+            */
+            StateTransition* createTransition(uint32_t id, uint32_t nextStateID, real_t prob, real_t cost);
 
             bool isTerminal() const;
+
+            /*
+            Moves the owning MDP to the next state using the generator of the calling thread.
+            */
             void update() const;
 
+            /*
+            Moves the owning MDP to the next state. The generator type is a template parameter, so that a concrete generator
+            (e.g. Xoshiro256PlusPlus) is inlined into the transition scan; an RngBase goes through the virtual interface.
+            */
+            template <typename Generator>
+            void update(Generator& rng) const
+            {
+                DEBUG_ASSERT(areTransitionsValid(), "MDP::State::update: transition probabilities do not add up to 1.0");
+
+                real_t randValue = drawUniformReal(rng);
+                real_t cumulativeProb = 0.0;
+
+                for (size_t i = 0; i < m_transitions.size(); ++i)
+                {
+                    cumulativeProb += m_transitions[i]->getTransitProbability();
+
+                    if (randValue <= cumulativeProb)
+                    {
+                        m_owner->m_totalCost += m_transitions[i]->getCost();
+                        m_owner->m_currentState = m_transitions[i]->getNextStateID();
+
+                        LOG_DEBUG("MDP transitioning from state %u to state %u with cost %.3f\n", m_id, m_transitions[i]->getNextStateID(), m_transitions[i]->getCost());
+                        return;
+                    }
+                }
+
+                REPORT_PANIC("MDP::State::update: failed to determine next state for transition");
+            }
+
             bool areTransitionsValid() const;
         };
 
     protected:
+        Arena m_arena;
+        size_t m_numHeapObjects;
+
         std::vector<State*> m_states;
         uint32_t m_currentState;
         real_t m_totalCost;
+
+        std::shared_ptr<MdpModel> m_model;
+        std::unordered_map<uint32_t, uint32_t> m_stateIndexById;
+        MdpSamplingMode m_samplingMode;
+        bool m_isSealed;
+
+        void insertState(State* state);
     public:
-        MDP() : m_currentState(-1), m_totalCost(0.0) {}
+        MDP() : m_numHeapObjects(0), m_currentState(-1), m_totalCost(0.0), m_model(std::make_shared<MdpModel>()), m_samplingMode(MdpSamplingMode::kSamplingLinear), m_isSealed(false) {}
         MDP(int numStates);
 
         ~MDP();
@@ -67,17 +138,55 @@ namespace rlib
         void initialize();
 
         /*
-        Finalizes the MDP.
+        Finalizes the MDP, destroying all its states and transitions.
+        When all of them come from the arena, the memory is released in one go without visiting them.
         */
         void finalize();
 
         /*
-        Updates the MDP by transitioning to the next state based on transition probabilities.
+        Compiles the states and transitions into the contiguous MdpModel used by update() and isTerminal().
+        The transition probabilities of all the states are validated once here: every invalid state is logged and the call panics,
+        so that the per-step hot path does not need to check them again (DEBUG builds still do).
+        Adding states or transitions afterwards unseals the MDP, which is sealed again on the next update.
+        */
+        void seal();
+
+        /*
+        Updates the MDP by transitioning to the next state based on transition probabilities,
+        using the generator of the calling thread.
         */
         void update();
 
         /*
-        Returns a pointer to the state with the given ID.
+        Same as update(), drawing from the given generator. With a concrete generator type (e.g. Xoshiro256PlusPlus or XoshiroRng)
+        the draw is inlined into the step; an RngBase reference goes through the virtual interface.
+        Parameters:
+        - rng: The random number generator.
+        */
+        template <typename Generator>
+        void update(Generator& rng)
+        {
+            if (m_states.empty()) return;
+
+            if (!m_isSealed)
+                seal();
+
+            DEBUG_ASSERT(m_currentState < m_model->getNumStates(), "MDP::update: current state index out of range");
+            DEBUG_ASSERT(m_model->isValidated(), "MDP::update: model has not been validated");
+
+            uint32_t transition = m_model->sampleTransition(m_currentState, drawUniformReal(rng));
+
+            if (transition == MdpModel::kInvalidIndex)
+                REPORT_PANIC("MDP::update: failed to determine next state for transition");
+
+            LOG_DEBUG("MDP transitioning from state %u to state %u with cost %.3f\n", m_currentState, m_model->getNextState(transition), m_model->getCost(transition));
+
+            m_totalCost += m_model->getCost(transition);
+            m_currentState = m_model->getNextState(transition);
+        }
+
+        /*
+        Returns a pointer to the state with the given ID. States are indexed by ID, so the lookup is O(1).
         Parameters:
         - id: The ID of the state to retrieve.
         Returns:
@@ -102,20 +211,51 @@ namespace rlib
         size_t getNumStates() const { return m_states.size(); }
         uint32_t getCurrentStateIndex() const { return m_currentState; }
         real_t getTotalCost() const { return m_totalCost; }
+        bool isSealed() const { return m_isSealed; }
 
         /*
-        Adds a new state to the MDP.
+        Selects the algorithm used to sample the next state. Takes effect the next time the MDP is sealed.
+        Parameters:
+        - mode: The sampling mode, kSamplingLinear by default.
+        */
+        void setSamplingMode(MdpSamplingMode mode) { m_samplingMode = mode; m_isSealed = false; }
+        const MdpModel& getModel() const { return *m_model; }
+
+        /*
+        Returns the compiled model, sealing the MDP first if needed. The returned model is immutable: sealing the MDP again
+        builds a new model, so the returned one can be safely shared by any number of MdpRunner objects on any thread.
+        */
+        std::shared_ptr<const MdpModel> getSharedModel();
+
+        /*
+        Adds a new heap allocated state to the MDP. The MDP takes ownership of the state.
         Parameters:
         - state: The state to be added.
         */
-        void addState(State* state) { m_states.push_back(state); }
+        void addState(State* state);
+
+        /*
+        Creates a new state inside the arena of the MDP and adds it to the MDP.
+        States and transitions created through createState() and State::createTransition() are carved out of large blocks,
+        so that building a model performs few allocations and finalize() releases them all at once.
+        Parameters:
+        - id: The ID of the state.
+        Returns:
+        - A pointer to the new state, owned by the MDP.
+        */
+        State* createState(uint32_t id);
+
+        /*
+        Returns the arena holding the states and transitions created by createState() and State::createTransition().
+        */
+        const Arena& getArena() const { return m_arena; }
 
         /*
         Checks if the current state is terminal.
         Returns:
         - true if the current state is terminal, false otherwise.
         */
-        bool isTerminal() { return getCurrentState()->isTerminal(); }
+        bool isTerminal();
 
         /*
         Resets the MDP to its initial state.
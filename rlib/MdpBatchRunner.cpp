@@ -0,0 +1,127 @@
+#include "MdpBatchRunner.h"
+
+#include <algorithm>
+
+#include "GeneralUtil.h"
+
+namespace rlib
+{
+    MdpBatchRunner::MdpBatchRunner(std::shared_ptr<const MdpModel> model, size_t numChains, uint64_t seed, uint32_t initialState)
+        : m_model(model), m_seed(seed), m_step(0), m_initialState(initialState), m_numActiveChains(0)
+    {
+        if (m_model == nullptr || !m_model->isValidated() || !m_model->isCompiled())
+            REPORT_PANIC("MdpBatchRunner::MdpBatchRunner: the model must be compiled and validated");
+
+        if (initialState >= m_model->getNumStates())
+            REPORT_PANIC("MdpBatchRunner::MdpBatchRunner: initial state index out of range");
+
+        m_states.resize(numChains);
+        m_totalCosts.resize(numChains);
+        m_numSteps.resize(numChains);
+        m_uniforms.resize(numChains);
+        m_nextUniforms.resize(numChains);
+
+        reset();
+    }
+
+    void MdpBatchRunner::reset()
+    {
+        std::fill(m_states.begin(), m_states.end(), m_initialState);
+        std::fill(m_totalCosts.begin(), m_totalCosts.end(), 0.0);
+        std::fill(m_numSteps.begin(), m_numSteps.end(), 0);
+        m_step = 0;
+
+        m_numActiveChains = m_model->isTerminal(m_initialState) ? 0 : m_states.size();
+    }
+
+    void MdpBatchRunner::update()
+    {
+        if (m_numActiveChains == 0)
+            return;
+
+        // Every Philox block holds the numbers of two consecutive steps of a chain. Terminal chains never move again, so their
+        // numbers are not computed
+        if ((m_step & 1) == 0)
+        {
+            const uint64_t block = m_step >> 1;
+
+            for (size_t i = 0; i < m_states.size(); ++i)
+            {
+                if (m_model->isTerminal(m_states[i]))
+                    continue;
+
+                uint64_t output[2];
+                Philox4x32::blockAt(m_seed, i, block, output);
+
+                m_uniforms[i] = uniformRealFromBits(output[0]);
+                m_nextUniforms[i] = uniformRealFromBits(output[1]);
+            }
+        }
+        else
+        {
+            m_uniforms.swap(m_nextUniforms);
+        }
+
+        m_step++;
+
+        const MdpModel& model = *m_model;
+
+        // The sampling mode is dispatched once per step instead of once per chain
+        switch (model.getSamplingMode())
+        {
+        case MdpSamplingMode::kSamplingCumulative:
+            m_numActiveChains = advance([&model](uint32_t state, real_t u) { return model.sampleTransitionCumulative(state, u); });
+            break;
+        case MdpSamplingMode::kSamplingAlias:
+            m_numActiveChains = advance([&model](uint32_t state, real_t u) { return model.sampleTransitionAliasBranchless(state, u); });
+            break;
+        default:
+            m_numActiveChains = advance([&model](uint32_t state, real_t u) { return model.sampleTransitionLinear(state, u); });
+            break;
+        }
+    }
+
+    template <typename Sampler>
+    size_t MdpBatchRunner::advance(Sampler sampler)
+    {
+        const MdpModel& model = *m_model;
+        const size_t numChains = m_states.size();
+
+        uint32_t* states = m_states.data();
+        real_t* totalCosts = m_totalCosts.data();
+        uint32_t* numSteps = m_numSteps.data();
+        const real_t* uniforms = m_uniforms.data();
+
+        size_t numActive = 0;
+
+        for (size_t i = 0; i < numChains; ++i)
+        {
+            const uint32_t state = states[i];
+
+            if (model.isTerminal(state))
+                continue;
+
+            // Non terminal states always have at least one transition, so the sample is always valid
+            const uint32_t t = sampler(state, uniforms[i]);
+            const uint32_t next = model.getNextState(t);
+
+            totalCosts[i] += model.getCost(t);
+            states[i] = next;
+            numSteps[i]++;
+
+            numActive += model.isTerminal(next) ? 0 : 1;
+        }
+
+        return numActive;
+    }
+
+    uint32_t MdpBatchRunner::run(uint32_t maxSteps)
+    {
+        uint32_t numSteps = 0;
+
+        for (; numSteps < maxSteps && m_numActiveChains > 0; ++numSteps)
+            update();
+
+        return numSteps;
+    }
+} // namespace rlib
\ No newline at end of file
@@ -0,0 +1,83 @@
+#ifndef MDP_BATCH_RUNNER_H
+#define MDP_BATCH_RUNNER_H
+
+#include <memory>
+#include <vector>
+
+#include "MdpModel.h"
+#include "Rng.h"
+
+namespace rlib
+{
+    /*
+    Simulates many independent chains in lock step over a shared, immutable MdpModel.
+    The chains are stored as structure of arrays (current states, accumulated costs, step counts), and every call to update()
+    draws one block of random numbers and advances all the chains with tight loops over these arrays,
+    instead of paying a virtual generator call and a sampling mode dispatch per chain and step as MdpRunner does.
+    Chains that reach a terminal state stay there and stop accumulating steps and costs.
+    The random number of chain i at step k is the value at position k of the stream i of a Philox generator keyed by the seed,
+    so the trajectory of a chain does not depend on the number of chains and matches an MdpRolloutEngine trajectory with the same seed.
+    */
+    class MdpBatchRunner
+    {
+    public:
+        /*
+        Creates the chains, all positioned on the initial state.
+        Parameters:
+        - model: The compiled and validated model to simulate.
+        - numChains: The number of chains.
+        - seed: The key of the counter based generator, every chain draws from its own stream.
+        - initialState: The index of the initial state of every chain.
+        */
+        MdpBatchRunner(std::shared_ptr<const MdpModel> model, size_t numChains, uint64_t seed, uint32_t initialState = 0);
+        ~MdpBatchRunner() = default;
+
+        /*
+        Advances every chain that has not reached a terminal state by one step.
+        */
+        void update();
+
+        /*
+        Calls update() until every chain reached a terminal state or maxSteps steps have been taken.
+        Returns:
+        - The number of steps taken.
+        */
+        uint32_t run(uint32_t maxSteps);
+
+        /*
+        Moves all the chains back to the initial state and clears their costs and step counts. The chains then replay the same trajectories.
+        */
+        void reset();
+
+        size_t getNumChains() const { return m_states.size(); }
+
+        /*
+        Returns the number of chains that have not reached a terminal state yet.
+        */
+        size_t getNumActiveChains() const { return m_numActiveChains; }
+
+        const std::vector<uint32_t>& getStates() const { return m_states; }
+        const std::vector<real_t>& getTotalCosts() const { return m_totalCosts; }
+        const std::vector<uint32_t>& getNumSteps() const { return m_numSteps; }
+
+        const MdpModel& getModel() const { return *m_model; }
+
+    private:
+        std::shared_ptr<const MdpModel> m_model;
+        uint64_t m_seed;
+        uint64_t m_step;
+        uint32_t m_initialState;
+        size_t m_numActiveChains;
+
+        std::vector<uint32_t> m_states;
+        std::vector<real_t> m_totalCosts;
+        std::vector<uint32_t> m_numSteps;
+        std::vector<real_t> m_uniforms;
+        std::vector<real_t> m_nextUniforms;     // Second half of the last Philox blocks, used by the odd steps
+
+        template <typename Sampler>
+        size_t advance(Sampler sampler);
+    };
+} // namespace rlib
+
+#endif // MDP_BATCH_RUNNER_H
\ No newline at end of file
@@ -0,0 +1,578 @@
+#include "MdpModel.h"
+
+#include "Debug.h"
+#include "MappedFile.h"
+
+#include <algorithm>
+#include <fstream>
+
+namespace rlib
+{
+    namespace
+    {
+        const char kFileMagic[8] = { 'R', 'L', 'I', 'B', 'M', 'D', 'P', '\0' };
+        const uint32_t kFileVersion = 1;
+        const uint32_t kByteOrderMark = 0x01020304;
+
+        // Sections are aligned to cache lines, which also satisfies the alignment of every array type
+        const uint64_t kSectionAlignment = 64;
+
+        enum FileSection
+        {
+            kSectionRowOffsets,
+            kSectionNextStates,
+            kSectionProbabilities,
+            kSectionCosts,
+            kSectionTerminal,
+            kSectionCumulative,
+            kSectionAliasThreshold,
+            kSectionAliasIndex,
+            kNumSections
+        };
+
+        /*
+        Layout of the binary model file: this header followed by the arrays, each one starting at its section offset.
+        Absent sections (the sampling tables of the other modes) have offset 0.
+        */
+        struct FileHeader
+        {
+            char magic[8];
+            uint32_t version;
+            uint32_t byteOrderMark;
+            uint32_t realSize;
+            uint32_t samplingMode;
+            uint64_t numStates;
+            uint64_t numTransitions;
+            uint64_t sectionOffsets[kNumSections];
+            uint64_t sectionSizes[kNumSections];
+        };
+
+        /*
+        Returns a pointer to a section of a mapped file, or nullptr if the section is absent, misplaced or of the wrong size.
+        */
+        template <typename T>
+        const T* getSection(const MappedFile& file, const FileHeader& header, FileSection section, uint64_t count)
+        {
+            const uint64_t offset = header.sectionOffsets[section];
+
+            if (offset == 0 || offset % kSectionAlignment != 0 || header.sectionSizes[section] != count * sizeof(T))
+                return nullptr;
+
+            if (offset > file.getSize() || file.getSize() - offset < header.sectionSizes[section])
+                return nullptr;
+
+            return reinterpret_cast<const T*>(file.getData() + offset);
+        }
+    }
+
+    const uint32_t MdpModel::kInvalidIndex;
+
+    MdpModel::MdpModel() : m_rowOffsets(1, 0), m_samplingMode(MdpSamplingMode::kSamplingLinear), m_isValidated(false), m_isCompiled(false)
+    {
+        bindStorage();
+    }
+
+    void MdpModel::bindStorage()
+    {
+        m_numStates = m_rowOffsets.size() - 1;
+        m_numTransitions = m_nextStates.size();
+
+        m_rowOffsetsData = m_rowOffsets.data();
+        m_nextStatesData = m_nextStates.data();
+        m_probabilitiesData = m_probabilities.data();
+        m_costsData = m_costs.data();
+        m_terminalData = m_terminal.data();
+        m_cumulativeData = m_cumulative.data();
+        m_aliasThresholdData = m_aliasThreshold.data();
+        m_aliasIndexData = m_aliasIndex.data();
+    }
+
+    void MdpModel::checkModifiable(const char* caller) const
+    {
+        if (isMapped())
+            REPORT_PANIC(std::string(caller) + ": the model is mapped from a file and cannot be modified");
+    }
+
+    void MdpModel::reserve(size_t numStates, size_t numTransitions)
+    {
+        checkModifiable("MdpModel::reserve");
+
+        m_rowOffsets.reserve(numStates + 1);
+        m_terminal.reserve(numStates);
+
+        m_nextStates.reserve(numTransitions);
+        m_probabilities.reserve(numTransitions);
+        m_costs.reserve(numTransitions);
+
+        bindStorage();
+    }
+
+    uint32_t MdpModel::addState()
+    {
+        checkModifiable("MdpModel::addState");
+
+        m_rowOffsets.push_back(m_rowOffsets.back());
+        m_isValidated = false;
+        m_isCompiled = false;
+
+        bindStorage();
+
+        return static_cast<uint32_t>(getNumStates() - 1);
+    }
+
+    void MdpModel::addTransition(uint32_t nextState, real_t prob, real_t cost)
+    {
+        checkModifiable("MdpModel::addTransition");
+
+        if (getNumStates() == 0)
+            REPORT_PANIC("MdpModel::addTransition: no state to add the transition to");
+
+        m_nextStates.push_back(nextState);
+        m_probabilities.push_back(prob);
+        m_costs.push_back(cost);
+
+        m_rowOffsets.back()++;
+        m_isValidated = false;
+        m_isCompiled = false;
+
+        bindStorage();
+    }
+
+    void MdpModel::assign(std::vector<uint32_t>&& rowOffsets, std::vector<uint32_t>&& nextStates, std::vector<real_t>&& probabilities, std::vector<real_t>&& costs)
+    {
+        if (rowOffsets.empty() || rowOffsets.front() != 0 || rowOffsets.back() != nextStates.size()
+            || probabilities.size() != nextStates.size() || costs.size() != nextStates.size())
+            REPORT_PANIC("MdpModel::assign: inconsistent CSR arrays");
+
+        clear();
+
+        m_rowOffsets = std::move(rowOffsets);
+        m_nextStates = std::move(nextStates);
+        m_probabilities = std::move(probabilities);
+        m_costs = std::move(costs);
+
+        bindStorage();
+    }
+
+    bool MdpModel::validate(std::vector<uint32_t>* outInvalidStates)
+    {
+        bool isValid = true;
+
+        if (outInvalidStates != nullptr)
+            outInvalidStates->clear();
+
+        for (uint32_t s = 0; s < getNumStates(); ++s)
+        {
+            if (m_rowOffsetsData[s] == m_rowOffsetsData[s + 1])
+                continue;
+
+            real_t totalProb = 0.0;
+            bool hasNegativeProb = false;
+
+            for (uint32_t t = m_rowOffsetsData[s]; t < m_rowOffsetsData[s + 1]; ++t)
+            {
+                totalProb += m_probabilitiesData[t];
+                hasNegativeProb = hasNegativeProb || m_probabilitiesData[t] < 0.0;
+            }
+
+            if (hasNegativeProb || !ARE_REALS_EQUAL(totalProb, 1.0))
+            {
+                isValid = false;
+
+                if (outInvalidStates != nullptr)
+                    outInvalidStates->push_back(s);
+            }
+        }
+
+        m_isValidated = isValid;
+
+        return isValid;
+    }
+
+    void MdpModel::compile()
+    {
+        checkModifiable("MdpModel::compile");
+
+        const uint32_t numStates = static_cast<uint32_t>(getNumStates());
+
+        sortRows();
+
+        m_terminal.assign(numStates, 1);
+
+        for (uint32_t s = 0; s < numStates; ++s)
+        {
+            for (uint32_t t = m_rowOffsets[s]; t < m_rowOffsets[s + 1]; ++t)
+            {
+                if (m_nextStates[t] >= numStates)
+                    REPORT_PANIC("MdpModel::compile: transition to a state out of range");
+
+                if (m_nextStates[t] != s)
+                    m_terminal[s] = 0;
+            }
+        }
+
+        m_cumulative.clear();
+        m_aliasThreshold.clear();
+        m_aliasIndex.clear();
+
+        switch (m_samplingMode)
+        {
+        case MdpSamplingMode::kSamplingCumulative:  buildCumulativeTable(); break;
+        case MdpSamplingMode::kSamplingAlias:       buildAliasTable(); break;
+        default: break;
+        }
+
+        m_isCompiled = true;
+
+        bindStorage();
+    }
+
+    void MdpModel::setSamplingMode(MdpSamplingMode mode)
+    {
+        if (isMapped() && mode != m_samplingMode && mode != MdpSamplingMode::kSamplingLinear)
+            REPORT_PANIC("MdpModel::setSamplingMode: the mapped model has no table for the requested sampling mode");
+
+        m_samplingMode = mode;
+    }
+
+    void MdpModel::buildCumulativeTable()
+    {
+        m_cumulative.resize(getNumTransitions());
+
+        for (uint32_t s = 0; s < getNumStates(); ++s)
+        {
+            real_t cumulativeProb = 0.0;
+
+            for (uint32_t t = m_rowOffsets[s]; t < m_rowOffsets[s + 1]; ++t)
+            {
+                cumulativeProb += m_probabilities[t];
+                m_cumulative[t] = cumulativeProb;
+            }
+        }
+    }
+
+    void MdpModel::buildAliasTable()
+    {
+        m_aliasThreshold.resize(getNumTransitions());
+        m_aliasIndex.resize(getNumTransitions());
+
+        std::vector<real_t> scaled;
+        std::vector<uint32_t> small;
+        std::vector<uint32_t> large;
+
+        // Vose's alias method, applied independently to every row
+        for (uint32_t s = 0; s < getNumStates(); ++s)
+        {
+            const uint32_t begin = m_rowOffsets[s];
+            const uint32_t count = m_rowOffsets[s + 1] - begin;
+
+            if (count == 0)
+                continue;
+
+            real_t totalProb = 0.0;
+            for (uint32_t i = 0; i < count; ++i)
+                totalProb += m_probabilities[begin + i];
+
+            scaled.resize(count);
+            small.clear();
+            large.clear();
+
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                scaled[i] = totalProb > 0.0 ? m_probabilities[begin + i] * count / totalProb : 1.0;
+
+                if (scaled[i] < 1.0)
+                    small.push_back(i);
+                else
+                    large.push_back(i);
+            }
+
+            while (!small.empty() && !large.empty())
+            {
+                uint32_t l = small.back();
+                small.pop_back();
+                uint32_t g = large.back();
+                large.pop_back();
+
+                m_aliasThreshold[begin + l] = scaled[l];
+                m_aliasIndex[begin + l] = begin + g;
+
+                scaled[g] = (scaled[g] + scaled[l]) - 1.0;
+
+                if (scaled[g] < 1.0)
+                    small.push_back(g);
+                else
+                    large.push_back(g);
+            }
+
+            // Leftovers are only due to rounding errors and always select themselves
+            for (size_t i = 0; i < large.size(); ++i)
+            {
+                m_aliasThreshold[begin + large[i]] = 1.0;
+                m_aliasIndex[begin + large[i]] = begin + large[i];
+            }
+
+            for (size_t i = 0; i < small.size(); ++i)
+            {
+                m_aliasThreshold[begin + small[i]] = 1.0;
+                m_aliasIndex[begin + small[i]] = begin + small[i];
+            }
+        }
+    }
+
+    void MdpModel::clear()
+    {
+        m_mappedFile.reset();
+
+        m_rowOffsets.assign(1, 0);
+        m_nextStates.clear();
+        m_probabilities.clear();
+        m_costs.clear();
+        m_terminal.clear();
+
+        m_cumulative.clear();
+        m_aliasThreshold.clear();
+        m_aliasIndex.clear();
+
+        m_isValidated = false;
+        m_isCompiled = false;
+
+        bindStorage();
+    }
+
+    uint32_t MdpModel::findTransition(uint32_t state, uint32_t nextState) const
+    {
+        const uint32_t* begin = m_nextStatesData + m_rowOffsetsData[state];
+        const uint32_t* end = m_nextStatesData + m_rowOffsetsData[state + 1];
+        const uint32_t* it = std::lower_bound(begin, end, nextState);
+
+        if (it != end && *it == nextState)
+            return static_cast<uint32_t>(it - m_nextStatesData);
+
+        return kInvalidIndex;
+    }
+
+    bool MdpModel::saveToFile(const std::string& filename) const
+    {
+        if (!m_isValidated || !m_isCompiled)
+        {
+            LOG_ERROR("MdpModel::saveToFile: the model must be validated and compiled before being saved to '%s'\n", filename.c_str());
+            return false;
+        }
+
+        std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            LOG_ERROR("MdpModel::saveToFile: failed to open file '%s'\n", filename.c_str());
+            return false;
+        }
+
+        const void* sectionData[kNumSections] = { m_rowOffsetsData, m_nextStatesData, m_probabilitiesData, m_costsData, m_terminalData, nullptr, nullptr, nullptr };
+
+        FileHeader header = {};
+        std::copy(kFileMagic, kFileMagic + sizeof(kFileMagic), header.magic);
+        header.version = kFileVersion;
+        header.byteOrderMark = kByteOrderMark;
+        header.realSize = sizeof(real_t);
+        header.samplingMode = static_cast<uint32_t>(m_samplingMode);
+        header.numStates = m_numStates;
+        header.numTransitions = m_numTransitions;
+
+        header.sectionSizes[kSectionRowOffsets] = (m_numStates + 1) * sizeof(uint32_t);
+        header.sectionSizes[kSectionNextStates] = m_numTransitions * sizeof(uint32_t);
+        header.sectionSizes[kSectionProbabilities] = m_numTransitions * sizeof(real_t);
+        header.sectionSizes[kSectionCosts] = m_numTransitions * sizeof(real_t);
+        header.sectionSizes[kSectionTerminal] = m_numStates * sizeof(uint8_t);
+
+        if (m_samplingMode == MdpSamplingMode::kSamplingCumulative)
+        {
+            sectionData[kSectionCumulative] = m_cumulativeData;
+            header.sectionSizes[kSectionCumulative] = m_numTransitions * sizeof(real_t);
+        }
+        else if (m_samplingMode == MdpSamplingMode::kSamplingAlias)
+        {
+            sectionData[kSectionAliasThreshold] = m_aliasThresholdData;
+            header.sectionSizes[kSectionAliasThreshold] = m_numTransitions * sizeof(real_t);
+            sectionData[kSectionAliasIndex] = m_aliasIndexData;
+            header.sectionSizes[kSectionAliasIndex] = m_numTransitions * sizeof(uint32_t);
+        }
+
+        uint64_t offset = sizeof(FileHeader);
+        for (int i = 0; i < kNumSections; ++i)
+        {
+            if (header.sectionSizes[i] == 0)
+                continue;
+
+            offset = (offset + kSectionAlignment - 1) / kSectionAlignment * kSectionAlignment;
+            header.sectionOffsets[i] = offset;
+            offset += header.sectionSizes[i];
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        const char padding[kSectionAlignment] = {};
+        uint64_t position = sizeof(FileHeader);
+
+        for (int i = 0; i < kNumSections; ++i)
+        {
+            if (header.sectionOffsets[i] == 0)
+                continue;
+
+            file.write(padding, header.sectionOffsets[i] - position);
+            file.write(static_cast<const char*>(sectionData[i]), header.sectionSizes[i]);
+            position = header.sectionOffsets[i] + header.sectionSizes[i];
+        }
+
+        if (!file.good())
+        {
+            LOG_ERROR("MdpModel::saveToFile: failed to write file '%s'\n", filename.c_str());
+            return false;
+        }
+
+        return true;
+    }
+
+    std::shared_ptr<MdpModel> MdpModel::mapFromFile(const std::string& filename)
+    {
+        std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+        if (!file->open(filename))
+            return nullptr;
+
+        if (file->getSize() < sizeof(FileHeader))
+        {
+            LOG_ERROR("MdpModel::mapFromFile: file '%s' is too small to be a model file\n", filename.c_str());
+            return nullptr;
+        }
+
+        const FileHeader& header = *reinterpret_cast<const FileHeader*>(file->getData());
+
+        if (!std::equal(kFileMagic, kFileMagic + sizeof(kFileMagic), header.magic))
+        {
+            LOG_ERROR("MdpModel::mapFromFile: file '%s' is not a model file\n", filename.c_str());
+            return nullptr;
+        }
+
+        if (header.version != kFileVersion || header.byteOrderMark != kByteOrderMark || header.realSize != sizeof(real_t))
+        {
+            LOG_ERROR("MdpModel::mapFromFile: file '%s' has version %u and was written by an incompatible build\n", filename.c_str(), header.version);
+            return nullptr;
+        }
+
+        if (header.numTransitions >= kInvalidIndex || header.numStates >= kInvalidIndex || header.samplingMode > static_cast<uint32_t>(MdpSamplingMode::kSamplingAlias))
+        {
+            LOG_ERROR("MdpModel::mapFromFile: file '%s' has an invalid header\n", filename.c_str());
+            return nullptr;
+        }
+
+        std::shared_ptr<MdpModel> model = std::make_shared<MdpModel>();
+        model->m_rowOffsets.clear();
+        model->m_samplingMode = static_cast<MdpSamplingMode>(header.samplingMode);
+        model->m_numStates = header.numStates;
+        model->m_numTransitions = header.numTransitions;
+
+        model->m_rowOffsetsData = getSection<uint32_t>(*file, header, kSectionRowOffsets, header.numStates + 1);
+        model->m_nextStatesData = getSection<uint32_t>(*file, header, kSectionNextStates, header.numTransitions);
+        model->m_probabilitiesData = getSection<real_t>(*file, header, kSectionProbabilities, header.numTransitions);
+        model->m_costsData = getSection<real_t>(*file, header, kSectionCosts, header.numTransitions);
+        model->m_terminalData = getSection<uint8_t>(*file, header, kSectionTerminal, header.numStates);
+
+        bool hasTables = true;
+        if (model->m_samplingMode == MdpSamplingMode::kSamplingCumulative)
+        {
+            model->m_cumulativeData = getSection<real_t>(*file, header, kSectionCumulative, header.numTransitions);
+            hasTables = model->m_cumulativeData != nullptr;
+        }
+        else if (model->m_samplingMode == MdpSamplingMode::kSamplingAlias)
+        {
+            model->m_aliasThresholdData = getSection<real_t>(*file, header, kSectionAliasThreshold, header.numTransitions);
+            model->m_aliasIndexData = getSection<uint32_t>(*file, header, kSectionAliasIndex, header.numTransitions);
+            hasTables = model->m_aliasThresholdData != nullptr && model->m_aliasIndexData != nullptr;
+        }
+
+        // Empty sections of an empty model are legitimately absent
+        const bool hasArrays = model->m_rowOffsetsData != nullptr && (header.numTransitions == 0 || (model->m_nextStatesData != nullptr
+            && model->m_probabilitiesData != nullptr && model->m_costsData != nullptr)) && (header.numStates == 0 || model->m_terminalData != nullptr);
+
+        if (!hasArrays || (header.numTransitions > 0 && !hasTables) || model->m_rowOffsetsData[0] != 0 || model->m_rowOffsetsData[header.numStates] != header.numTransitions)
+        {
+            LOG_ERROR("MdpModel::mapFromFile: file '%s' is truncated or corrupted\n", filename.c_str());
+            return nullptr;
+        }
+
+        // The arrays are read without bound checks afterwards, so a corrupted index is caught here rather than by a crash
+        if (!model->hasValidIndices() || !model->validate())
+        {
+            LOG_ERROR("MdpModel::mapFromFile: file '%s' is corrupted\n", filename.c_str());
+            return nullptr;
+        }
+
+        model->m_mappedFile = file;
+        model->m_isCompiled = true;
+
+        return model;
+    }
+
+    bool MdpModel::hasValidIndices() const
+    {
+        const uint32_t numStates = static_cast<uint32_t>(m_numStates);
+        const bool hasAliasTable = m_samplingMode == MdpSamplingMode::kSamplingAlias;
+
+        for (uint32_t s = 0; s < numStates; ++s)
+        {
+            const uint32_t begin = m_rowOffsetsData[s];
+            const uint32_t end = m_rowOffsetsData[s + 1];
+
+            if (begin > end || end > m_numTransitions || m_terminalData[s] > 1)
+                return false;
+
+            for (uint32_t t = begin; t < end; ++t)
+            {
+                if (m_nextStatesData[t] >= numStates)
+                    return false;
+
+                if (hasAliasTable && (m_aliasIndexData[t] < begin || m_aliasIndexData[t] >= end))
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+    void MdpModel::sortRows()
+    {
+        std::vector<uint32_t> order;
+        std::vector<uint32_t> nextStates;
+        std::vector<real_t> probabilities;
+        std::vector<real_t> costs;
+
+        for (uint32_t s = 0; s < getNumStates(); ++s)
+        {
+            const uint32_t begin = m_rowOffsets[s];
+            const uint32_t end = m_rowOffsets[s + 1];
+
+            if (std::is_sorted(m_nextStates.begin() + begin, m_nextStates.begin() + end))
+                continue;
+
+            order.resize(end - begin);
+            for (uint32_t i = 0; i < order.size(); ++i)
+                order[i] = begin + i;
+
+            std::stable_sort(order.begin(), order.end(), [this](uint32_t a, uint32_t b) { return m_nextStates[a] < m_nextStates[b]; });
+
+            nextStates.resize(order.size());
+            probabilities.resize(order.size());
+            costs.resize(order.size());
+
+            for (uint32_t i = 0; i < order.size(); ++i)
+            {
+                nextStates[i] = m_nextStates[order[i]];
+                probabilities[i] = m_probabilities[order[i]];
+                costs[i] = m_costs[order[i]];
+            }
+
+            std::copy(nextStates.begin(), nextStates.end(), m_nextStates.begin() + begin);
+            std::copy(probabilities.begin(), probabilities.end(), m_probabilities.begin() + begin);
+            std::copy(costs.begin(), costs.end(), m_costs.begin() + begin);
+        }
+    }
+} // namespace rlib
\ No newline at end of file
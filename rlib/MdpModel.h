@@ -0,0 +1,318 @@
+#ifndef MDP_MODEL_H
+#define MDP_MODEL_H
+
+#include <vector>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "../mocc/mocc.hpp"
+
+namespace rlib
+{
+    enum class MdpSamplingMode
+    {
+        kSamplingLinear,        // Linear scan of the cumulative probabilities, O(k) per step
+        kSamplingCumulative,    // Binary search in a per-state cumulative table, O(log k) per step
+        kSamplingAlias          // Walker/Vose alias tables, O(1) per step
+    };
+
+    /*
+    Compiled, cache friendly representation of an MDP transition graph.
+    Transitions are stored in CSR (compressed sparse row) form: the transitions of the state
+    with index i occupy the range [getRowBegin(i), getRowEnd(i)) of the contiguous arrays.
+    State references are indices into the model, not user defined state IDs.
+    A compiled model can be saved to a binary file and mapped back into memory with mapFromFile(): the arrays are then read
+    straight from the mapping, without parsing or copies, and the model is read only.
+    */
+    class MappedFile;
+
+    class MdpModel
+    {
+    public:
+        static const uint32_t kInvalidIndex = UINT32_MAX;
+
+        MdpModel();
+        ~MdpModel() = default;
+
+        // The accessors read through pointers into the model's own storage, copying would leave them dangling
+        MdpModel(const MdpModel&) = delete;
+        MdpModel& operator=(const MdpModel&) = delete;
+
+        /*
+        Reserves memory for the given number of states and transitions.
+        */
+        void reserve(size_t numStates, size_t numTransitions);
+
+        /*
+        Appends a new state (row) to the model. Subsequent calls to addTransition() add transitions to this state.
+        Returns:
+        - The index of the new state.
+        */
+        uint32_t addState();
+
+        /*
+        Appends a transition to the last added state.
+        Parameters:
+        - nextState: The index of the destination state.
+        - prob: The transition probability.
+        - cost: The cost of the transition.
+        */
+        void addTransition(uint32_t nextState, real_t prob, real_t cost);
+
+        /*
+        Replaces the contents of the model with complete CSR arrays, taking ownership of them without copying.
+        Parameters:
+        - rowOffsets: The numStates + 1 offsets of the rows, starting at 0 and ending at the number of transitions.
+        - nextStates: The index of the destination state of every transition.
+        - probabilities: The probability of every transition.
+        - costs: The cost of every transition.
+        */
+        void assign(std::vector<uint32_t>&& rowOffsets, std::vector<uint32_t>&& nextStates, std::vector<real_t>&& probabilities, std::vector<real_t>&& costs);
+
+        /*
+        Computes the derived per-state data (terminal flags and sampling tables) and sorts the transitions of every state by next state,
+        so that findTransition() is a binary search. Must be called once all the states and transitions have been added.
+        */
+        void compile();
+
+        /*
+        Checks that the transition probabilities of every state with at least one transition are non negative and add up to 1.0.
+        All the states are checked, so that every invalid state is reported at once.
+        Parameters:
+        - outInvalidStates: Optional vector receiving the indices of the invalid states.
+        Returns:
+        - true if the model is valid, false otherwise.
+        */
+        bool validate(std::vector<uint32_t>* outInvalidStates = nullptr);
+
+        /*
+        Returns true if the last call to validate() succeeded and the model has not been modified since.
+        */
+        bool isValidated() const { return m_isValidated; }
+
+        /*
+        Returns true if compile() has been called and the model has not been modified since.
+        */
+        bool isCompiled() const { return m_isCompiled; }
+
+        /*
+        Sets the algorithm used by sampleTransition(). The sampling tables are built by the next call to compile().
+        A mapped model can only use the sampling mode it was saved with, or kSamplingLinear which needs no table.
+        */
+        void setSamplingMode(MdpSamplingMode mode);
+        MdpSamplingMode getSamplingMode() const { return m_samplingMode; }
+
+        /*
+        Removes all the states and transitions from the model. A mapped model becomes an empty, modifiable one.
+        */
+        void clear();
+
+        /*
+        Writes the compiled model, including the sampling tables of the current sampling mode, to a binary file.
+        Parameters:
+        - filename: The path to the file.
+        Returns:
+        - true if the file was written, false otherwise.
+        */
+        bool saveToFile(const std::string& filename) const;
+
+        /*
+        Maps a file written by saveToFile() into memory. Only the header is checked, the arrays are used in place.
+        Parameters:
+        - filename: The path to the file.
+        Returns:
+        - The validated, compiled and read only model, or nullptr if the file could not be mapped or is not a valid model file.
+        */
+        static std::shared_ptr<MdpModel> mapFromFile(const std::string& filename);
+
+        /*
+        Returns true if the arrays of the model live in a mapped file.
+        */
+        bool isMapped() const { return m_mappedFile != nullptr; }
+
+        size_t getNumStates() const { return m_numStates; }
+        size_t getNumTransitions() const { return m_numTransitions; }
+
+        uint32_t getRowBegin(uint32_t state) const { return m_rowOffsetsData[state]; }
+        uint32_t getRowEnd(uint32_t state) const { return m_rowOffsetsData[state + 1]; }
+
+        uint32_t getNextState(uint32_t transition) const { return m_nextStatesData[transition]; }
+        real_t getProbability(uint32_t transition) const { return m_probabilitiesData[transition]; }
+        real_t getCost(uint32_t transition) const { return m_costsData[transition]; }
+
+        /*
+        Checks if a state is terminal, i.e. it has no transitions to other states.
+        */
+        bool isTerminal(uint32_t state) const { return m_terminalData[state] != 0; }
+
+        /*
+        Finds the transition from a state to a given next state.
+        Parameters:
+        - state: The index of the source state.
+        - nextState: The index of the destination state.
+        Returns:
+        - The index of the transition, or kInvalidIndex if there is none.
+        Requires the model to be compiled.
+        */
+        uint32_t findTransition(uint32_t state, uint32_t nextState) const;
+
+        /*
+        Selects the transition taken from a state given a uniform random number, using the current sampling mode.
+        Parameters:
+        - state: The index of the source state.
+        - u: A uniform random number in [0, 1).
+        Returns:
+        - The index of the selected transition, or kInvalidIndex if none could be selected.
+        */
+        uint32_t sampleTransition(uint32_t state, real_t u) const
+        {
+            switch (m_samplingMode)
+            {
+            case MdpSamplingMode::kSamplingCumulative:  return sampleTransitionCumulative(state, u);
+            case MdpSamplingMode::kSamplingAlias:       return sampleTransitionAlias(state, u);
+            default:                                    return sampleTransitionLinear(state, u);
+            }
+        }
+
+        /*
+        Reference sampling path: scans the transitions of the state accumulating their probabilities.
+        */
+        uint32_t sampleTransitionLinear(uint32_t state, real_t u) const
+        {
+            const uint32_t end = m_rowOffsetsData[state + 1];
+            real_t cumulativeProb = 0.0;
+
+            for (uint32_t t = m_rowOffsetsData[state]; t < end; ++t)
+            {
+                cumulativeProb += m_probabilitiesData[t];
+
+                if (u <= cumulativeProb)
+                    return t;
+            }
+
+            // Validated rows add up to 1.0 within rounding errors, which the last transition absorbs
+            return end > m_rowOffsetsData[state] ? end - 1 : kInvalidIndex;
+        }
+
+        /*
+        Binary search in the cumulative table. Requires the model to be compiled with kSamplingCumulative.
+        */
+        uint32_t sampleTransitionCumulative(uint32_t state, real_t u) const
+        {
+            uint32_t lo = m_rowOffsetsData[state];
+            uint32_t hi = m_rowOffsetsData[state + 1];
+
+            if (lo == hi)
+                return kInvalidIndex;
+
+            const uint32_t last = hi - 1;
+
+            // First transition whose cumulative probability is >= u, the last one absorbs rounding errors
+            while (lo < hi)
+            {
+                uint32_t mid = lo + (hi - lo) / 2;
+
+                if (m_cumulativeData[mid] < u)
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+
+            return lo < last ? lo : last;
+        }
+
+        /*
+        Alias table lookup. Requires the model to be compiled with kSamplingAlias.
+        */
+        uint32_t sampleTransitionAlias(uint32_t state, real_t u) const
+        {
+            const uint32_t begin = m_rowOffsetsData[state];
+            const uint32_t count = m_rowOffsetsData[state + 1] - begin;
+
+            if (count == 0)
+                return kInvalidIndex;
+
+            // The integer part of u * count selects the column, the fractional part decides between the column and its alias
+            real_t x = u * count;
+            uint32_t column = static_cast<uint32_t>(x);
+            if (column >= count)
+                column = count - 1;
+
+            const uint32_t t = begin + column;
+
+            return (x - column) < m_aliasThresholdData[t] ? t : m_aliasIndexData[t];
+        }
+
+        /*
+        Same as sampleTransitionAlias(), selecting between the column and its alias with a mask instead of a branch.
+        Faster when many independent chains are sampled in a row, since the coin flip is unpredictable; a single trajectory
+        is better served by the branch, which lets the processor speculate on the next state.
+        */
+        uint32_t sampleTransitionAliasBranchless(uint32_t state, real_t u) const
+        {
+            const uint32_t begin = m_rowOffsetsData[state];
+            const uint32_t count = m_rowOffsetsData[state + 1] - begin;
+
+            if (count == 0)
+                return kInvalidIndex;
+
+            real_t x = u * count;
+            uint32_t column = static_cast<uint32_t>(x);
+            if (column >= count)
+                column = count - 1;
+
+            const uint32_t t = begin + column;
+            const uint32_t mask = 0u - static_cast<uint32_t>((x - column) >= m_aliasThresholdData[t]);
+
+            return t ^ ((t ^ m_aliasIndexData[t]) & mask);
+        }
+
+    private:
+        // Owned storage, empty when the model is mapped from a file
+        std::vector<uint32_t> m_rowOffsets;
+        std::vector<uint32_t> m_nextStates;
+        std::vector<real_t> m_probabilities;
+        std::vector<real_t> m_costs;
+        std::vector<uint8_t> m_terminal;
+
+        MdpSamplingMode m_samplingMode;
+        bool m_isValidated;
+        bool m_isCompiled;
+        std::vector<real_t> m_cumulative;
+        std::vector<real_t> m_aliasThreshold;
+        std::vector<uint32_t> m_aliasIndex;
+
+        // What the accessors read, pointing either into the owned storage or into the mapped file
+        size_t m_numStates;
+        size_t m_numTransitions;
+        const uint32_t* m_rowOffsetsData;
+        const uint32_t* m_nextStatesData;
+        const real_t* m_probabilitiesData;
+        const real_t* m_costsData;
+        const uint8_t* m_terminalData;
+        const real_t* m_cumulativeData;
+        const real_t* m_aliasThresholdData;
+        const uint32_t* m_aliasIndexData;
+
+        std::shared_ptr<MappedFile> m_mappedFile;
+
+        /*
+        Points the views at the owned storage, must be called after every change to it.
+        */
+        void bindStorage();
+        void checkModifiable(const char* caller) const;
+
+        /*
+        Checks that every index of the arrays stays in bounds: monotonic row offsets, next states below the number of states,
+        alias indices in the row of their transition and terminal flags of 0 or 1. A single pass, used on mapped files.
+        */
+        bool hasValidIndices() const;
+
+        void sortRows();
+        void buildCumulativeTable();
+        void buildAliasTable();
+    };
+} // namespace rlib
+
+#endif // MDP_MODEL_H
\ No newline at end of file
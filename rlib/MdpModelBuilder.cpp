@@ -0,0 +1,270 @@
+#include "MdpModelBuilder.h"
+
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+#include "Debug.h"
+#include "MappedFile.h"
+#include "TextParse.h"
+
+namespace rlib
+{
+    namespace
+    {
+        /*
+        Iterates over the lines of a mapped file.
+        */
+        class MappedLineSource
+        {
+        public:
+            MappedLineSource(const MappedFile& file) : m_file(file) {}
+
+            /*
+            Calls fn(begin, end, lineNumber) on every line, stopping as soon as fn returns false.
+            Returns:
+            - false if the iteration was stopped, true otherwise.
+            */
+            template <typename Fn>
+            bool forEachLine(Fn fn) const
+            {
+                const char* p = m_file.getData();
+                const char* end = p + m_file.getSize();
+                size_t lineNumber = 0;
+
+                while (p < end)
+                {
+                    const char* eol = static_cast<const char*>(memchr(p, '\n', end - p));
+                    if (eol == nullptr)
+                        eol = end;
+
+                    if (!fn(p, eol, ++lineNumber))
+                        return false;
+
+                    p = eol + 1;
+                }
+
+                return true;
+            }
+
+        private:
+            const MappedFile& m_file;
+        };
+
+        /*
+        Iterates over the lines of a seekable stream, rewinding it before every iteration.
+        */
+        class StreamLineSource
+        {
+        public:
+            StreamLineSource(std::istream& stream) : m_stream(stream), m_start(stream.tellg()) {}
+
+            template <typename Fn>
+            bool forEachLine(Fn fn)
+            {
+                m_stream.clear();
+                m_stream.seekg(m_start);
+
+                // A single buffer is reused for all the lines
+                std::string line;
+                size_t lineNumber = 0;
+
+                while (std::getline(m_stream, line))
+                {
+                    if (!fn(line.data(), line.data() + line.size(), ++lineNumber))
+                        return false;
+                }
+
+                return true;
+            }
+
+        private:
+            std::istream& m_stream;
+            std::streampos m_start;
+        };
+
+        bool parseStateID(const char* begin, const char* end, uint32_t& outValue)
+        {
+            uint64_t value = 0;
+
+            for (const char* p = begin; p < end; ++p)
+            {
+                if (*p < '0' || *p > '9')
+                    return false;
+
+                value = value * 10 + (*p - '0');
+
+                // Same range as the int IDs of MdpStateTransitionDefParameter
+                if (value > INT_MAX)
+                    return false;
+            }
+
+            outValue = static_cast<uint32_t>(value);
+
+            return begin < end;
+        }
+    }
+
+    std::shared_ptr<MdpModel> MdpModelBuilder::buildFromFile(const std::string& filename) const
+    {
+        MappedFile file;
+        if (!file.open(filename))
+            return nullptr;
+
+        MappedLineSource source(file);
+
+        return build(source, filename);
+    }
+
+    std::shared_ptr<MdpModel> MdpModelBuilder::buildFromStream(std::istream& stream) const
+    {
+        StreamLineSource source(stream);
+
+        return build(source, "stream");
+    }
+
+    MdpModelBuilder::LineKind MdpModelBuilder::parseLine(const char* begin, const char* end, TransitionDef& outDef) const
+    {
+        const char* p = begin;
+        const char* tokenBegin;
+        const char* tokenEnd;
+
+        if (!nextToken(p, end, tokenBegin, tokenEnd))
+            return LineKind::kLineSkipped;
+
+        if (static_cast<size_t>(tokenEnd - tokenBegin) != m_transitionTypeName.size() || memcmp(tokenBegin, m_transitionTypeName.data(), m_transitionTypeName.size()) != 0)
+            return LineKind::kLineSkipped;
+
+        const char* fieldBegin[5];
+        const char* fieldEnd[5];
+        int numFields = 0;
+
+        while (numFields < 5 && nextToken(p, end, fieldBegin[numFields], fieldEnd[numFields]))
+            ++numFields;
+
+        // Definitions with an action ("state action nextState probability cost") belong to an ActionMdpModel
+        if (numFields != 4 || nextToken(p, end, tokenBegin, tokenEnd))
+            return LineKind::kLineInvalid;
+
+        if (!parseStateID(fieldBegin[0], fieldEnd[0], outDef.state) || !parseStateID(fieldBegin[1], fieldEnd[1], outDef.nextState)
+            || !parseDouble(fieldBegin[2], fieldEnd[2], outDef.probability) || !parseDouble(fieldBegin[3], fieldEnd[3], outDef.cost))
+            return LineKind::kLineInvalid;
+
+        return LineKind::kLineTransition;
+    }
+
+    template <typename LineSource>
+    std::shared_ptr<MdpModel> MdpModelBuilder::build(LineSource& source, const std::string& sourceName) const
+    {
+        // First pass: records the state of every transition and the highest state ID, the row counts can only be sized once it is known
+        std::vector<uint32_t> transitionStates;
+        uint32_t highestState = 0;
+        size_t highestStateLine = 0;
+        size_t errorLine = 0;
+        TransitionDef def;
+
+        bool isComplete = source.forEachLine([&](const char* begin, const char* end, size_t lineNumber)
+        {
+            LineKind kind = parseLine(begin, end, def);
+
+            if (kind == LineKind::kLineSkipped)
+                return true;
+
+            if (kind == LineKind::kLineInvalid || transitionStates.size() + 1 >= MdpModel::kInvalidIndex)
+            {
+                errorLine = lineNumber;
+                return false;
+            }
+
+            if (std::max(def.state, def.nextState) > highestState || highestStateLine == 0)
+            {
+                highestState = std::max(def.state, def.nextState);
+                highestStateLine = lineNumber;
+            }
+
+            transitionStates.push_back(def.state);
+
+            return true;
+        });
+
+        if (!isComplete)
+        {
+            LOG_ERROR("MdpModelBuilder: invalid transition definition in %s at line %zu\n", sourceName.c_str(), errorLine);
+            return nullptr;
+        }
+
+        const size_t numTransitions = transitionStates.size();
+
+        // Rejecting sparse IDs keeps a single huge ID from allocating gigabytes of empty rows
+        if (highestState > 2 * numTransitions + kMaxStateIDGap)
+        {
+            LOG_ERROR("MdpModelBuilder: state ID in %s at line %zu is too far above the number of transitions, state IDs must be dense\n", sourceName.c_str(), highestStateLine);
+            return nullptr;
+        }
+
+        // rowOffsets[s + 1] counts the transitions of state s
+        const size_t numStates = numTransitions > 0 ? static_cast<size_t>(highestState) + 1 : 0;
+        std::vector<uint32_t> rowOffsets(numStates + 1, 0);
+
+        for (size_t t = 0; t < numTransitions; ++t)
+            rowOffsets[transitionStates[t] + 1]++;
+
+        for (size_t s = 0; s < numStates; ++s)
+            rowOffsets[s + 1] += rowOffsets[s];
+
+        std::vector<uint32_t>().swap(transitionStates);
+
+        // Second pass: every transition goes straight to the next free slot of its row
+        std::vector<uint32_t> nextStates(numTransitions);
+        std::vector<real_t> probabilities(numTransitions);
+        std::vector<real_t> costs(numTransitions);
+        std::vector<uint32_t> cursors(rowOffsets.begin(), rowOffsets.end() - 1);
+        size_t numFilled = 0;
+
+        isComplete = source.forEachLine([&](const char* begin, const char* end, size_t lineNumber)
+        {
+            if (parseLine(begin, end, def) != LineKind::kLineTransition)
+                return true;
+
+            // Only possible if the input changed between the two passes
+            if (def.state >= numStates || def.nextState >= numStates || cursors[def.state] >= rowOffsets[def.state + 1])
+            {
+                errorLine = lineNumber;
+                return false;
+            }
+
+            const uint32_t t = cursors[def.state]++;
+            nextStates[t] = def.nextState;
+            probabilities[t] = def.probability;
+            costs[t] = def.cost;
+            numFilled++;
+
+            return true;
+        });
+
+        if (!isComplete || numFilled != numTransitions)
+        {
+            LOG_ERROR("MdpModelBuilder: %s changed while being read\n", sourceName.c_str());
+            return nullptr;
+        }
+
+        std::vector<uint32_t>().swap(cursors);
+
+        std::shared_ptr<MdpModel> model = std::make_shared<MdpModel>();
+        model->assign(std::move(rowOffsets), std::move(nextStates), std::move(probabilities), std::move(costs));
+        model->setSamplingMode(m_samplingMode);
+
+        std::vector<uint32_t> invalidStates;
+        if (!model->validate(&invalidStates))
+        {
+            for (size_t i = 0; i < invalidStates.size(); ++i)
+                LOG_ERROR("MdpModelBuilder: transition probabilities of state %u in %s do not add up to 1\n", invalidStates[i], sourceName.c_str());
+
+            return nullptr;
+        }
+
+        model->compile();
+
+        return model;
+    }
+} // namespace rlib
\ No newline at end of file
@@ -0,0 +1,84 @@
+#ifndef MDP_MODEL_BUILDER_H
+#define MDP_MODEL_BUILDER_H
+
+#include <istream>
+#include <memory>
+#include <string>
+
+#include "MdpModel.h"
+
+namespace rlib
+{
+    /*
+    Builds an MdpModel straight from the transition definitions of a parameter file, without creating a Parameter per line.
+    The input is read twice: the first pass collects the state of every transition to count the transitions of every state,
+    the second one writes each transition at its final position in exactly sized CSR arrays. Transitions keep the input order
+    within their state. Lines of other parameter types are skipped. State IDs are used as state indices, as in
+    ActionMdpModel::fromParameters(), so they must be dense: the highest state ID may exceed twice the number of transitions
+    by at most kMaxStateIDGap, which bounds the memory of the counts by the size of the input whatever the order of the lines.
+    */
+    class MdpModelBuilder
+    {
+    public:
+        static const uint32_t kMaxStateIDGap = 1 << 20;
+
+        /*
+        Parameters:
+        - transitionTypeName: The type name of the transition definition lines, e.g. "mdpStateTransitionDef".
+        */
+        MdpModelBuilder(const std::string& transitionTypeName = "mdpStateTransitionDef") : m_transitionTypeName(transitionTypeName), m_samplingMode(MdpSamplingMode::kSamplingLinear) {}
+        ~MdpModelBuilder() = default;
+
+        /*
+        Sets the sampling mode the built models are compiled with.
+        */
+        void setSamplingMode(MdpSamplingMode mode) { m_samplingMode = mode; }
+
+        /*
+        Builds a model from a parameter file, which is memory mapped.
+        Parameters:
+        - filename: The path to the parameter file.
+        Returns:
+        - The validated and compiled model, or nullptr if the file cannot be read or contains invalid transitions.
+        */
+        std::shared_ptr<MdpModel> buildFromFile(const std::string& filename) const;
+
+        /*
+        Builds a model from a stream of parameter lines. The stream must be seekable, it is rewound to its initial position for the second pass.
+        Parameters:
+        - stream: The input stream.
+        Returns:
+        - The validated and compiled model, or nullptr if the stream contains invalid transitions.
+        */
+        std::shared_ptr<MdpModel> buildFromStream(std::istream& stream) const;
+
+    private:
+        struct TransitionDef
+        {
+            uint32_t state;
+            uint32_t nextState;
+            real_t probability;
+            real_t cost;
+        };
+
+        enum class LineKind
+        {
+            kLineSkipped,
+            kLineTransition,
+            kLineInvalid
+        };
+
+        std::string m_transitionTypeName;
+        MdpSamplingMode m_samplingMode;
+
+        /*
+        Parses a line of the form "typeName state nextState probability cost".
+        */
+        LineKind parseLine(const char* begin, const char* end, TransitionDef& outDef) const;
+
+        template <typename LineSource>
+        std::shared_ptr<MdpModel> build(LineSource& source, const std::string& sourceName) const;
+    };
+} // namespace rlib
+
+#endif // MDP_MODEL_BUILDER_H
\ No newline at end of file
@@ -0,0 +1,440 @@
+#include "MdpRollout.h"
+#include "Rng.h"
+#include "Sobol.h"
+
+#include "GeneralUtil.h"
+#include "../mocc/math.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <thread>
+#include <vector>
+
+namespace rlib
+{
+    const size_t MdpRolloutEngine::kTrajectoriesPerBlock;
+
+    namespace
+    {
+        const size_t kMinUniformsPerRefill = 4;
+        const size_t kMaxUniformsPerRefill = 256;
+
+        /*
+        Uniforms of plain Monte Carlo: the current stream of the generator, mirrored for the second trajectory of an antithetic pair.
+        */
+        struct StreamUniforms
+        {
+            PhiloxRng& rng;
+            bool isMirrored;
+
+            void fill(real_t* out, size_t /*position*/, size_t count)
+            {
+                rng.fillUniform(out, count);
+
+                if (isMirrored)
+                {
+                    for (size_t i = 0; i < count; ++i)
+                        out[i] = 1.0 - out[i];
+                }
+            }
+        };
+
+        /*
+        Uniforms of quasi Monte Carlo: the coordinates of a Sobol point for the first steps, then the current stream of the generator.
+        */
+        struct QuasiRandomUniforms
+        {
+            PhiloxRng& rng;
+            const SobolSequence& sobol;
+            uint32_t pointIndex;
+
+            void fill(real_t* out, size_t position, size_t count)
+            {
+                size_t i = 0;
+                for (; i < count && position + i < sobol.getNumDimensions(); ++i)
+                    out[i] = sobol.getValue(pointIndex, static_cast<uint32_t>(position + i));
+
+                if (i < count)
+                {
+                    rng.getEngine().setPosition(position + i);
+                    rng.fillUniform(out + i, count - i);
+                }
+            }
+        };
+
+        template <typename UniformSource>
+        void simulateTrajectory(const MdpModel& model, UniformSource& source, const MdpRolloutOptions& options, bool recordStates, MdpTrajectory& outTrajectory)
+        {
+            uint32_t state = options.initialState;
+            uint32_t numSteps = 0;
+            real_t totalCost = 0.0;
+
+            outTrajectory.states.clear();
+            if (recordStates)
+                outTrajectory.states.push_back(state);
+
+            // The uniforms are drawn in blocks growing with the trajectory, so that short trajectories waste few draws
+            real_t uniforms[kMaxUniformsPerRefill];
+            size_t refillSize = kMinUniformsPerRefill;
+            size_t numUniforms = 0;
+            size_t next = 0;
+
+            while (!model.isTerminal(state) && numSteps < options.maxSteps)
+            {
+                if (next == numUniforms)
+                {
+                    source.fill(uniforms, numSteps, refillSize);
+                    numUniforms = refillSize;
+                    next = 0;
+                    refillSize = std::min(refillSize * 2, kMaxUniformsPerRefill);
+                }
+
+                const uint32_t transition = model.sampleTransition(state, uniforms[next++]);
+
+                totalCost += model.getCost(transition);
+                state = model.getNextState(transition);
+                numSteps++;
+
+                if (recordStates)
+                    outTrajectory.states.push_back(state);
+            }
+
+            outTrajectory.totalCost = totalCost;
+            outTrajectory.numSteps = numSteps;
+            outTrajectory.isTruncated = !model.isTerminal(state);
+        }
+
+        /*
+        Simulates trajectory i of a run: the uniform of step k is derived from position k of the stream i, or of the stream of
+        the first trajectory of its antithetic pair.
+        */
+        void simulateTrajectory(const MdpModel& model, PhiloxRng& rng, const std::vector<SobolSequence>& sequences, const MdpRolloutOptions& options,
+            size_t trajectoryIndex, bool recordStates, MdpTrajectory& outTrajectory)
+        {
+            switch (options.varianceReduction)
+            {
+            case MdpVarianceReduction::kAntithetic:
+            {
+                rng.getEngine().setStream(trajectoryIndex & ~static_cast<size_t>(1));
+                StreamUniforms source = { rng, (trajectoryIndex & 1) != 0 };
+                simulateTrajectory(model, source, options, recordStates, outTrajectory);
+                break;
+            }
+            case MdpVarianceReduction::kQuasiRandom:
+            {
+                rng.getEngine().setStream(trajectoryIndex);
+                QuasiRandomUniforms source = { rng, sequences[trajectoryIndex % sequences.size()], static_cast<uint32_t>(trajectoryIndex / sequences.size()) };
+                simulateTrajectory(model, source, options, recordStates, outTrajectory);
+                break;
+            }
+            default:
+            {
+                rng.getEngine().setStream(trajectoryIndex);
+                StreamUniforms source = { rng, false };
+                simulateTrajectory(model, source, options, recordStates, outTrajectory);
+                break;
+            }
+            }
+        }
+
+        /*
+        Builds the independently scrambled Sobol sequences of the replicates, none if the quasi random scheme is not used.
+        */
+        std::vector<SobolSequence> createSequences(const MdpRolloutOptions& options)
+        {
+            std::vector<SobolSequence> sequences;
+
+            if (options.varianceReduction != MdpVarianceReduction::kQuasiRandom)
+                return sequences;
+
+            if (options.numReplicates < 2)
+                REPORT_PANIC("MdpRolloutEngine: the quasi random scheme needs at least 2 replicates to estimate its error");
+
+            for (uint32_t r = 0; r < options.numReplicates; ++r)
+            {
+                sequences.push_back(SobolSequence(SobolSequence::kMaxDimensions));
+                sequences.back().scramble(deriveSeed(options.seed, r));
+            }
+
+            return sequences;
+        }
+
+        real_t sampleVariance(const OnlineDataAnalysis& data)
+        {
+            const real_t n = static_cast<real_t>(data.numberOfDataPoints());
+            return n > 1 ? data.stddev() * data.stddev() * n / (n - 1) : 0.0;
+        }
+
+        struct BlockStatistics
+        {
+            OnlineDataAnalysis cost;
+            OnlineDataAnalysis length;
+            OnlineDataAnalysis samples;             // Independent samples of the cost: trajectories, or antithetic pair means
+            std::vector<real_t> replicateCosts;     // Total cost of every quasi random replicate
+            real_t pairCost;
+            size_t numTruncated;
+            uint32_t minLength;
+            uint32_t maxLength;
+
+            BlockStatistics() : pairCost(0.0), numTruncated(0), minLength(UINT32_MAX), maxLength(0) {}
+
+            void insert(const MdpTrajectory& trajectory)
+            {
+                if (trajectory.isTruncated)
+                    numTruncated++;
+
+                cost.insertDataPoint(trajectory.totalCost);
+                length.insertDataPoint(trajectory.numSteps);
+                minLength = std::min(minLength, trajectory.numSteps);
+                maxLength = std::max(maxLength, trajectory.numSteps);
+            }
+
+            void merge(const BlockStatistics& other)
+            {
+                cost.merge(other.cost);
+                length.merge(other.length);
+                samples.merge(other.samples);
+                numTruncated += other.numTruncated;
+                minLength = std::min(minLength, other.minLength);
+                maxLength = std::max(maxLength, other.maxLength);
+
+                replicateCosts.resize(std::max(replicateCosts.size(), other.replicateCosts.size()), 0.0);
+                for (size_t r = 0; r < other.replicateCosts.size(); ++r)
+                    replicateCosts[r] += other.replicateCosts[r];
+            }
+
+            /*
+            Fills the result, estimating the error of the mean from the independent samples of the scheme.
+            */
+            MdpRolloutResult summarize(const MdpRolloutOptions& options) const
+            {
+                MdpRolloutResult result;
+                result.numTrajectories = cost.numberOfDataPoints();
+                result.numTruncated = numTruncated;
+                result.meanCost = cost.mean();
+                result.stddevCost = cost.stddev();
+                result.meanLength = length.mean();
+                result.stddevLength = length.stddev();
+                result.minLength = result.numTrajectories > 0 ? minLength : 0;
+                result.maxLength = maxLength;
+
+                real_t estimatorVariance = 0.0;
+                if (options.varianceReduction == MdpVarianceReduction::kQuasiRandom)
+                {
+                    // The replicates are independent randomizations, the spread of their means measures the error
+                    OnlineDataAnalysis replicateMeans;
+                    const size_t numReplicates = replicateCosts.size();
+
+                    for (size_t r = 0; r < numReplicates; ++r)
+                    {
+                        const size_t count = result.numTrajectories / numReplicates + (r < result.numTrajectories % numReplicates ? 1 : 0);
+                        if (count > 0)
+                            replicateMeans.insertDataPoint(replicateCosts[r] / count);
+                    }
+
+                    if (replicateMeans.numberOfDataPoints() > 0)
+                        estimatorVariance = sampleVariance(replicateMeans) / replicateMeans.numberOfDataPoints();
+                }
+                else if (samples.numberOfDataPoints() > 0)
+                {
+                    estimatorVariance = sampleVariance(samples) / samples.numberOfDataPoints();
+                }
+
+                const real_t plainVariance = result.numTrajectories > 0 ? sampleVariance(cost) / result.numTrajectories : 0.0;
+
+                result.stderrCost = std::sqrt(estimatorVariance);
+                if (estimatorVariance > 0.0)
+                    result.varianceReductionFactor = plainVariance / estimatorVariance;
+                else
+                    result.varianceReductionFactor = plainVariance > 0.0 ? std::numeric_limits<real_t>::infinity() : 1.0;
+
+                return result;
+            }
+        };
+
+        /*
+        Runs a worker on every thread of the pool, the workers claim the blocks through an atomic counter so that
+        threads drawing long trajectories do not hold up the others.
+        */
+        template <typename Worker>
+        void runWorkers(ThreadPool& pool, size_t numBlocks, Worker worker)
+        {
+            pool.parallelFor(std::min<size_t>(numBlocks, pool.getNumThreads()), [&worker](size_t begin, size_t end, unsigned)
+            {
+                for (size_t i = begin; i < end; ++i)
+                    worker();
+            });
+        }
+    }
+
+    MdpRolloutEngine::MdpRolloutEngine(std::shared_ptr<const MdpModel> model) : m_model(model)
+    {
+        if (m_model == nullptr || !m_model->isValidated())
+            REPORT_PANIC("MdpRolloutEngine::MdpRolloutEngine: the model must be compiled and validated");
+    }
+
+    ThreadPool& MdpRolloutEngine::getPool(unsigned numThreads) const
+    {
+        if (numThreads == 0)
+            numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+        if (m_pool == nullptr || m_pool->getNumThreads() != numThreads)
+            m_pool.reset(new ThreadPool(numThreads));
+
+        return *m_pool;
+    }
+
+    MdpRolloutResult MdpRolloutEngine::run(const MdpRolloutOptions& options) const
+    {
+        if (options.initialState >= m_model->getNumStates())
+            REPORT_PANIC("MdpRolloutEngine::run: initial state index out of range");
+
+        // An unpaired last antithetic trajectory would count in the mean but not in its error
+        size_t numTrajectories = options.numTrajectories;
+        if (options.varianceReduction == MdpVarianceReduction::kAntithetic)
+            numTrajectories += numTrajectories & 1;
+
+        const std::vector<SobolSequence> sequences = createSequences(options);
+        const size_t numBlocks = (numTrajectories + kTrajectoriesPerBlock - 1) / kTrajectoriesPerBlock;
+        std::vector<BlockStatistics> blocks(numBlocks);
+        std::atomic<size_t> nextBlock(0);
+
+        auto worker = [&]()
+        {
+            PhiloxRng rng(options.seed);
+            MdpTrajectory trajectory;
+
+            for (size_t b = nextBlock++; b < numBlocks; b = nextBlock++)
+            {
+                BlockStatistics& stats = blocks[b];
+                const size_t end = std::min(numTrajectories, (b + 1) * kTrajectoriesPerBlock);
+
+                stats.replicateCosts.assign(sequences.size(), 0.0);
+
+                // The blocks hold an even number of trajectories, so antithetic pairs never straddle two blocks
+                for (size_t i = b * kTrajectoriesPerBlock; i < end; ++i)
+                {
+                    simulateTrajectory(*m_model, rng, sequences, options, i, false, trajectory);
+                    stats.insert(trajectory);
+
+                    switch (options.varianceReduction)
+                    {
+                    case MdpVarianceReduction::kAntithetic:
+                        if (i & 1)
+                            stats.samples.insertDataPoint(0.5 * (stats.pairCost + trajectory.totalCost));
+                        else
+                            stats.pairCost = trajectory.totalCost;
+                        break;
+                    case MdpVarianceReduction::kQuasiRandom:
+                        stats.replicateCosts[i % sequences.size()] += trajectory.totalCost;
+                        break;
+                    default:
+                        stats.samples.insertDataPoint(trajectory.totalCost);
+                        break;
+                    }
+                }
+            }
+        };
+
+        {
+            std::lock_guard<std::mutex> lock(m_poolMutex);
+            runWorkers(getPool(options.numThreads), numBlocks, worker);
+        }
+
+        // Merging in block order keeps the floating point results independent of the thread count
+        BlockStatistics total;
+        for (size_t b = 0; b < numBlocks; ++b)
+            total.merge(blocks[b]);
+
+        return total.summarize(options);
+    }
+
+    MdpRolloutComparison MdpRolloutEngine::compare(const MdpRolloutEngine& other, const MdpRolloutOptions& options) const
+    {
+        if (options.initialState >= m_model->getNumStates() || options.initialState >= other.m_model->getNumStates())
+            REPORT_PANIC("MdpRolloutEngine::compare: initial state index out of range");
+
+        MdpRolloutOptions plainOptions = options;
+        plainOptions.varianceReduction = MdpVarianceReduction::kNone;
+
+        const std::vector<SobolSequence> sequences;
+        const size_t numBlocks = (options.numTrajectories + kTrajectoriesPerBlock - 1) / kTrajectoriesPerBlock;
+        std::vector<BlockStatistics> firstBlocks(numBlocks);
+        std::vector<BlockStatistics> secondBlocks(numBlocks);
+        std::vector<OnlineDataAnalysis> differenceBlocks(numBlocks);
+        std::atomic<size_t> nextBlock(0);
+
+        auto worker = [&]()
+        {
+            PhiloxRng rng(options.seed);
+            MdpTrajectory first;
+            MdpTrajectory second;
+
+            for (size_t b = nextBlock++; b < numBlocks; b = nextBlock++)
+            {
+                const size_t end = std::min(options.numTrajectories, (b + 1) * kTrajectoriesPerBlock);
+
+                for (size_t i = b * kTrajectoriesPerBlock; i < end; ++i)
+                {
+                    simulateTrajectory(*m_model, rng, sequences, plainOptions, i, false, first);
+                    simulateTrajectory(*other.m_model, rng, sequences, plainOptions, i, false, second);
+
+                    firstBlocks[b].insert(first);
+                    firstBlocks[b].samples.insertDataPoint(first.totalCost);
+                    secondBlocks[b].insert(second);
+                    secondBlocks[b].samples.insertDataPoint(second.totalCost);
+                    differenceBlocks[b].insertDataPoint(first.totalCost - second.totalCost);
+                }
+            }
+        };
+
+        {
+            std::lock_guard<std::mutex> lock(m_poolMutex);
+            runWorkers(getPool(options.numThreads), numBlocks, worker);
+        }
+
+        BlockStatistics firstTotal;
+        BlockStatistics secondTotal;
+        OnlineDataAnalysis difference;
+        for (size_t b = 0; b < numBlocks; ++b)
+        {
+            firstTotal.merge(firstBlocks[b]);
+            secondTotal.merge(secondBlocks[b]);
+            difference.merge(differenceBlocks[b]);
+        }
+
+        MdpRolloutComparison comparison;
+        comparison.first = firstTotal.summarize(plainOptions);
+        comparison.second = secondTotal.summarize(plainOptions);
+        comparison.numTrajectories = difference.numberOfDataPoints();
+        comparison.meanDifference = difference.mean();
+
+        // Independent trajectories would add the variances of the two models, common ones subtract their covariance
+        const real_t differenceVariance = sampleVariance(difference);
+        const real_t independentVariance = sampleVariance(firstTotal.cost) + sampleVariance(secondTotal.cost);
+
+        comparison.stderrDifference = comparison.numTrajectories > 0 ? std::sqrt(differenceVariance / comparison.numTrajectories) : 0.0;
+        if (differenceVariance > 0.0)
+            comparison.varianceReductionFactor = independentVariance / differenceVariance;
+        else
+            comparison.varianceReductionFactor = independentVariance > 0.0 ? std::numeric_limits<real_t>::infinity() : 1.0;
+
+        return comparison;
+    }
+
+    MdpTrajectory MdpRolloutEngine::replay(const MdpRolloutOptions& options, size_t trajectoryIndex, bool recordStates) const
+    {
+        if (options.initialState >= m_model->getNumStates())
+            REPORT_PANIC("MdpRolloutEngine::replay: initial state index out of range");
+
+        const std::vector<SobolSequence> sequences = createSequences(options);
+        PhiloxRng rng(options.seed);
+        MdpTrajectory trajectory;
+
+        simulateTrajectory(*m_model, rng, sequences, options, trajectoryIndex, recordStates, trajectory);
+
+        return trajectory;
+    }
+} // namespace rlib
\ No newline at end of file
@@ -0,0 +1,139 @@
+#ifndef MDP_ROLLOUT_H
+#define MDP_ROLLOUT_H
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "MdpModel.h"
+#include "ThreadPool.h"
+
+namespace rlib
+{
+    enum class MdpVarianceReduction
+    {
+        kNone,              // Plain Monte Carlo, trajectory i draws from the stream i
+        kAntithetic,        // Trajectory 2j + 1 uses the uniforms 1 - u of trajectory 2j, the pairs are the independent samples. An odd number of trajectories is rounded up
+        kQuasiRandom        // Step k of the trajectories uses dimension k of scrambled Sobol points, beyond kMaxDimensions the plain streams
+    };
+
+    struct MdpRolloutOptions
+    {
+        size_t numTrajectories;     // Number of simulated trajectories
+        uint64_t seed;              // Key of the counter based generator, trajectory i draws from its stream i
+        uint32_t initialState;      // Index of the initial state of every trajectory
+        uint32_t maxSteps;          // Trajectories are truncated after this number of steps
+        unsigned numThreads;        // Number of worker threads, 0 uses all the available cores
+        MdpVarianceReduction varianceReduction;
+        uint32_t numReplicates;     // Independent scramblings of kQuasiRandom, trajectory i belongs to the replicate i % numReplicates
+
+        MdpRolloutOptions() : numTrajectories(10000), seed(0), initialState(0), maxSteps(1000000), numThreads(0), varianceReduction(MdpVarianceReduction::kNone), numReplicates(16) {}
+    };
+
+    struct MdpRolloutResult
+    {
+        size_t numTrajectories;
+        size_t numTruncated;        // Trajectories that reached maxSteps before a terminal state, included in the statistics
+        real_t meanCost;
+        real_t stddevCost;
+        real_t stderrCost;                  // Standard error of meanCost under the variance reduction scheme
+        real_t varianceReductionFactor;     // Variance of plain Monte Carlo with as many trajectories divided by stderrCost^2
+        real_t meanLength;
+        real_t stddevLength;
+        uint32_t minLength;
+        uint32_t maxLength;
+
+        MdpRolloutResult()
+            : numTrajectories(0), numTruncated(0), meanCost(0.0), stddevCost(0.0), stderrCost(0.0), varianceReductionFactor(1.0),
+            meanLength(0.0), stddevLength(0.0), minLength(0), maxLength(0) {}
+    };
+
+    struct MdpRolloutComparison
+    {
+        size_t numTrajectories;
+        real_t meanDifference;              // Mean cost of the first model minus the mean cost of the second one
+        real_t stderrDifference;
+        real_t varianceReductionFactor;     // Variance of the difference with independent trajectories divided by stderrDifference^2
+        MdpRolloutResult first;
+        MdpRolloutResult second;
+
+        MdpRolloutComparison() : numTrajectories(0), meanDifference(0.0), stderrDifference(0.0), varianceReductionFactor(1.0) {}
+    };
+
+    struct MdpTrajectory
+    {
+        real_t totalCost;
+        uint32_t numSteps;
+        bool isTruncated;
+        std::vector<uint32_t> states;   // Visited states, starting with the initial one, if requested
+
+        MdpTrajectory() : totalCost(0.0), numSteps(0), isTruncated(false) {}
+    };
+
+    /*
+    Estimates the expected total cost to termination of an MDP by Monte Carlo simulation, running the trajectories on all the cores.
+    Trajectories are processed in fixed size blocks whose statistics are merged in block order with the parallel Welford update,
+    and step k of trajectory i always uses the value at position k of the stream i of a Philox generator keyed by the seed:
+    results are bit identical for a given seed whatever the number of threads, and any trajectory can be replayed on its own.
+    The worker threads are kept in a ThreadPool between calls; concurrent calls on the same engine run one after the other.
+    The variance reduction schemes change how the uniforms of the trajectories are related, and the result reports the error of the
+    estimate together with how many times fewer trajectories it needs than plain Monte Carlo for the same confidence interval.
+    */
+    class MdpRolloutEngine
+    {
+    public:
+        static const size_t kTrajectoriesPerBlock = 256;
+
+        MdpRolloutEngine(std::shared_ptr<const MdpModel> model);
+        ~MdpRolloutEngine() = default;
+
+        /*
+        Runs the rollouts.
+        Parameters:
+        - options: The number of trajectories, seed, initial state, truncation length, number of threads and variance reduction scheme.
+          kAntithetic rounds an odd number of trajectories up to the next even one, so that every trajectory has its partner and the mean
+          and its error are computed from the same pairs. kQuasiRandom works best with a power of two trajectories per replicate.
+        Returns:
+        - The cost and trajectory length statistics, numTrajectories being the number of trajectories actually simulated.
+        */
+        MdpRolloutResult run(const MdpRolloutOptions& options) const;
+
+        /*
+        Estimates the difference between the expected costs of this model and of another one with common random numbers:
+        trajectory i of both models draws from the same stream, so that the noise they share cancels out in the difference.
+        Parameters:
+        - other: The engine of the other model, the initial state must be valid in both.
+        - options: The options of the run, varianceReduction is ignored.
+        Returns:
+        - The statistics of the difference and of each model.
+        */
+        MdpRolloutComparison compare(const MdpRolloutEngine& other, const MdpRolloutOptions& options) const;
+
+        /*
+        Simulates again a single trajectory of a run, e.g. to inspect an outlier.
+        Parameters:
+        - options: The options of the run, the number of trajectories and threads are not used.
+        - trajectoryIndex: The index of the trajectory in the run.
+        - recordStates: Whether to record the visited states.
+        Returns:
+        - The trajectory, identical to the one simulated by run().
+        */
+        MdpTrajectory replay(const MdpRolloutOptions& options, size_t trajectoryIndex, bool recordStates = false) const;
+
+        const MdpModel& getModel() const { return *m_model; }
+
+    private:
+        std::shared_ptr<const MdpModel> m_model;
+
+        // Created by the first run, and again whenever the requested number of threads changes
+        mutable std::unique_ptr<ThreadPool> m_pool;
+        mutable std::mutex m_poolMutex;
+
+        /*
+        Returns the pool with the requested number of threads, m_poolMutex must be held.
+        */
+        ThreadPool& getPool(unsigned numThreads) const;
+    };
+} // namespace rlib
+
+#endif // MDP_ROLLOUT_H
\ No newline at end of file
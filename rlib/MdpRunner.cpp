@@ -0,0 +1,28 @@
+#include "MdpRunner.h"
+
+#include "Debug.h"
+#include "GeneralUtil.h"
+
+namespace rlib
+{
+    MdpRunner::MdpRunner(std::shared_ptr<const MdpModel> model, RngBase* rng, uint32_t initialState) : m_model(model), m_rng(rng)
+    {
+        if (m_model == nullptr || !m_model->isValidated())
+            REPORT_PANIC("MdpRunner::MdpRunner: the model must be compiled and validated");
+
+        if (m_rng == nullptr)
+            REPORT_PANIC("MdpRunner::MdpRunner: a random number generator is required");
+
+        reset(initialState);
+    }
+
+    void MdpRunner::reset(uint32_t initialState)
+    {
+        if (initialState >= m_model->getNumStates())
+            REPORT_PANIC("MdpRunner::reset: initial state index out of range");
+
+        m_currentState = initialState;
+        m_numSteps = 0;
+        m_totalCost = 0.0;
+    }
+} // namespace rlib
\ No newline at end of file
@@ -0,0 +1,80 @@
+#ifndef MDP_RUNNER_H
+#define MDP_RUNNER_H
+
+#include <memory>
+
+#include "MdpModel.h"
+#include "Rng.h"
+#include "GeneralUtil.h"
+
+namespace rlib
+{
+    /*
+    A lightweight cursor simulating one trajectory over a shared, immutable MdpModel.
+    A runner only holds the current state, the accumulated cost and a handle to its random number generator,
+    so many runners can step concurrently against the same model without copying or locking it,
+    as long as each thread uses its own generator.
+    */
+    class MdpRunner
+    {
+    public:
+        /*
+        Creates a runner positioned on the given initial state.
+        Parameters:
+        - model: The compiled and validated model to simulate.
+        - rng: The random number generator used to sample the transitions. It must outlive the runner.
+        - initialState: The index of the initial state.
+        */
+        MdpRunner(std::shared_ptr<const MdpModel> model, RngBase* rng, uint32_t initialState = 0);
+        ~MdpRunner() = default;
+
+        /*
+        Transitions to the next state based on the transition probabilities of the current state.
+        */
+        void update() { update(*m_rng); }
+
+        /*
+        Same as update(), drawing from the given generator instead of the runner's one. With a concrete generator type
+        the draw is inlined into the step.
+        */
+        template <typename Generator>
+        void update(Generator& rng)
+        {
+            uint32_t transition = m_model->sampleTransition(m_currentState, drawUniformReal(rng));
+
+            if (transition == MdpModel::kInvalidIndex)
+                REPORT_PANIC("MdpRunner::update: failed to determine next state for transition");
+
+            m_totalCost += m_model->getCost(transition);
+            m_currentState = m_model->getNextState(transition);
+            m_numSteps++;
+        }
+
+        /*
+        Checks if the current state is terminal.
+        */
+        bool isTerminal() const { return m_model->isTerminal(m_currentState); }
+
+        /*
+        Moves the runner back to the given state and clears the accumulated cost.
+        */
+        void reset(uint32_t initialState = 0);
+
+        uint32_t getCurrentStateIndex() const { return m_currentState; }
+        real_t getTotalCost() const { return m_totalCost; }
+        uint32_t getNumSteps() const { return m_numSteps; }
+
+        const MdpModel& getModel() const { return *m_model; }
+        RngBase* getRng() const { return m_rng; }
+        void setRng(RngBase* rng) { m_rng = rng; }
+
+    private:
+        std::shared_ptr<const MdpModel> m_model;
+        RngBase* m_rng;
+        uint32_t m_currentState;
+        uint32_t m_numSteps;
+        real_t m_totalCost;
+    };
+} // namespace rlib
+
+#endif // MDP_RUNNER_H
\ No newline at end of file
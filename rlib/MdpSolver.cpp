@@ -0,0 +1,84 @@
+#include "MdpSolver.h"
+
+#include "Debug.h"
+#include "GeneralUtil.h"
+
+#include <algorithm>
+
+namespace rlib
+{
+    MdpCostSolver::MdpCostSolver(std::shared_ptr<const MdpModel> model) : m_model(model)
+    {
+        if (m_model == nullptr || !m_model->isValidated())
+            REPORT_PANIC("MdpCostSolver::MdpCostSolver: the model must be compiled and validated");
+    }
+
+    MdpSolverResult MdpCostSolver::solve(const MdpSolverOptions& options) const
+    {
+        if (options.relaxation <= 0.0 || options.relaxation >= 2.0)
+            REPORT_PANIC("MdpCostSolver::solve: the relaxation factor must be in (0, 2)");
+
+        const MdpModel& model = *m_model;
+        const uint32_t numStates = static_cast<uint32_t>(model.getNumStates());
+
+        // Per-state constants: expected immediate cost and self transition probability
+        std::vector<real_t> immediateCost(numStates, 0.0);
+        std::vector<real_t> selfProb(numStates, 0.0);
+
+        for (uint32_t s = 0; s < numStates; ++s)
+        {
+            if (model.isTerminal(s))
+                continue;
+
+            for (uint32_t t = model.getRowBegin(s); t < model.getRowEnd(s); ++t)
+            {
+                immediateCost[s] += model.getProbability(t) * model.getCost(t);
+
+                if (model.getNextState(t) == s)
+                    selfProb[s] += model.getProbability(t);
+            }
+
+            if (selfProb[s] >= 1.0)
+                REPORT_PANIC("MdpCostSolver::solve: non terminal state " + std::to_string(s) + " cannot leave itself");
+        }
+
+        MdpSolverResult result;
+        result.values.assign(numStates, 0.0);
+        std::vector<real_t>& v = result.values;
+
+        while (result.numIterations < options.maxIterations)
+        {
+            real_t maxChange = 0.0;
+
+            for (uint32_t s = 0; s < numStates; ++s)
+            {
+                if (model.isTerminal(s))
+                    continue;
+
+                real_t expectedNextValue = 0.0;
+                for (uint32_t t = model.getRowBegin(s); t < model.getRowEnd(s); ++t)
+                    expectedNextValue += model.getProbability(t) * v[model.getNextState(t)];
+
+                // Solving the row for v[s] moves the self transition term to the left hand side
+                real_t gaussSeidelValue = (immediateCost[s] + expectedNextValue - selfProb[s] * v[s]) / (1.0 - selfProb[s]);
+                real_t change = options.relaxation * (gaussSeidelValue - v[s]);
+
+                v[s] += change;
+                maxChange = std::max(maxChange, std::fabs(change));
+            }
+
+            result.numIterations++;
+            result.residual = maxChange;
+
+            if (maxChange < options.tolerance)
+            {
+                result.converged = true;
+                break;
+            }
+        }
+
+        LOG_DEBUG("MdpCostSolver::solve: %s after %u sweeps (residual %g)\n", result.converged ? "converged" : "not converged", result.numIterations, result.residual);
+
+        return result;
+    }
+} // namespace rlib
\ No newline at end of file
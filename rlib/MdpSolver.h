@@ -0,0 +1,55 @@
+#ifndef MDP_SOLVER_H
+#define MDP_SOLVER_H
+
+#include <memory>
+#include <vector>
+
+#include "MdpModel.h"
+
+namespace rlib
+{
+    struct MdpSolverOptions
+    {
+        real_t tolerance;           // The iteration stops when no value changes by more than this amount in a sweep
+        uint32_t maxIterations;     // Maximum number of sweeps
+        real_t relaxation;          // SOR relaxation factor in (0, 2), 1.0 is plain Gauss-Seidel
+
+        MdpSolverOptions() : tolerance(1e-9), maxIterations(100000), relaxation(1.0) {}
+    };
+
+    struct MdpSolverResult
+    {
+        std::vector<real_t> values; // Expected cost to absorption of every state, 0 for terminal states
+        uint32_t numIterations;
+        real_t residual;            // Largest value change of the last sweep
+        bool converged;
+
+        MdpSolverResult() : numIterations(0), residual(0.0), converged(false) {}
+    };
+
+    /*
+    Computes the exact expected cost to absorption of every state of an MDP, i.e. the solution of (I - P) v = c
+    restricted to the non terminal states, where c is the expected immediate cost of each state.
+    The system is solved in place on the CSR transition arrays with Gauss-Seidel / SOR sweeps.
+    */
+    class MdpCostSolver
+    {
+    public:
+        MdpCostSolver(std::shared_ptr<const MdpModel> model);
+        ~MdpCostSolver() = default;
+
+        /*
+        Solves for the expected cost to absorption.
+        Parameters:
+        - options: The tolerance, maximum number of sweeps and relaxation factor.
+        Returns:
+        - The per-state values and the convergence information.
+        */
+        MdpSolverResult solve(const MdpSolverOptions& options = MdpSolverOptions()) const;
+
+    private:
+        std::shared_ptr<const MdpModel> m_model;
+    };
+} // namespace rlib
+
+#endif // MDP_SOLVER_H
\ No newline at end of file
@@ -1,13 +1,57 @@
 #include "Parameter.h"
+#include <cstring>
 #include <sstream>
-#include <algorithm>
 
 #include "GeneralUtil.h"
+#include "TextParse.h"
 
 #define SEPARATOR ' '
 
 namespace rlib
 {
+    namespace
+    {
+        // Binary values are copied with memcpy: the snapshot buffers carry no alignment guarantee
+        template <typename T>
+        void appendBinaryValue(std::string& out, const T& value)
+        {
+            out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        template <typename T>
+        bool readBinaryValue(const char*& begin, const char* end, T& value)
+        {
+            if (static_cast<size_t>(end - begin) < sizeof(T))
+                return false;
+
+            memcpy(&value, begin, sizeof(T));
+            begin += sizeof(T);
+
+            return true;
+        }
+
+        template <typename T>
+        void appendBinaryArray(std::string& out, const std::vector<T>& values)
+        {
+            if (!values.empty())
+                out.append(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+        }
+
+        template <typename T>
+        bool readBinaryArray(const char* begin, const char* end, std::vector<T>& values)
+        {
+            const size_t size = end - begin;
+            if (size % sizeof(T) != 0)
+                return false;
+
+            values.resize(size / sizeof(T));
+            if (size > 0)
+                memcpy(values.data(), begin, size);
+
+            return true;
+        }
+    }
+
     const char* Parameter::parameterTypeAsString(ParameterType type)
     {
         switch (type)
@@ -46,20 +90,14 @@ namespace rlib
         return ParameterType::kParamInvalid;
     }
 
-    bool IntParameter::fromString(const std::string& string)
+    bool IntParameter::fromChars(const char* begin, const char* end)
     {
         if (!isValid()) REPORT_PANIC("Invalid IntParameter");
+        ValueChangeScope scope(*this);
 
-        try 
-        {
-            m_value = std::stoi(string);
-        }
-        catch (const std::invalid_argument&)
-        {
-            return false;
-        }
+        trimBlanks(begin, end);
 
-        return true;
+        return parseInt(begin, end, m_value);
     }
 
     std::string IntParameter::getValueString() const
@@ -69,20 +107,14 @@ namespace rlib
         return std::to_string(m_value);
     }
 
-    bool UIntParameter::fromString(const std::string& string)
+    bool UIntParameter::fromChars(const char* begin, const char* end)
     {
         if (!isValid()) REPORT_PANIC("Invalid UIntParameter");
+        ValueChangeScope scope(*this);
 
-        try 
-        {
-            m_value = static_cast<uint32_t>(std::stoul(string));
-        }
-        catch (const std::invalid_argument&)
-        {
-            return false;
-        }
+        trimBlanks(begin, end);
 
-        return true;
+        return parseUInt(begin, end, m_value);
     }
 
     std::string UIntParameter::getValueString() const
@@ -92,20 +124,14 @@ namespace rlib
         return std::to_string(m_value);
     }
 
-    bool FloatParameter::fromString(const std::string& string)
+    bool FloatParameter::fromChars(const char* begin, const char* end)
     {
         if (!isValid()) REPORT_PANIC("Invalid FloatParameter");
+        ValueChangeScope scope(*this);
 
-        try
-        {
-            m_value = std::stof(string);
-        }
-        catch (const std::invalid_argument&)
-        {
-            return false;
-        }
+        trimBlanks(begin, end);
 
-        return true;
+        return parseFloat(begin, end, m_value);
     }
 
     std::string FloatParameter::getValueString() const
@@ -115,20 +141,14 @@ namespace rlib
         return std::to_string(m_value);
     }
 
-    bool DoubleParameter::fromString(const std::string& string)
+    bool DoubleParameter::fromChars(const char* begin, const char* end)
     {
         if (!isValid()) REPORT_PANIC("Invalid DoubleParameter");
+        ValueChangeScope scope(*this);
 
-        try 
-        {
-            m_value = std::stod(string);
-        }
-        catch (const std::invalid_argument&)
-        {
-            return false;
-        }
+        trimBlanks(begin, end);
 
-        return true;
+        return parseDouble(begin, end, m_value);
     }
 
     std::string DoubleParameter::getValueString() const
@@ -138,11 +158,12 @@ namespace rlib
         return std::to_string(m_value);
     }
 
-    bool StringParameter::fromString(const std::string& string)
+    bool StringParameter::fromChars(const char* begin, const char* end)
     {
         if (!isValid()) REPORT_PANIC("Invalid StringParameter");
+        ValueChangeScope scope(*this);
 
-        m_value = string;
+        m_value.assign(begin, end);
 
         return true;
     }
@@ -154,27 +175,14 @@ namespace rlib
         return m_value;
     }
 
-    bool BoolParameter::fromString(const std::string& string)
+    bool BoolParameter::fromChars(const char* begin, const char* end)
     {
         if (!isValid()) REPORT_PANIC("Invalid BoolParameter");
+        ValueChangeScope scope(*this);
 
-        std::string lowerStr = string;
-        std::transform(lowerStr.begin(), lowerStr.end(), lowerStr.begin(), ::tolower);
-
-        if (lowerStr == "true" || lowerStr == "1")
-        {
-            m_value = true;
-        }
-        else if (lowerStr == "false" || lowerStr == "0")
-        {
-            m_value = false;
-        }
-        else
-        {
-            return false;
-        }
+        trimBlanks(begin, end);
 
-        return true;
+        return parseBool(begin, end, m_value);
     }
 
     std::string BoolParameter::getValueString() const
@@ -198,26 +206,25 @@ namespace rlib
             REPORT_PANIC("Index out of range in IntArrayParameter::setValue");
 
         m_value[idx] = value;
+        valueChanged();
     }
 
-    bool IntArrayParameter::fromString(const std::string& string)
+    bool IntArrayParameter::fromChars(const char* begin, const char* end)
     {
         if (!isValid()) REPORT_PANIC("Invalid IntArrayParameter");
+        ValueChangeScope scope(*this);
 
         m_value.clear();
 
-        std::istringstream ss(string);
-        std::string item;
-        while (std::getline(ss, item, SEPARATOR))
+        const char* tokenBegin;
+        const char* tokenEnd;
+        while (nextToken(begin, end, tokenBegin, tokenEnd))
         {
-            try 
-            {
-                m_value.push_back(std::stoi(item));
-            }
-            catch (const std::invalid_argument&)
-            {
+            int value;
+            if (!parseInt(tokenBegin, tokenEnd, value))
                 return false;
-            }
+
+            m_value.push_back(value);
         }
 
         return true;
@@ -254,27 +261,25 @@ namespace rlib
             REPORT_PANIC("Index out of range in FloatArrayParameter::setValue");
 
         m_value[idx] = value;
+        valueChanged();
     }
 
-    bool FloatArrayParameter::fromString(const std::string& string)
+    bool FloatArrayParameter::fromChars(const char* begin, const char* end)
     {
         if (!isValid()) REPORT_PANIC("Invalid FloatArrayParameter");
-        
-        m_value.clear();
+        ValueChangeScope scope(*this);
 
-        std::istringstream ss(string);
-        std::string item;
+        m_value.clear();
 
-        while (std::getline(ss, item, SEPARATOR))
+        const char* tokenBegin;
+        const char* tokenEnd;
+        while (nextToken(begin, end, tokenBegin, tokenEnd))
         {
-            try 
-            {
-                m_value.push_back(std::stof(item));
-            }
-            catch (const std::invalid_argument&)
-            {
+            float value;
+            if (!parseFloat(tokenBegin, tokenEnd, value))
                 return false;
-            }
+
+            m_value.push_back(value);
         }
 
         return true;
@@ -311,27 +316,25 @@ namespace rlib
             REPORT_PANIC("Index out of range in DoubleArrayParameter::setValue");
 
         m_value[idx] = value;
+        valueChanged();
     }
 
-    bool DoubleArrayParameter::fromString(const std::string& string)
+    bool DoubleArrayParameter::fromChars(const char* begin, const char* end)
     {
         if (!isValid()) REPORT_PANIC("Invalid DoubleArrayParameter");
+        ValueChangeScope scope(*this);
 
         m_value.clear();
 
-        std::istringstream ss(string);
-        std::string item;
-
-        while (std::getline(ss, item, SEPARATOR))
+        const char* tokenBegin;
+        const char* tokenEnd;
+        while (nextToken(begin, end, tokenBegin, tokenEnd))
         {
-            try 
-            {
-                m_value.push_back(std::stod(item));
-            }
-            catch (const std::invalid_argument&)
-            {
+            double value;
+            if (!parseDouble(tokenBegin, tokenEnd, value))
                 return false;
-            }
+
+            m_value.push_back(value);
         }
 
         return true;
@@ -369,20 +372,20 @@ namespace rlib
             REPORT_PANIC("Index out of range in StringArrayParameter::setValue");
 
         m_value[idx] = value;
+        valueChanged();
     }
 
-    bool StringArrayParameter::fromString(const std::string& string)
+    bool StringArrayParameter::fromChars(const char* begin, const char* end)
     {
         if (!isValid()) REPORT_PANIC("Invalid StringArrayParameter");
+        ValueChangeScope scope(*this);
 
         m_value.clear();
-        std::istringstream ss(string);
-        std::string item;
 
-        while (std::getline(ss, item, SEPARATOR))
-        {
-            m_value.push_back(item);
-        }
+        const char* tokenBegin;
+        const char* tokenEnd;
+        while (nextToken(begin, end, tokenBegin, tokenEnd))
+            m_value.push_back(std::string(tokenBegin, tokenEnd));
 
         return true;
     }
@@ -419,33 +422,25 @@ namespace rlib
             REPORT_PANIC("Index out of range in BoolArrayParameter::setValue");
 
         m_value[idx] = value;
+        valueChanged();
     }
     
-    bool BoolArrayParameter::fromString(const std::string& string)
+    bool BoolArrayParameter::fromChars(const char* begin, const char* end)
     {
         if (!isValid()) REPORT_PANIC("Invalid BoolArrayParameter");
+        ValueChangeScope scope(*this);
 
         m_value.clear();
-        std::istringstream ss(string);
-        std::string item;
 
-        while (std::getline(ss, item, SEPARATOR))
+        const char* tokenBegin;
+        const char* tokenEnd;
+        while (nextToken(begin, end, tokenBegin, tokenEnd))
         {
-            std::string lowerItem = item;
-            std::transform(lowerItem.begin(), lowerItem.end(), lowerItem.begin(), ::tolower);
-
-            if (lowerItem == "true" || lowerItem == "1")
-            {
-                m_value.push_back(true);
-            }
-            else if (lowerItem == "false" || lowerItem == "0")
-            {
-                m_value.push_back(false);
-            }
-            else
-            {
+            bool value;
+            if (!parseBool(tokenBegin, tokenEnd, value))
                 return false;
-            }
+
+            m_value.push_back(value);
         }
 
         return true;
@@ -469,24 +464,40 @@ namespace rlib
         return ss.str();
     }
 
-    bool MdpStateTransitionDefParameter::fromString(const std::string& string)
+    bool MdpStateTransitionDefParameter::fromChars(const char* begin, const char* end)
     {
         if (!isValid()) REPORT_PANIC("Invalid MdpStateTransitionDefParameter");
+        ValueChangeScope scope(*this);
+
+        const char* tokenBegin[6];
+        const char* tokenEnd[6];
+        size_t numTokens = 0;
 
-        std::istringstream ss(string);
-        std::string item;
-        std::vector<std::string> tokens;
+        while (numTokens < 6 && nextToken(begin, end, tokenBegin[numTokens], tokenEnd[numTokens]))
+            ++numTokens;
 
-        while (std::getline(ss, item, SEPARATOR))
-            tokens.push_back(item);
+        if (numTokens != 4 && numTokens != 5)
+            return false;
+
+        // The action is optional, transitions without one belong to action 0
+        const size_t first = numTokens - 4;
+
+        int stateID;
+        int actionID = 0;
+        int nextStateID;
+        double probability;
+        double cost;
 
-        if (tokens.size() != 4)
+        if (!parseInt(tokenBegin[0], tokenEnd[0], stateID) || (first > 0 && !parseInt(tokenBegin[1], tokenEnd[1], actionID))
+            || !parseInt(tokenBegin[first + 1], tokenEnd[first + 1], nextStateID) || !parseDouble(tokenBegin[first + 2], tokenEnd[first + 2], probability)
+            || !parseDouble(tokenBegin[first + 3], tokenEnd[first + 3], cost))
             return false;
 
-        m_stateID = std::stoi(tokens[0]);
-        m_nextStateID = std::stoi(tokens[1]);
-        m_probability = std::stod(tokens[2]);
-        m_cost = std::stod(tokens[3]);
+        m_stateID = stateID;
+        m_actionID = actionID;
+        m_nextStateID = nextStateID;
+        m_probability = probability;
+        m_cost = cost;
 
         return true;
     }
@@ -496,8 +507,157 @@ namespace rlib
         if (!isValid()) REPORT_PANIC("Invalid MdpStateTransitionDefParameter");
 
         std::ostringstream ss;
-        ss << m_stateID << SEPARATOR << m_nextStateID << SEPARATOR << m_probability << SEPARATOR << m_cost;
+        ss << m_stateID << SEPARATOR;
+
+        if (m_actionID != 0)
+            ss << m_actionID << SEPARATOR;
+
+        ss << m_nextStateID << SEPARATOR << m_probability << SEPARATOR << m_cost;
 
         return ss.str();
     }
+
+    void IntParameter::appendBinary(std::string& out) const { appendBinaryValue(out, m_value); }
+
+    bool IntParameter::fromBinary(const char* begin, const char* end)
+    {
+        ValueChangeScope scope(*this);
+        return readBinaryValue(begin, end, m_value) && begin == end;
+    }
+
+    void UIntParameter::appendBinary(std::string& out) const { appendBinaryValue(out, m_value); }
+
+    bool UIntParameter::fromBinary(const char* begin, const char* end)
+    {
+        ValueChangeScope scope(*this);
+        return readBinaryValue(begin, end, m_value) && begin == end;
+    }
+
+    void FloatParameter::appendBinary(std::string& out) const { appendBinaryValue(out, m_value); }
+
+    bool FloatParameter::fromBinary(const char* begin, const char* end)
+    {
+        ValueChangeScope scope(*this);
+        return readBinaryValue(begin, end, m_value) && begin == end;
+    }
+
+    void DoubleParameter::appendBinary(std::string& out) const { appendBinaryValue(out, m_value); }
+
+    bool DoubleParameter::fromBinary(const char* begin, const char* end)
+    {
+        ValueChangeScope scope(*this);
+        return readBinaryValue(begin, end, m_value) && begin == end;
+    }
+
+    void StringParameter::appendBinary(std::string& out) const { out += m_value; }
+
+    bool StringParameter::fromBinary(const char* begin, const char* end)
+    {
+        ValueChangeScope scope(*this);
+        m_value.assign(begin, end);
+        return true;
+    }
+
+    void BoolParameter::appendBinary(std::string& out) const { out += m_value ? '\1' : '\0'; }
+
+    bool BoolParameter::fromBinary(const char* begin, const char* end)
+    {
+        ValueChangeScope scope(*this);
+        if (end - begin != 1 || static_cast<unsigned char>(*begin) > 1)
+            return false;
+
+        m_value = *begin != 0;
+        return true;
+    }
+
+    void IntArrayParameter::appendBinary(std::string& out) const { appendBinaryArray(out, m_value); }
+
+    bool IntArrayParameter::fromBinary(const char* begin, const char* end)
+    {
+        ValueChangeScope scope(*this);
+        return readBinaryArray(begin, end, m_value);
+    }
+
+    void FloatArrayParameter::appendBinary(std::string& out) const { appendBinaryArray(out, m_value); }
+
+    bool FloatArrayParameter::fromBinary(const char* begin, const char* end)
+    {
+        ValueChangeScope scope(*this);
+        return readBinaryArray(begin, end, m_value);
+    }
+
+    void DoubleArrayParameter::appendBinary(std::string& out) const { appendBinaryArray(out, m_value); }
+
+    bool DoubleArrayParameter::fromBinary(const char* begin, const char* end)
+    {
+        ValueChangeScope scope(*this);
+        return readBinaryArray(begin, end, m_value);
+    }
+
+    void StringArrayParameter::appendBinary(std::string& out) const
+    {
+        // Every string is prefixed with its length
+        for (const std::string& value : m_value)
+        {
+            appendBinaryValue(out, static_cast<uint32_t>(value.size()));
+            out += value;
+        }
+    }
+
+    bool StringArrayParameter::fromBinary(const char* begin, const char* end)
+    {
+        ValueChangeScope scope(*this);
+        m_value.clear();
+
+        while (begin < end)
+        {
+            uint32_t length;
+            if (!readBinaryValue(begin, end, length) || static_cast<size_t>(end - begin) < length)
+                return false;
+
+            m_value.push_back(std::string(begin, begin + length));
+            begin += length;
+        }
+
+        return true;
+    }
+
+    void BoolArrayParameter::appendBinary(std::string& out) const
+    {
+        for (size_t i = 0; i < m_value.size(); ++i)
+            out += m_value[i] ? '\1' : '\0';
+    }
+
+    bool BoolArrayParameter::fromBinary(const char* begin, const char* end)
+    {
+        ValueChangeScope scope(*this);
+        m_value.clear();
+        m_value.reserve(end - begin);
+
+        for (; begin < end; ++begin)
+        {
+            if (static_cast<unsigned char>(*begin) > 1)
+                return false;
+
+            m_value.push_back(*begin != 0);
+        }
+
+        return true;
+    }
+
+    void MdpStateTransitionDefParameter::appendBinary(std::string& out) const
+    {
+        appendBinaryValue(out, m_stateID);
+        appendBinaryValue(out, m_actionID);
+        appendBinaryValue(out, m_nextStateID);
+        appendBinaryValue(out, m_probability);
+        appendBinaryValue(out, m_cost);
+    }
+
+    bool MdpStateTransitionDefParameter::fromBinary(const char* begin, const char* end)
+    {
+        ValueChangeScope scope(*this);
+        return readBinaryValue(begin, end, m_stateID) && readBinaryValue(begin, end, m_actionID) && readBinaryValue(begin, end, m_nextStateID)
+            && readBinaryValue(begin, end, m_probability) && readBinaryValue(begin, end, m_cost) && begin == end;
+    }
 } // namespace rlib
\ No newline at end of file
@@ -27,10 +27,30 @@ namespace rlib
         kParamNumTypes
     };
 
+    class Parameter;
+
+    /*
+    Storage that Parameter objects can be views onto, e.g. the columns of a ParameterManager.
+    A bound parameter hands every change of its value to the storage, so that both always agree.
+    */
+    class ParameterStorage
+    {
+    public:
+        virtual ~ParameterStorage() = default;
+
+        /*
+        Stores the current value of a bound parameter.
+        Parameters:
+        - id: The id the parameter was bound with.
+        - param: The parameter whose value changed.
+        */
+        virtual void storeValue(uint32_t id, const Parameter& param) = 0;
+    };
+
     class Parameter
     {
     public:
-        Parameter(const std::string& name, const std::string& typeName, ParameterType type) : m_name(name), m_typeName(typeName), m_type(type) {}
+        Parameter(const std::string& name, const std::string& typeName, ParameterType type) : m_name(name), m_typeName(typeName), m_type(type), m_storage(nullptr), m_storageID(0) {}
         virtual ~Parameter() = default;
 
         /*
@@ -40,6 +60,14 @@ namespace rlib
         */
         virtual bool fromString(const std::string& string) = 0;
 
+        /*
+        Parses the parameter value from a character range, which needs not be null terminated, e.g. a line of a mapped file.
+        Never throws: the built in types parse the range in place, other types go through fromString().
+        Returns:
+        - true if parsing was successful, false otherwise.
+        */
+        virtual bool fromChars(const char* begin, const char* end) { return fromString(std::string(begin, end)); }
+
         /*
         Converts the parameter value to its string representation.
         Returns:
@@ -47,6 +75,21 @@ namespace rlib
         */
         virtual std::string getValueString() const = 0;
 
+        /*
+        Appends the value in the binary form stored by parameter snapshots, only meant to be read back by the same build.
+        The default form is the string representation.
+        Parameters:
+        - out: The buffer receiving the value.
+        */
+        virtual void appendBinary(std::string& out) const { out += getValueString(); }
+
+        /*
+        Reads the value from the binary form written by appendBinary().
+        Returns:
+        - true if the range holds a valid value, false otherwise.
+        */
+        virtual bool fromBinary(const char* begin, const char* end) { return fromChars(begin, end); }
+
         /*
         Checks if the parameter is valid.
         Returns:
@@ -54,12 +97,20 @@ namespace rlib
         */
         virtual bool isValid() const { return false; }
 
-        std::string getName() const { return m_name; }
-        std::string getTypeName() const { return m_typeName; }
+        const std::string& getName() const { return m_name; }
+        const std::string& getTypeName() const { return m_typeName; }
         ParameterType getType() const { return m_type; }
 
         void rename(const std::string& newName) { m_name = newName; }
 
+        /*
+        Makes the parameter a view onto a storage, which receives every later change of the value.
+        Parameters:
+        - storage: The storage, or nullptr to unbind the parameter.
+        - id: The id of the parameter in the storage.
+        */
+        void bindStorage(ParameterStorage* storage, uint32_t id) { m_storage = storage; m_storageID = id; }
+
         /*
         Converts a ParameterType to its string representation.
         Returns:
@@ -79,6 +130,27 @@ namespace rlib
         ParameterType m_type;
 
         bool isOfType(ParameterType type) const { return m_type == type; }
+
+        void valueChanged() const
+        {
+            if (m_storage != nullptr)
+                m_storage->storeValue(m_storageID, *this);
+        }
+
+        /*
+        Hands the value to the storage when leaving the scope, whatever the return path: parsers may modify the value and then fail.
+        */
+        class ValueChangeScope
+        {
+        public:
+            ValueChangeScope(const Parameter& param) : m_param(param) {}
+            ~ValueChangeScope() { m_param.valueChanged(); }
+        private:
+            const Parameter& m_param;
+        };
+    private:
+        ParameterStorage* m_storage;
+        uint32_t m_storageID;
     };
 
     class IntParameter : public Parameter
@@ -89,12 +161,15 @@ namespace rlib
         
         virtual ~IntParameter() override = default;
 
-        bool fromString(const std::string& string) override;
+        bool fromString(const std::string& string) override { return fromChars(string.data(), string.data() + string.size()); }
+        bool fromChars(const char* begin, const char* end) override;
         std::string getValueString() const override;
+        void appendBinary(std::string& out) const override;
+        bool fromBinary(const char* begin, const char* end) override;
         bool isValid() const override { return isOfType(ParameterType::kParamInt); }
 
         int getValue() const { return m_value; }
-        void setValue(int value) { m_value = value; }
+        void setValue(int value) { m_value = value; valueChanged(); }
     private:
         int m_value;
     };
@@ -107,12 +182,15 @@ namespace rlib
         
         virtual ~UIntParameter() override = default;
         
-        bool fromString(const std::string& string) override;
+        bool fromString(const std::string& string) override { return fromChars(string.data(), string.data() + string.size()); }
+        bool fromChars(const char* begin, const char* end) override;
         std::string getValueString() const override;
+        void appendBinary(std::string& out) const override;
+        bool fromBinary(const char* begin, const char* end) override;
         bool isValid() const override { return isOfType(ParameterType::kParamUInt); }
 
         uint32_t getValue() const { return m_value; }
-        void setValue(uint32_t value) { m_value = value; } 
+        void setValue(uint32_t value) { m_value = value; valueChanged(); } 
     private:
         uint32_t m_value;
     };
@@ -125,12 +203,15 @@ namespace rlib
         
         virtual ~FloatParameter() override = default;
 
-        bool fromString(const std::string& string) override;
+        bool fromString(const std::string& string) override { return fromChars(string.data(), string.data() + string.size()); }
+        bool fromChars(const char* begin, const char* end) override;
         std::string getValueString() const override;
+        void appendBinary(std::string& out) const override;
+        bool fromBinary(const char* begin, const char* end) override;
         bool isValid() const override { return isOfType(ParameterType::kParamFloat); }
 
         float getValue() const { return m_value; }
-        void setValue(float value) { m_value = value; }
+        void setValue(float value) { m_value = value; valueChanged(); }
     private:
         float m_value;
     };
@@ -143,12 +224,15 @@ namespace rlib
         
         virtual ~DoubleParameter() override = default;
 
-        bool fromString(const std::string& string) override;
+        bool fromString(const std::string& string) override { return fromChars(string.data(), string.data() + string.size()); }
+        bool fromChars(const char* begin, const char* end) override;
         std::string getValueString() const override;
+        void appendBinary(std::string& out) const override;
+        bool fromBinary(const char* begin, const char* end) override;
         bool isValid() const override { return isOfType(ParameterType::kParamDouble); }
 
         double getValue() const { return m_value; }
-        void setValue(double value) { m_value = value; }
+        void setValue(double value) { m_value = value; valueChanged(); }
     private:
         double m_value;
     };
@@ -161,12 +245,15 @@ namespace rlib
         
         virtual ~StringParameter() override = default;
 
-        bool fromString(const std::string& string) override;
+        bool fromString(const std::string& string) override { return fromChars(string.data(), string.data() + string.size()); }
+        bool fromChars(const char* begin, const char* end) override;
         std::string getValueString() const override;
+        void appendBinary(std::string& out) const override;
+        bool fromBinary(const char* begin, const char* end) override;
         bool isValid() const override { return isOfType(ParameterType::kParamString); }
 
         const std::string& getValue() const { return m_value; }
-        void setValue(const std::string& value) { m_value = value; }
+        void setValue(const std::string& value) { m_value = value; valueChanged(); }
     private:
         std::string m_value;
     };
@@ -179,12 +266,15 @@ namespace rlib
         
         virtual ~BoolParameter() override = default;
 
-        bool fromString(const std::string& string) override;
+        bool fromString(const std::string& string) override { return fromChars(string.data(), string.data() + string.size()); }
+        bool fromChars(const char* begin, const char* end) override;
         std::string getValueString() const override;
+        void appendBinary(std::string& out) const override;
+        bool fromBinary(const char* begin, const char* end) override;
         bool isValid() const override { return isOfType(ParameterType::kParamBool); }
 
         bool getValue() const { return m_value; }
-        void setValue(bool value) { m_value = value; }
+        void setValue(bool value) { m_value = value; valueChanged(); }
     private:
         bool m_value;
     };
@@ -197,8 +287,11 @@ namespace rlib
         
         virtual ~IntArrayParameter() override = default;
 
-        bool fromString(const std::string& string) override;
+        bool fromString(const std::string& string) override { return fromChars(string.data(), string.data() + string.size()); }
+        bool fromChars(const char* begin, const char* end) override;
         std::string getValueString() const override;
+        void appendBinary(std::string& out) const override;
+        bool fromBinary(const char* begin, const char* end) override;
         bool isValid() const override { return isOfType(ParameterType::kParamIntArray); }
 
         size_t getNumValues() const { return m_value.size(); }
@@ -216,8 +309,11 @@ namespace rlib
         
         virtual ~FloatArrayParameter() override = default;
 
-        bool fromString(const std::string& string) override;
+        bool fromString(const std::string& string) override { return fromChars(string.data(), string.data() + string.size()); }
+        bool fromChars(const char* begin, const char* end) override;
         std::string getValueString() const override;
+        void appendBinary(std::string& out) const override;
+        bool fromBinary(const char* begin, const char* end) override;
         bool isValid() const override { return isOfType(ParameterType::kParamFloatArray); }
 
         size_t getNumValues() const { return m_value.size(); }
@@ -235,8 +331,11 @@ namespace rlib
         
         virtual ~DoubleArrayParameter() override = default;
 
-        bool fromString(const std::string& string) override;
+        bool fromString(const std::string& string) override { return fromChars(string.data(), string.data() + string.size()); }
+        bool fromChars(const char* begin, const char* end) override;
         std::string getValueString() const override;
+        void appendBinary(std::string& out) const override;
+        bool fromBinary(const char* begin, const char* end) override;
         bool isValid() const override { return isOfType(ParameterType::kParamDoubleArray); }
 
         size_t getNumValues() const { return m_value.size(); }
@@ -254,8 +353,11 @@ namespace rlib
         
         virtual ~StringArrayParameter() override = default;
 
-        bool fromString(const std::string& string) override;
+        bool fromString(const std::string& string) override { return fromChars(string.data(), string.data() + string.size()); }
+        bool fromChars(const char* begin, const char* end) override;
         std::string getValueString() const override;
+        void appendBinary(std::string& out) const override;
+        bool fromBinary(const char* begin, const char* end) override;
         bool isValid() const override { return isOfType(ParameterType::kParamStringArray); }
 
         size_t getNumValues() const { return m_value.size(); }
@@ -273,8 +375,11 @@ namespace rlib
         
         virtual ~BoolArrayParameter() override = default;
 
-        bool fromString(const std::string& string) override;
+        bool fromString(const std::string& string) override { return fromChars(string.data(), string.data() + string.size()); }
+        bool fromChars(const char* begin, const char* end) override;
         std::string getValueString() const override;
+        void appendBinary(std::string& out) const override;
+        bool fromBinary(const char* begin, const char* end) override;
         bool isValid() const override { return isOfType(ParameterType::kParamBoolArray); }
 
         size_t getNumValues() const { return m_value.size(); }
@@ -284,38 +389,50 @@ namespace rlib
         std::vector<bool> m_value;
     };
 
+    /*
+    Definition of an MDP transition, either "state nextState probability cost" (action 0)
+    or "state action nextState probability cost".
+    */
     class MdpStateTransitionDefParameter : public Parameter
     {
     public:
         MdpStateTransitionDefParameter(const std::string& name) : Parameter(name, "mdpStateTransitionDef", ParameterType::kParamMdpStateTransitionDef),
         m_stateID(-1), 
+        m_actionID(0),
         m_nextStateID(-1),
         m_probability(0.0), 
         m_cost(0.0) {};
 
         MdpStateTransitionDefParameter(const std::string& name, const std::string& typeName) : Parameter(name, typeName, ParameterType::kParamMdpStateTransitionDef),
         m_stateID(-1), 
+        m_actionID(0),
         m_nextStateID(-1),
         m_probability(0.0), 
         m_cost(0.0) {};
         
         virtual ~MdpStateTransitionDefParameter() override = default;
 
-        bool fromString(const std::string& string) override;
+        bool fromString(const std::string& string) override { return fromChars(string.data(), string.data() + string.size()); }
+        bool fromChars(const char* begin, const char* end) override;
         std::string getValueString() const override;
+        void appendBinary(std::string& out) const override;
+        bool fromBinary(const char* begin, const char* end) override;
         bool isValid() const override { return isOfType(ParameterType::kParamMdpStateTransitionDef); }
 
         int getStateID() const { return m_stateID; }
+        int getActionID() const { return m_actionID; }
         int getNextStateID() const { return m_nextStateID; }
         real_t getProbability() const { return m_probability; }
         real_t getCost() const { return m_cost; }
 
-        void setStateID(int stateID) { m_stateID = stateID; }
-        void setNextStateID(int stateID) { m_nextStateID = stateID; }
-        void setProbability(real_t probability) { m_probability = probability; }
-        void setCost(real_t cost) { m_cost = cost; }
+        void setStateID(int stateID) { m_stateID = stateID; valueChanged(); }
+        void setActionID(int actionID) { m_actionID = actionID; valueChanged(); }
+        void setNextStateID(int stateID) { m_nextStateID = stateID; valueChanged(); }
+        void setProbability(real_t probability) { m_probability = probability; valueChanged(); }
+        void setCost(real_t cost) { m_cost = cost; valueChanged(); }
     private:
         int m_stateID;
+        int m_actionID;
         int m_nextStateID;
         real_t m_probability;
         real_t m_cost;
@@ -19,8 +19,11 @@ namespace rlib
 
     Parameter* ParameterFactory::makeParameter(const std::string& typeName, const std::string& name) const
     {
-        ParameterType type = getParameterType(typeName);
+        return makeParameter(getParameterType(typeName), typeName, name);
+    }
 
+    Parameter* ParameterFactory::makeParameter(ParameterType type, const std::string& typeName, const std::string& name)
+    {
         switch (type)
         {
         case ParameterType::kParamInt:                      return new IntParameter(name, typeName);
@@ -28,6 +28,11 @@ namespace rlib
         */
         void unregisterParameterType(const std::string& typeName) { m_typeMap.erase(typeName); }
 
+        /*
+        Checks if a parameter type name is registered.
+        */
+        bool hasParameterType(const std::string& typeName) const { return m_typeMap.find(typeName) != m_typeMap.end(); }
+
         /*
         Gets the ParameterType enum value for a given parameter type name.
         Parameters:
@@ -46,6 +51,17 @@ namespace rlib
         */
         Parameter* makeParameter(const std::string& typeName, const std::string& name) const;
 
+        /*
+        Creates a Parameter object of a type resolved by the caller, without looking up the type name.
+        Parameters:
+        - type: The ParameterType of the type name.
+        - typeName: The name of the parameter type.
+        - name: The name of the parameter.
+        Returns:
+        - A pointer to the created Parameter object.
+        */
+        static Parameter* makeParameter(ParameterType type, const std::string& typeName, const std::string& name);
+
     private:
         /*
         Registers the default parameter types.
@@ -1,78 +1,559 @@
 #include "ParameterManager.h"
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <stdexcept>
 #include "Debug.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
 
 namespace rlib
 {
-    ParameterManager::ParameterManager()
+    namespace
+    {
+        /*
+        Splits the next line off [p, end), without its line break.
+        */
+        bool nextLine(const char*& p, const char* end, const char*& outBegin, const char*& outEnd)
+        {
+            // Empty lines are skipped
+            for (;;)
+            {
+                if (p >= end)
+                    return false;
+
+                const char* lineEnd = static_cast<const char*>(memchr(p, '\n', end - p));
+                if (lineEnd == nullptr)
+                    lineEnd = end;
+
+                outBegin = p;
+                p = lineEnd + 1;
+
+                if (lineEnd > outBegin && lineEnd[-1] == '\r')
+                    --lineEnd;
+
+                outEnd = lineEnd;
+
+                if (outBegin < outEnd)
+                    return true;
+            }
+        }
+
+        const char kSnapshotMagic[8] = { 'R', 'L', 'I', 'B', 'P', 'R', 'M', '\0' };
+        const uint32_t kSnapshotVersion = 1;
+        const uint32_t kByteOrderMark = 0x01020304;
+
+        /*
+        Layout of the snapshot file: this header, the type name table, the parameter records, then the string pool holding
+        the type names and parameter names, and the pool of binary values. Every offset is relative to its pool.
+        */
+        struct SnapshotHeader
+        {
+            char magic[8];
+            uint32_t version;
+            uint32_t byteOrderMark;
+            uint32_t realSize;
+            uint32_t numTypeNames;
+            uint64_t numParameters;
+            uint64_t sourceSize;
+            uint64_t sourceHash;
+            uint64_t stringsSize;
+            uint64_t valuesSize;
+        };
+
+        struct SnapshotTypeName
+        {
+            uint32_t nameOffset;
+            uint32_t nameLength;
+            uint32_t type;
+            uint32_t padding;
+        };
+
+        struct SnapshotRecord
+        {
+            uint32_t typeNameIndex;
+            uint32_t nameLength;
+            uint64_t nameOffset;
+            uint64_t valueOffset;
+            uint64_t valueSize;
+        };
+
+        /*
+        Hashes a byte range 8 bytes at a time, used for the names and to detect changes to snapshot sources.
+        It is not meant to resist tampering.
+        */
+        uint64_t hashBytes(const char* data, size_t size)
+        {
+            const uint64_t kPrime = 0x100000001b3ULL;
+            uint64_t hash = 0xcbf29ce484222325ULL ^ size;
+
+            size_t i = 0;
+            for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t))
+            {
+                uint64_t word;
+                memcpy(&word, data + i, sizeof(word));
+
+                hash = (hash ^ word) * kPrime;
+                hash ^= hash >> 32;
+            }
+
+            for (; i < size; ++i)
+                hash = (hash ^ static_cast<unsigned char>(data[i])) * kPrime;
+
+            // Final avalanche so that every input bit reaches every output bit
+            hash ^= hash >> 33;
+            hash *= 0xff51afd7ed558ccdULL;
+            hash ^= hash >> 33;
+
+            return hash;
+        }
+
+        /*
+        Checks that [offset, offset + size) lies within a pool of the given size, without overflowing.
+        */
+        bool isInPool(uint64_t offset, uint64_t size, uint64_t poolSize)
+        {
+            return offset <= poolSize && size <= poolSize - offset;
+        }
+
+        size_t countLines(const char* p, const char* end)
+        {
+            size_t numLines = 1;
+            for (; (p = static_cast<const char*>(memchr(p, '\n', end - p))) != nullptr; ++p)
+                numLines++;
+
+            return numLines;
+        }
+
+        struct ChunkTypeTally
+        {
+            ParameterType type;
+            uint32_t count;                     // Parameters of the type name parsed in the chunk
+            uint32_t base;                      // Parameters of the type name registered before the chunk, set by the merge
+            uint32_t typeNameID;                // Set by the merge
+            size_t firstIndex;                  // Index in the chunk of the first parameter of the type name
+            std::unique_ptr<Parameter> scratch; // Parses the values of the type name in the chunk
+        };
+
+        struct ChunkIssue
+        {
+            const char* lineBegin;
+            const char* lineEnd;
+            const char* delimiter;      // nullptr for a line without delimiter, otherwise the value failed to parse
+            ChunkTypeTally* tally;
+            uint32_t ordinal;           // Parameters of the type name parsed before the line in the chunk
+        };
+
+        struct ParsedChunk
+        {
+            const char* begin;
+            const char* end;
+            bool hasUnknownType;
+
+            // Values of the chunk in their own columns, with the type name and slot of every parameter
+            ParameterStore store;
+            std::vector<ChunkTypeTally*> tallies;
+            std::vector<uint32_t> slots;
+            std::unordered_map<std::string, ChunkTypeTally> typeTallies;
+            std::vector<ChunkIssue> issues;
+
+            // Set by the merge
+            uint32_t slotOffsets[ParameterStore::kNumColumns];
+            uint32_t firstID;
+            size_t firstIndex;
+            size_t namesOffset;
+
+            std::string names;
+            std::vector<std::vector<uint32_t>> shardEntries;
+
+            ParsedChunk() : begin(nullptr), end(nullptr), hasUnknownType(false), firstID(0), firstIndex(0), namesOffset(0) {}
+        };
+
+        /*
+        Parses the lines of a chunk into the columns of the chunk, stopping at the first unknown type name.
+        */
+        void parseChunk(const ParameterFactory& factory, ParsedChunk& chunk)
+        {
+            std::string typeName;
+            ChunkTypeTally* tally = nullptr;
+
+            const char* p = chunk.begin;
+            const char* lineBegin;
+            const char* lineEnd;
+
+            while (nextLine(p, chunk.end, lineBegin, lineEnd))
+            {
+                const char* delimiter = static_cast<const char*>(memchr(lineBegin, ' ', lineEnd - lineBegin));
+                if (delimiter == nullptr)
+                {
+                    ChunkIssue issue = { lineBegin, lineEnd, nullptr, nullptr, 0 };
+                    chunk.issues.push_back(issue);
+                    continue;
+                }
+
+                if (tally == nullptr || typeName.size() != static_cast<size_t>(delimiter - lineBegin) || memcmp(typeName.data(), lineBegin, typeName.size()) != 0)
+                {
+                    typeName.assign(lineBegin, delimiter);
+
+                    auto it = chunk.typeTallies.find(typeName);
+                    if (it == chunk.typeTallies.end())
+                    {
+                        if (!factory.hasParameterType(typeName))
+                        {
+                            chunk.hasUnknownType = true;
+                            return;
+                        }
+
+                        ChunkTypeTally& newTally = chunk.typeTallies[typeName];
+                        newTally.type = factory.getParameterType(typeName);
+                        newTally.count = 0;
+                        newTally.base = 0;
+                        newTally.typeNameID = 0;
+                        newTally.firstIndex = 0;
+                        newTally.scratch.reset(ParameterFactory::makeParameter(newTally.type, typeName, std::string()));
+
+                        it = chunk.typeTallies.find(typeName);
+                    }
+
+                    tally = &it->second;
+                }
+
+                if (!tally->scratch->fromChars(delimiter + 1, lineEnd))
+                {
+                    ChunkIssue issue = { lineBegin, lineEnd, delimiter, tally, tally->count };
+                    chunk.issues.push_back(issue);
+                    continue;
+                }
+
+                if (tally->count == 0)
+                    tally->firstIndex = chunk.tallies.size();
+
+                tally->count++;
+                chunk.tallies.push_back(tally);
+                chunk.slots.push_back(chunk.store.append(*tally->scratch));
+            }
+        }
+    }
+
+    const size_t ParameterManager::kNumNameShards;
+    const uint32_t ParameterManager::kLazySlot;
+
+    ParameterManager::ParameterManager() : m_nameShards(kNumNameShards), m_numParametersOfType(static_cast<size_t>(ParameterType::kParamNumTypes), 0)
     {
         m_factory = new ParameterFactory();
     };
 
     ParameterManager::~ParameterManager()
     {
-        for (Parameter* param : m_parameters)
-            delete param;
+        for (Parameter* view : m_views)
+            delete view;
 
         delete m_factory;
     }
 
+    size_t ParameterManager::hashName(const char* name, size_t length)
+    {
+        return static_cast<size_t>(hashBytes(name, length));
+    }
+
     Parameter* ParameterManager::getParameter(size_t index) const
     {
-        if (index < m_parameters.size())
-            return m_parameters[index];
+        if (index < m_order.size())
+            return getView(m_order[index]);
 
         REPORT_PANIC("ParameterManager::getParameter: index out of range");
     }
 
     Parameter* ParameterManager::getParameter(const std::string& name) const
     {
-        for (Parameter* param : m_parameters)
+        const uint32_t id = findName(name);
+        return id != ParameterHandle::kInvalidID ? getView(id) : nullptr;
+    }
+
+    Parameter* ParameterManager::getParameter(ParameterHandle handle) const
+    {
+        getRecord(handle);
+        return getView(handle.getID());
+    }
+
+    ParameterHandle ParameterManager::findParameter(const std::string& name) const
+    {
+        return ParameterHandle(findName(name));
+    }
+
+    ParameterHandle ParameterManager::getHandle(size_t index) const
+    {
+        if (index >= m_order.size())
+            REPORT_PANIC("ParameterManager::getHandle: index out of range");
+
+        return ParameterHandle(m_order[index]);
+    }
+
+    void ParameterManager::getHandlesOfType(ParameterType type, std::vector<ParameterHandle>& outHandles) const
+    {
+        outHandles.clear();
+        outHandles.reserve(getNumParametersOfType(type));
+
+        for (uint32_t id : m_order)
+        {
+            if (static_cast<ParameterType>(m_records[id].type) == type)
+                outHandles.push_back(ParameterHandle(id));
+        }
+    }
+
+    std::string ParameterManager::getName(ParameterHandle handle) const
+    {
+        const Record& record = getRecord(handle);
+        return std::string(m_names.data() + record.nameOffset, record.nameLength);
+    }
+
+    std::string ParameterManager::getString(ParameterHandle handle) const
+    {
+        ParameterArrayView<char> value = m_store.getArray<char>(getSlot(handle, ParameterType::kParamString));
+        return std::string(value.begin(), value.end());
+    }
+
+    Parameter* ParameterManager::getView(uint32_t id) const
+    {
+        std::lock_guard<std::mutex> lock(m_viewMutex);
+        Parameter*& view = m_views[id];
+
+        if (view == nullptr)
         {
-            if (param->getName() == name)
-                return param;
+            const Record& record = m_records[id];
+            const TypeNameEntry& typeName = m_typeNameEntries[record.typeNameID];
+
+            view = ParameterFactory::makeParameter(typeName.type, typeName.name, std::string(m_names.data() + record.nameOffset, record.nameLength));
+            m_store.load(resolveSlot(id), *view);
+
+            // Views are handed out by const accessors, as the Parameter pointers always were, but they write to the columns
+            view->bindStorage(const_cast<ParameterManager*>(this), id);
         }
 
-        return nullptr;
+        return view;
+    }
+
+    void ParameterManager::storeValue(uint32_t id, const Parameter& param)
+    {
+        m_store.store(m_records[id].slot, param);
+    }
+
+    uint32_t ParameterManager::findName(const std::string& name) const
+    {
+        const size_t hash = hashName(name.data(), name.size());
+        const NameShard& shard = m_nameShards[getNameShard(hash)];
+
+        if (shard.size == 0)
+            return ParameterHandle::kInvalidID;
+
+        const size_t mask = shard.slots.size() - 1;
+        const uint32_t tag = static_cast<uint32_t>(hash);
+
+        for (size_t i = tag & mask; ; i = (i + 1) & mask)
+        {
+            const uint64_t slot = shard.slots[i];
+            if (slot == 0)
+                return ParameterHandle::kInvalidID;
+
+            const uint32_t id = static_cast<uint32_t>(slot) - 1;
+            if (static_cast<uint32_t>(slot >> 32) == tag && hasName(id, name.data(), name.size()))
+                return id;
+        }
+    }
+
+    void ParameterManager::insertName(size_t hash, uint32_t id)
+    {
+        NameShard& shard = m_nameShards[getNameShard(hash)];
+
+        // Linear probing stays short below half occupancy
+        if (2 * (shard.size + 1) > shard.slots.size())
+            reserveNames(shard, shard.size + 1);
+
+        const size_t mask = shard.slots.size() - 1;
+        const uint32_t tag = static_cast<uint32_t>(hash);
+        const Record& record = m_records[id];
+        const char* name = m_names.data() + record.nameOffset;
+
+        for (size_t i = tag & mask; ; i = (i + 1) & mask)
+        {
+            const uint64_t slot = shard.slots[i];
+            if (slot == 0)
+            {
+                shard.slots[i] = (static_cast<uint64_t>(tag) << 32) | (id + 1);
+                shard.size++;
+                return;
+            }
+
+            if (static_cast<uint32_t>(slot >> 32) == tag && hasName(static_cast<uint32_t>(slot) - 1, name, record.nameLength))
+                return;
+        }
+    }
+
+    void ParameterManager::reserveNames(NameShard& shard, size_t numNames)
+    {
+        size_t numSlots = shard.slots.empty() ? 16 : shard.slots.size();
+        while (numSlots < 2 * numNames)
+            numSlots *= 2;
+
+        if (numSlots == shard.slots.size())
+            return;
+
+        // The slots keep their hash tags, so they are moved without touching the names
+        std::vector<uint64_t> slots(numSlots, 0);
+        const size_t mask = numSlots - 1;
+
+        for (uint64_t slot : shard.slots)
+        {
+            if (slot == 0)
+                continue;
+
+            size_t i = static_cast<uint32_t>(slot >> 32) & mask;
+            while (slots[i] != 0)
+                i = (i + 1) & mask;
+
+            slots[i] = slot;
+        }
+
+        shard.slots.swap(slots);
+    }
+
+    void ParameterManager::clearNames()
+    {
+        for (size_t i = 0; i < m_nameShards.size(); ++i)
+        {
+            m_nameShards[i].slots.clear();
+            m_nameShards[i].size = 0;
+        }
     }
 
     Parameter* ParameterManager::getFirstParameterOfTypeName(const std::string& typeName) const
     {
-        for (Parameter* param : m_parameters)
+        auto it = m_typeNameIDs.find(typeName);
+        if (it == m_typeNameIDs.end() || m_typeNameEntries[it->second].count == 0)
+            return nullptr;
+
+        return getView(m_order[m_typeNameEntries[it->second].firstIndex]);
+    }
+
+    uint32_t ParameterManager::internTypeName(const std::string& typeName)
+    {
+        const ParameterType type = m_factory->getParameterType(typeName);
+
+        auto it = m_typeNameIDs.find(typeName);
+        if (it != m_typeNameIDs.end())
         {
-            if (param->getTypeName() == typeName)
-                return param;
+            TypeNameEntry& entry = m_typeNameEntries[it->second];
+
+            if (entry.type != type)
+            {
+                if (entry.count > 0)
+                    REPORT_PANIC("ParameterManager: type name " + typeName + " was registered again with another type while it has parameters");
+
+                entry.type = type;
+                entry.scratch.reset(ParameterFactory::makeParameter(type, typeName, std::string()));
+            }
+
+            return it->second;
         }
 
-        return nullptr;
+        // Names are typeName_N, the record stores their length on 16 bits
+        if (typeName.size() > UINT16_MAX - 16)
+            REPORT_PANIC("ParameterManager: type name too long: " + typeName.substr(0, 64));
+
+        TypeNameEntry entry;
+        entry.name = typeName;
+        entry.type = type;
+        entry.firstIndex = 0;
+        entry.count = 0;
+        entry.scratch.reset(ParameterFactory::makeParameter(type, typeName, std::string()));
+
+        m_typeNameEntries.push_back(std::move(entry));
+        m_typeNameIDs.insert(std::make_pair(typeName, static_cast<uint32_t>(m_typeNameEntries.size() - 1)));
+
+        return static_cast<uint32_t>(m_typeNameEntries.size() - 1);
+    }
+
+    uint32_t ParameterManager::addRecord(uint32_t typeNameID, const char* name, size_t nameLength, const Parameter* value)
+    {
+        // Every parameter has at most one slot per column, so slots stay below kLazySlot
+        if (nameLength > UINT16_MAX || m_names.size() + nameLength > UINT32_MAX || m_records.size() >= kLazySlot)
+            REPORT_PANIC("ParameterManager: too many parameters or parameter name too long");
+
+        Record record;
+        record.nameOffset = static_cast<uint32_t>(m_names.size());
+        record.slot = value != nullptr ? m_store.append(*value) : kLazySlot;
+        record.typeNameID = typeNameID;
+        record.nameLength = static_cast<uint16_t>(nameLength);
+        record.type = static_cast<uint8_t>(m_typeNameEntries[typeNameID].type);
+        record.isRemoved = 0;
+
+        m_names.append(name, nameLength);
+        m_records.push_back(record);
+        m_views.push_back(nullptr);
+        m_order.push_back(static_cast<uint32_t>(m_records.size() - 1));
+
+        return static_cast<uint32_t>(m_records.size() - 1);
+    }
+
+    void ParameterManager::indexParameter(size_t index)
+    {
+        const uint32_t id = m_order[index];
+        const Record& record = m_records[id];
+
+        insertName(hashName(m_names.data() + record.nameOffset, record.nameLength), id);
+
+        TypeNameEntry& entry = m_typeNameEntries[record.typeNameID];
+        if (entry.count++ == 0)
+            entry.firstIndex = index;
+
+        m_numParametersOfType[record.type]++;
     }
 
     Parameter* ParameterManager::registerParameter(const std::string& typeName, const std::string& valueStr)
     {
-        std::string paramName = typeName + "_" + std::to_string(getNumParametersOfTypeName(typeName) + 1);
+        const uint32_t id = registerParameter(internTypeName(typeName), valueStr.data(), valueStr.data() + valueStr.size());
+        return id != ParameterHandle::kInvalidID ? getView(id) : nullptr;
+    }
+
+    uint32_t ParameterManager::registerParameter(uint32_t typeNameID, const char* valueBegin, const char* valueEnd)
+    {
+        TypeNameEntry& typeName = m_typeNameEntries[typeNameID];
+        std::string paramName = typeName.name + "_" + std::to_string(typeName.count + 1);
 
-        Parameter* param = m_factory->makeParameter(typeName, paramName);
-        if (!param->fromString(valueStr))
+        if (!typeName.scratch->fromChars(valueBegin, valueEnd))
         {
-            delete param;
-            LOG_ERROR("Failed to parse parameter '%s' from string '%s'\n", paramName.c_str(), valueStr.c_str());
+            LOG_ERROR("Failed to parse parameter '%s' from string '%.*s'\n", paramName.c_str(), static_cast<int>(valueEnd - valueBegin), valueBegin);
             
-            return nullptr;
+            return ParameterHandle::kInvalidID;
         }
 
-        LOG_DEBUG("Registered parameter: name='%s', typeName='%s', type='%s', value='%s'\n", param->getName().c_str(), param->getTypeName().c_str(), Parameter::parameterTypeAsString(param->getType()), valueStr.c_str());
-        m_parameters.push_back(param);
+        LOG_DEBUG("Registered parameter: name='%s', typeName='%s', type='%s', value='%.*s'\n", paramName.c_str(), typeName.name.c_str(), Parameter::parameterTypeAsString(typeName.type), static_cast<int>(valueEnd - valueBegin), valueBegin);
 
-        return param;
+        const uint32_t id = addRecord(typeNameID, paramName.data(), paramName.size(), typeName.scratch.get());
+        indexParameter(m_order.size() - 1);
+
+        return id;
     }
 
     void ParameterManager::unregisterParameter(size_t index)
     {
-        if (index < m_parameters.size())
+        if (index < m_order.size())
         {
-            delete m_parameters[index];
-            m_parameters.erase(m_parameters.begin() + index);
+            const uint32_t id = m_order[index];
+
+            m_records[id].isRemoved = 1;
+            delete m_views[id];
+            m_views[id] = nullptr;
+            m_order.erase(m_order.begin() + index);
+
+            // The indices of the following parameters changed, the indexes are rebuilt in registration order
+            clearNames();
+            for (TypeNameEntry& entry : m_typeNameEntries)
+                entry.count = 0;
+            std::fill(m_numParametersOfType.begin(), m_numParametersOfType.end(), 0);
+
+            for (size_t i = 0; i < m_order.size(); ++i)
+                indexParameter(i);
 
             return;
         }
@@ -80,72 +561,587 @@ namespace rlib
         REPORT_PANIC("ParameterManager::unregisterParameter: index out of range");
     }
 
-    bool ParameterManager::loadFromFile(const std::string& filename)
+    bool ParameterManager::loadFromFile(const std::string& filename, unsigned numThreads)
     {
-        std::ifstream file(filename);
-        if (!file.is_open())
+        // The file is mapped and tokenized in place: no line or value is copied before it reaches the parameter parsers
+        MappedFile file;
+        if (!file.open(filename))
         {
             REPORT_PANIC("ParameterManager::loadFromFile: failed to open file " + filename);
             return false;
         }
 
-        int numberOfLoadedParameters = 0;
+        const size_t numParametersBefore = m_order.size();
+        if (!loadFromBuffer(file.getData(), file.getSize(), numThreads))
+            REPORT_PANIC("ParameterManager::loadFromFile: unknown parameter type in file " + filename);
+
+        LOG_DEBUG("Successfully loaded %zu parameters from file '%s'\n", m_order.size() - numParametersBefore, filename.c_str());
+        
+        return true;
+    }
+
+    bool ParameterManager::loadFromBuffer(const char* data, size_t size, unsigned numThreads)
+    {
+        if (numThreads == 1)
+            return loadSequential(data, data + size);
+
+        return loadParallel(data, data + size, numThreads);
+    }
 
-        std::string line;
-        while (std::getline(file, line))
+    bool ParameterManager::loadFromFileLazy(const std::string& filename)
+    {
+        std::unique_ptr<MappedFile> file(new MappedFile());
+        if (!file->open(filename))
+            return false;
+
+        const char* p = file->getData();
+        const char* end = p + file->getSize();
+        const size_t numLines = countLines(p, end);
+        const size_t numParametersBefore = m_order.size();
+
+        m_records.reserve(m_records.size() + numLines);
+        m_views.reserve(m_views.size() + numLines);
+        m_order.reserve(m_order.size() + numLines);
+        m_lazyValues.reserve(m_lazyValues.size() + numLines);
+        for (size_t i = 0; i < m_nameShards.size(); ++i)
+            reserveNames(m_nameShards[i], m_nameShards[i].size + numLines / kNumNameShards);
+
+        std::string typeName;
+        uint32_t typeNameID = ParameterHandle::kInvalidID;
+        std::string paramName;
+
+        const char* lineBegin;
+        const char* lineEnd;
+        while (nextLine(p, end, lineBegin, lineEnd))
         {
-            if (line.empty()) 
+            const char* delimiter = static_cast<const char*>(memchr(lineBegin, ' ', lineEnd - lineBegin));
+            if (delimiter == nullptr)
+            {
+                LOG_WARNING("Skipping invalid line (no delimiter found): %.*s\n", static_cast<int>(lineEnd - lineBegin), lineBegin);
                 continue;
+            }
 
-            std::string typeName;
-            std::string valueStr;
-            
-            size_t delimiterPos = line.find(' ');
-            if (delimiterPos == std::string::npos)
+            if (typeNameID == ParameterHandle::kInvalidID || typeName.size() != static_cast<size_t>(delimiter - lineBegin) || memcmp(typeName.data(), lineBegin, typeName.size()) != 0)
+            {
+                typeName.assign(lineBegin, delimiter);
+                typeNameID = internTypeName(typeName);
+            }
+
+            paramName = typeName;
+            paramName += '_';
+            paramName += std::to_string(m_typeNameEntries[typeNameID].count + 1);
+
+            const uint32_t id = addRecord(typeNameID, paramName.data(), paramName.size(), nullptr);
+            LazyValue value = { delimiter + 1, lineEnd };
+
+            m_records[id].slot = kLazySlot | static_cast<uint32_t>(m_lazyValues.size());
+            m_lazyValues.push_back(value);
+            indexParameter(m_order.size() - 1);
+        }
+
+        m_lazySources.push_back(std::move(file));
+
+        LOG_DEBUG("Indexed %zu parameters from file '%s'\n", m_order.size() - numParametersBefore, filename.c_str());
+
+        return true;
+    }
+
+    uint32_t ParameterManager::parseLazyValue(uint32_t id) const
+    {
+        Record& record = m_records[id];
+        const LazyValue& value = m_lazyValues[record.slot & ~kLazySlot];
+        Parameter& scratch = *m_typeNameEntries[record.typeNameID].scratch;
+
+        if (scratch.fromChars(value.begin, value.end))
+        {
+            record.slot = m_store.append(scratch);
+        }
+        else
+        {
+            LOG_ERROR("Failed to parse parameter '%.*s' from string '%.*s'\n", static_cast<int>(record.nameLength), m_names.data() + record.nameOffset,
+                static_cast<int>(value.end - value.begin), value.begin);
+
+            // The parameter was named when the file was indexed, it keeps the default value of its type
+            std::unique_ptr<Parameter> defaultValue(ParameterFactory::makeParameter(scratch.getType(), std::string(), std::string()));
+            record.slot = m_store.append(*defaultValue);
+        }
+
+        return record.slot;
+    }
+
+    bool ParameterManager::loadSequential(const char* p, const char* end)
+    {
+        // Counting the lines first is a fast scan, and sizing the indexes up front saves rehashing them while loading
+        const size_t numLines = countLines(p, end);
+
+        m_records.reserve(m_records.size() + numLines);
+        m_views.reserve(m_views.size() + numLines);
+        m_order.reserve(m_order.size() + numLines);
+        for (size_t i = 0; i < m_nameShards.size(); ++i)
+            reserveNames(m_nameShards[i], m_nameShards[i].size + numLines / kNumNameShards);
+
+        // Consecutive lines mostly share their type name, which is only looked up when it changes
+        std::string typeName;
+        uint32_t typeNameID = ParameterHandle::kInvalidID;
+
+        const char* lineBegin;
+        const char* lineEnd;
+        while (nextLine(p, end, lineBegin, lineEnd))
+        {
+            const char* delimiter = static_cast<const char*>(memchr(lineBegin, ' ', lineEnd - lineBegin));
+            if (delimiter == nullptr)
             {
-                LOG_WARNING("Skipping invalid line (no delimiter found): %s\n", line.c_str());
+                LOG_WARNING("Skipping invalid line (no delimiter found): %.*s\n", static_cast<int>(lineEnd - lineBegin), lineBegin);
                 continue;
             }
 
-            typeName = line.substr(0, delimiterPos);
-            valueStr = line.substr(delimiterPos + 1);
+            if (typeNameID == ParameterHandle::kInvalidID || typeName.size() != static_cast<size_t>(delimiter - lineBegin) || memcmp(typeName.data(), lineBegin, typeName.size()) != 0)
+            {
+                typeName.assign(lineBegin, delimiter);
+
+                if (!m_factory->hasParameterType(typeName))
+                {
+                    LOG_ERROR("Unknown parameter type: %s\n", typeName.c_str());
+                    return false;
+                }
 
-            registerParameter(typeName, valueStr);
+                typeNameID = internTypeName(typeName);
+            }
 
-            numberOfLoadedParameters++;
+            registerParameter(typeNameID, delimiter + 1, lineEnd);
         }
 
-        file.close();
+        return true;
+    }
+
+    bool ParameterManager::loadParallel(const char* data, const char* end, unsigned numThreads)
+    {
+        ThreadPool pool(numThreads);
+        const size_t numChunks = pool.getNumThreads();
+
+        // Line aligned chunks: a chunk starts after the first line break at or after its nominal start
+        std::vector<ParsedChunk> chunks(numChunks);
+        const size_t size = end - data;
+
+        for (size_t c = 0; c < numChunks; ++c)
+        {
+            const char* nominalStart = data + size * c / numChunks;
+            const char* lineBreak = c > 0 ? static_cast<const char*>(memchr(nominalStart - 1, '\n', end - nominalStart + 1)) : nullptr;
+
+            chunks[c].begin = c == 0 ? data : (lineBreak != nullptr ? lineBreak + 1 : end);
+        }
+
+        for (size_t c = 0; c < numChunks; ++c)
+            chunks[c].end = c + 1 < numChunks ? chunks[c + 1].begin : end;
+
+        // First pass, in parallel: parse the lines of every chunk into the columns of the chunk, counting them by type name
+        pool.parallelFor(numChunks, [&](size_t begin, size_t endChunk, unsigned)
+        {
+            for (size_t c = begin; c < endChunk; ++c)
+                parseChunk(*m_factory, chunks[c]);
+        });
+
+        for (size_t c = 0; c < numChunks; ++c)
+        {
+            // Loading sequentially reports the unknown type at the right line, with the previous parameters registered
+            if (chunks[c].hasUnknownType)
+                return loadSequential(data, end);
+        }
+
+        // Merge, sequential: the columns of the chunks are appended in order, and the first index, count and name base of every
+        // type name in every chunk follow from the previous chunks. The issues are reported in file order
+        uint32_t nextID = static_cast<uint32_t>(m_records.size());
+        size_t nextIndex = m_order.size();
+
+        for (size_t c = 0; c < numChunks; ++c)
+        {
+            ParsedChunk& chunk = chunks[c];
+            chunk.firstID = nextID;
+            chunk.firstIndex = nextIndex;
+            nextID += static_cast<uint32_t>(chunk.tallies.size());
+            nextIndex += chunk.tallies.size();
+
+            m_store.append(chunk.store, chunk.slotOffsets);
+            chunk.store.clear();
+
+            for (auto& tallyEntry : chunk.typeTallies)
+            {
+                ChunkTypeTally& tally = tallyEntry.second;
+                tally.typeNameID = internTypeName(tallyEntry.first);
+
+                TypeNameEntry& entry = m_typeNameEntries[tally.typeNameID];
+                tally.base = entry.count;
+
+                if (tally.count == 0)
+                    continue;
+
+                if (entry.count == 0)
+                    entry.firstIndex = chunk.firstIndex + tally.firstIndex;
+
+                entry.count += tally.count;
+                m_numParametersOfType[static_cast<size_t>(tally.type)] += tally.count;
+            }
+
+            for (const ChunkIssue& issue : chunk.issues)
+            {
+                if (issue.delimiter == nullptr)
+                {
+                    LOG_WARNING("Skipping invalid line (no delimiter found): %.*s\n", static_cast<int>(issue.lineEnd - issue.lineBegin), issue.lineBegin);
+                    continue;
+                }
+
+                const std::string paramName = std::string(issue.lineBegin, issue.delimiter) + "_" + std::to_string(issue.tally->base + issue.ordinal + 1);
+                LOG_ERROR("Failed to parse parameter '%s' from string '%.*s'\n", paramName.c_str(), static_cast<int>(issue.lineEnd - issue.delimiter - 1), issue.delimiter + 1);
+            }
+        }
+
+        if (nextID >= kLazySlot)
+            REPORT_PANIC("ParameterManager: too many parameters");
+
+        m_records.resize(nextID);
+        m_views.resize(nextID, nullptr);
+        m_order.resize(nextIndex);
+
+        // Second pass, in parallel: name the parameters of every chunk in a pool of the chunk and fill their records
+        pool.parallelFor(numChunks, [&](size_t begin, size_t endChunk, unsigned)
+        {
+            for (size_t c = begin; c < endChunk; ++c)
+            {
+                ParsedChunk& chunk = chunks[c];
+
+                for (auto& tallyEntry : chunk.typeTallies)
+                    tallyEntry.second.count = 0;
+
+                for (size_t i = 0; i < chunk.tallies.size(); ++i)
+                {
+                    ChunkTypeTally* tally = chunk.tallies[i];
+                    const std::string& typeName = m_typeNameEntries[tally->typeNameID].name;
+
+                    Record& record = m_records[chunk.firstID + i];
+                    record.nameOffset = static_cast<uint32_t>(chunk.names.size());
+                    record.slot = chunk.slotOffsets[static_cast<size_t>(tally->type)] + chunk.slots[i];
+                    record.typeNameID = tally->typeNameID;
+                    record.type = static_cast<uint8_t>(tally->type);
+                    record.isRemoved = 0;
+
+                    chunk.names += typeName;
+                    chunk.names += '_';
+                    chunk.names += std::to_string(tally->base + ++tally->count);
+                    record.nameLength = static_cast<uint16_t>(chunk.names.size() - record.nameOffset);
+
+                    m_order[chunk.firstIndex + i] = chunk.firstID + static_cast<uint32_t>(i);
+                }
+            }
+        });
+
+        size_t namesSize = m_names.size();
+        for (size_t c = 0; c < numChunks; ++c)
+        {
+            chunks[c].namesOffset = namesSize;
+            namesSize += chunks[c].names.size();
+        }
+
+        if (namesSize > UINT32_MAX)
+            REPORT_PANIC("ParameterManager: too many parameters");
+
+        m_names.resize(namesSize);
+
+        // Third pass, in parallel: move the names into the pool and bucket the parameters by name shard
+        pool.parallelFor(numChunks, [&](size_t begin, size_t endChunk, unsigned)
+        {
+            for (size_t c = begin; c < endChunk; ++c)
+            {
+                ParsedChunk& chunk = chunks[c];
+
+                if (!chunk.names.empty())
+                    memcpy(&m_names[chunk.namesOffset], chunk.names.data(), chunk.names.size());
+
+                chunk.shardEntries.resize(kNumNameShards);
+
+                for (size_t i = 0; i < chunk.tallies.size(); ++i)
+                {
+                    Record& record = m_records[chunk.firstID + i];
+                    record.nameOffset += static_cast<uint32_t>(chunk.namesOffset);
+
+                    chunk.shardEntries[getNameShard(hashName(m_names.data() + record.nameOffset, record.nameLength))].push_back(chunk.firstID + static_cast<uint32_t>(i));
+                }
+            }
+        });
+
+        // Fourth pass, in parallel over the shards: every shard receives its names in file order
+        pool.parallelFor(kNumNameShards, [&](size_t begin, size_t endShard, unsigned)
+        {
+            for (size_t s = begin; s < endShard; ++s)
+            {
+                size_t numEntries = m_nameShards[s].size;
+                for (size_t c = 0; c < numChunks; ++c)
+                    numEntries += chunks[c].shardEntries[s].size();
+
+                reserveNames(m_nameShards[s], numEntries);
+
+                for (size_t c = 0; c < numChunks; ++c)
+                {
+                    for (uint32_t id : chunks[c].shardEntries[s])
+                    {
+                        const Record& record = m_records[id];
+                        insertName(hashName(m_names.data() + record.nameOffset, record.nameLength), id);
+                    }
+                }
+            }
+        });
 
-        LOG_DEBUG("Successfully loaded %d parameters from file '%s'\n", numberOfLoadedParameters, filename.c_str());
-        
         return true;
     }
 
-    uint32_t ParameterManager::getNumParametersOfTypeName(const std::string& typeName) const
+    bool ParameterManager::loadFromFileCached(const std::string& filename, const std::string& snapshotFilename, unsigned numThreads)
     {
-        uint32_t count = 0;
+        const bool isEmpty = m_order.empty();
 
-        for (Parameter* param : m_parameters)
+        // A missing snapshot is the normal cold start, it is not worth an error from the mapping
+        if (isEmpty && std::ifstream(snapshotFilename).good() && loadSnapshot(snapshotFilename, filename))
+            return true;
+
+        if (!loadFromFile(filename, numThreads))
+            return false;
+
+        if (isEmpty)
+            saveSnapshot(snapshotFilename, filename);
+
+        return true;
+    }
+
+    bool ParameterManager::saveSnapshot(const std::string& filename, const std::string& sourceFilename) const
+    {
+        MappedFile source;
+        if (!source.open(sourceFilename))
+            return false;
+
+        SnapshotHeader header = {};
+        std::copy(kSnapshotMagic, kSnapshotMagic + sizeof(kSnapshotMagic), header.magic);
+        header.version = kSnapshotVersion;
+        header.byteOrderMark = kByteOrderMark;
+        header.realSize = sizeof(real_t);
+        header.numParameters = m_order.size();
+        header.sourceSize = source.getSize();
+        header.sourceHash = hashBytes(source.getData(), source.getSize());
+
+        std::vector<SnapshotTypeName> typeNames;
+        std::vector<SnapshotRecord> records(m_order.size());
+        std::vector<uint32_t> typeNameIndices(m_typeNameEntries.size(), UINT32_MAX);
+        std::string strings;
+        std::string values;
+
+        for (size_t i = 0; i < m_order.size(); ++i)
+        {
+            const Record& record = m_records[m_order[i]];
+            uint32_t& typeNameIndex = typeNameIndices[record.typeNameID];
+
+            if (typeNameIndex == UINT32_MAX)
+            {
+                const TypeNameEntry& entry = m_typeNameEntries[record.typeNameID];
+                SnapshotTypeName typeName = { static_cast<uint32_t>(strings.size()), static_cast<uint32_t>(entry.name.size()), static_cast<uint32_t>(entry.type), 0 };
+
+                typeNameIndex = static_cast<uint32_t>(typeNames.size());
+                typeNames.push_back(typeName);
+                strings += entry.name;
+            }
+
+            SnapshotRecord& snapshotRecord = records[i];
+            snapshotRecord.typeNameIndex = typeNameIndex;
+            snapshotRecord.nameLength = record.nameLength;
+            snapshotRecord.nameOffset = strings.size();
+            strings.append(m_names.data() + record.nameOffset, record.nameLength);
+
+            snapshotRecord.valueOffset = values.size();
+            m_store.appendBinary(static_cast<ParameterType>(record.type), resolveSlot(m_order[i]), values);
+            snapshotRecord.valueSize = values.size() - snapshotRecord.valueOffset;
+        }
+
+        header.numTypeNames = static_cast<uint32_t>(typeNames.size());
+        header.stringsSize = strings.size();
+        header.valuesSize = values.size();
+
+        std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+        if (!file.is_open())
+        {
+            LOG_ERROR("ParameterManager::saveSnapshot: failed to open file '%s'\n", filename.c_str());
+            return false;
+        }
+
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(typeNames.data()), typeNames.size() * sizeof(SnapshotTypeName));
+        file.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(SnapshotRecord));
+        file.write(strings.data(), strings.size());
+        file.write(values.data(), values.size());
+
+        if (!file.good())
         {
-            if (param->getTypeName() == typeName)
-                count++;
+            LOG_ERROR("ParameterManager::saveSnapshot: failed to write file '%s'\n", filename.c_str());
+            return false;
         }
 
-        return count;
+        return true;
     }
 
-    uint32_t ParameterManager::getNumParametersOfType(ParameterType type) const
+    bool ParameterManager::loadSnapshot(const std::string& filename, const std::string& sourceFilename)
     {
-        uint32_t count = 0;
+        if (!m_order.empty())
+        {
+            LOG_ERROR("ParameterManager::loadSnapshot: file '%s' can only be restored into an empty manager\n", filename.c_str());
+            return false;
+        }
+
+        MappedFile file;
+        if (!file.open(filename))
+            return false;
+
+        if (file.getSize() < sizeof(SnapshotHeader))
+        {
+            LOG_ERROR("ParameterManager::loadSnapshot: file '%s' is too small to be a snapshot\n", filename.c_str());
+            return false;
+        }
+
+        SnapshotHeader header;
+        memcpy(&header, file.getData(), sizeof(header));
+
+        if (!std::equal(kSnapshotMagic, kSnapshotMagic + sizeof(kSnapshotMagic), header.magic))
+        {
+            LOG_ERROR("ParameterManager::loadSnapshot: file '%s' is not a snapshot\n", filename.c_str());
+            return false;
+        }
+
+        if (header.version != kSnapshotVersion || header.byteOrderMark != kByteOrderMark || header.realSize != sizeof(real_t))
+        {
+            LOG_ERROR("ParameterManager::loadSnapshot: file '%s' has version %u and was written by an incompatible build\n", filename.c_str(), header.version);
+            return false;
+        }
+
+        // The sections must exactly fill the file, checked piecewise so that corrupted counts cannot overflow
+        const uint64_t payloadSize = file.getSize() - sizeof(SnapshotHeader);
+        const uint64_t tableSize = static_cast<uint64_t>(header.numTypeNames) * sizeof(SnapshotTypeName);
 
-        for (Parameter* param : m_parameters)
+        if (tableSize > payloadSize || header.numParameters > (payloadSize - tableSize) / sizeof(SnapshotRecord)
+            || header.stringsSize > payloadSize - tableSize - header.numParameters * sizeof(SnapshotRecord)
+            || header.valuesSize != payloadSize - tableSize - header.numParameters * sizeof(SnapshotRecord) - header.stringsSize)
         {
-            if (param->getType() == type)
-                count++;
+            LOG_ERROR("ParameterManager::loadSnapshot: file '%s' is truncated or corrupted\n", filename.c_str());
+            return false;
         }
 
-        return count;
+        MappedFile source;
+        if (!source.open(sourceFilename))
+            return false;
+
+        if (header.sourceSize != source.getSize() || header.sourceHash != hashBytes(source.getData(), source.getSize()))
+        {
+            LOG_INFO("Snapshot '%s' is out of date with file '%s'\n", filename.c_str(), sourceFilename.c_str());
+            return false;
+        }
+
+        const char* typeNameData = file.getData() + sizeof(SnapshotHeader);
+        const char* recordData = typeNameData + tableSize;
+        const char* strings = recordData + header.numParameters * sizeof(SnapshotRecord);
+        const char* values = strings + header.stringsSize;
+
+        // The snapshot is only valid for the type registrations it was saved with
+        std::vector<uint32_t> typeNameIDs(header.numTypeNames);
+
+        for (uint32_t t = 0; t < header.numTypeNames; ++t)
+        {
+            SnapshotTypeName entry;
+            memcpy(&entry, typeNameData + t * sizeof(SnapshotTypeName), sizeof(entry));
+
+            if (!isInPool(entry.nameOffset, entry.nameLength, header.stringsSize) || entry.type >= static_cast<uint32_t>(ParameterType::kParamNumTypes))
+            {
+                LOG_ERROR("ParameterManager::loadSnapshot: file '%s' is truncated or corrupted\n", filename.c_str());
+                return false;
+            }
+
+            const std::string typeName(strings + entry.nameOffset, entry.nameLength);
+
+            if (!m_factory->hasParameterType(typeName) || m_factory->getParameterType(typeName) != static_cast<ParameterType>(entry.type))
+            {
+                LOG_INFO("Snapshot '%s' was saved with another type for the type name '%s'\n", filename.c_str(), typeName.c_str());
+                return false;
+            }
+
+            typeNameIDs[t] = internTypeName(typeName);
+        }
+
+        std::vector<SnapshotRecord> records(header.numParameters);
+        if (!records.empty())
+            memcpy(records.data(), recordData, records.size() * sizeof(SnapshotRecord));
+
+        m_records.reserve(records.size());
+        m_views.reserve(records.size());
+        m_order.reserve(records.size());
+
+        // Every value is decoded by the scratch parameter of its type name straight into the columns
+        for (const SnapshotRecord& record : records)
+        {
+            const size_t index = &record - records.data();
+
+            if (record.typeNameIndex >= header.numTypeNames || record.nameLength > UINT16_MAX || !isInPool(record.nameOffset, record.nameLength, header.stringsSize)
+                || !isInPool(record.valueOffset, record.valueSize, header.valuesSize))
+            {
+                LOG_ERROR("ParameterManager::loadSnapshot: file '%s' is truncated or corrupted\n", filename.c_str());
+                clear();
+                return false;
+            }
+
+            const uint32_t typeNameID = typeNameIDs[record.typeNameIndex];
+            Parameter& value = *m_typeNameEntries[typeNameID].scratch;
+
+            if (!value.fromBinary(values + record.valueOffset, values + record.valueOffset + record.valueSize))
+            {
+                LOG_ERROR("ParameterManager::loadSnapshot: file '%s' has an invalid value for parameter %zu\n", filename.c_str(), index);
+                clear();
+                return false;
+            }
+
+            addRecord(typeNameID, strings + record.nameOffset, record.nameLength, &value);
+        }
+
+        for (size_t i = 0; i < m_nameShards.size(); ++i)
+            reserveNames(m_nameShards[i], m_order.size() / kNumNameShards);
+
+        for (size_t i = 0; i < m_order.size(); ++i)
+            indexParameter(i);
+
+        LOG_DEBUG("Restored %zu parameters from snapshot '%s'\n", m_order.size(), filename.c_str());
+
+        return true;
+    }
+
+    void ParameterManager::clear()
+    {
+        for (Parameter* view : m_views)
+            delete view;
+
+        m_views.clear();
+        m_records.clear();
+        m_order.clear();
+        m_names.clear();
+        m_store.clear();
+        m_lazyValues.clear();
+        m_lazySources.clear();
+        clearNames();
+
+        for (TypeNameEntry& entry : m_typeNameEntries)
+            entry.count = 0;
+
+        std::fill(m_numParametersOfType.begin(), m_numParametersOfType.end(), 0);
+    }
+
+    uint32_t ParameterManager::getNumParametersOfTypeName(const std::string& typeName) const
+    {
+        auto it = m_typeNameIDs.find(typeName);
+        return it != m_typeNameIDs.end() ? m_typeNameEntries[it->second].count : 0;
+    }
+
+    uint32_t ParameterManager::getNumParametersOfType(ParameterType type) const
+    {
+        return m_numParametersOfType[static_cast<size_t>(type)];
     }
 
     void ParameterManager::getParametersOfType(ParameterType type, std::vector<Parameter*>& outParameters) const
@@ -153,10 +1149,10 @@ namespace rlib
         outParameters.clear();
         outParameters.reserve(getNumParametersOfType(type));
         
-        for (Parameter* param : m_parameters)
+        for (uint32_t id : m_order)
         {
-            if (param->getType() == type)
-                outParameters.push_back(param);
+            if (static_cast<ParameterType>(m_records[id].type) == type)
+                outParameters.push_back(getView(id));
         }
     }
 } // namespace rlib
\ No newline at end of file
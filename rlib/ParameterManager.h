@@ -1,17 +1,87 @@
 #ifndef PARAMETER_MANAGER_H
 #define PARAMETER_MANAGER_H
 
+#include "GeneralUtil.h"
+#include "MappedFile.h"
 #include "ParameterFactory.h"
+#include "ParameterStore.h"
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 #include <vector>
 
 namespace rlib
 {
-    class ParameterManager
+    /*
+    Reference to a parameter of a ParameterManager. Unlike an index it survives the registration and unregistration of
+    other parameters, and unlike a Parameter pointer it costs no allocation.
+    */
+    class ParameterHandle
+    {
+    public:
+        static const uint32_t kInvalidID = UINT32_MAX;
+
+        ParameterHandle() : m_id(kInvalidID) {}
+        explicit ParameterHandle(uint32_t id) : m_id(id) {}
+
+        bool isValid() const { return m_id != kInvalidID; }
+        uint32_t getID() const { return m_id; }
+
+        bool operator==(const ParameterHandle& other) const { return m_id == other.m_id; }
+        bool operator!=(const ParameterHandle& other) const { return m_id != other.m_id; }
+
+    private:
+        uint32_t m_id;
+    };
+
+    /*
+    Typed reference to the value of a parameter, for reads in hot loops. The name lookup and the type check are done once by
+    ParameterManager::bindParameter(), a read is then a single indexed load from the value column, with no check at all.
+    T is one of the types of ParameterValueTraits, e.g. ParamHandle<int>, ParamHandle<MdpTransitionValue> or ParamHandle<DoubleArray>.
+    The handle stays valid while other parameters are registered or unregistered and sees the changes made through the
+    Parameter views; it must not be read after its own parameter is unregistered or the manager is destroyed.
+    */
+    template <typename T>
+    class ParamHandle
+    {
+    public:
+        typedef typename ParameterValueTraits<T>::ValueType ValueType;
+
+        ParamHandle() : m_store(nullptr), m_slot(0) {}
+
+        bool isBound() const { return m_store != nullptr; }
+
+        ValueType get() const { return ParameterValueTraits<T>::get(*m_store, m_slot); }
+        ValueType operator*() const { return get(); }
+
+    private:
+        friend class ParameterManager;
+
+        ParamHandle(const ParameterStore* store, uint32_t slot) : m_store(store), m_slot(slot) {}
+
+        const ParameterStore* m_store;
+        uint32_t m_slot;
+    };
+
+    /*
+    Owns the parameters loaded from configuration files. Parameters are indexed by name and by type name, and the number
+    of parameters of every type is maintained, so registering a parameter and looking one up by name are O(1).
+    Values are stored in columns (see ParameterStore), names are stored once in a shared pool and type names are interned,
+    so a parameter costs a few tens of bytes plus its value. The Parameter objects returned by the manager are views created
+    on first access: they stay valid until their parameter is unregistered, and changing their value changes the stored one.
+    Views are created under a lock, so a loaded manager can still be read by several threads through the const accessors.
+    Hot paths should rather use handles and the typed getters, which read the columns directly.
+    */
+    class ParameterManager : private ParameterStorage
     {
     public:
         ParameterManager();
         ~ParameterManager();
 
+        ParameterManager(const ParameterManager&) = delete;
+        ParameterManager& operator=(const ParameterManager&) = delete;
+
         /*
         Gets a parameter by its index.
         Parameters:
@@ -22,14 +92,30 @@ namespace rlib
         Parameter* getParameter(size_t index) const;
 
         /*
-        Gets a parameter by its type name.
+        Gets a parameter by its name.
         Parameters:
-        - typeName: The name of the parameter type.
+        - name: The name of the parameter.
         Returns:
         - A pointer to the Parameter object, or nullptr if not found.
         */
         Parameter* getParameter(const std::string& name) const;
 
+        /*
+        Gets the Parameter view of a handle.
+        Parameters:
+        - handle: The handle of a registered parameter.
+        Returns:
+        - A pointer to the Parameter object.
+        */
+        Parameter* getParameter(ParameterHandle handle) const;
+
+        /*
+        Gets the first registered parameter of a type name.
+        Parameters:
+        - typeName: The name of the parameter type.
+        Returns:
+        - A pointer to the Parameter object, or nullptr if not found.
+        */
         Parameter* getFirstParameterOfTypeName(const std::string& typeName) const;
 
         /*
@@ -37,7 +123,74 @@ namespace rlib
         Returns:
         - The number of parameters.
         */
-        size_t getNumParameters() const { return m_parameters.size(); }
+        size_t getNumParameters() const { return m_order.size(); }
+
+        /*
+        Finds a parameter by its name.
+        Parameters:
+        - name: The name of the parameter.
+        Returns:
+        - The handle of the parameter, or an invalid handle if not found.
+        */
+        ParameterHandle findParameter(const std::string& name) const;
+
+        /*
+        Gets the handle of a parameter by its index.
+        */
+        ParameterHandle getHandle(size_t index) const;
+
+        /*
+        Gets the handles of all the parameters of a ParameterType, in registration order.
+        */
+        void getHandlesOfType(ParameterType type, std::vector<ParameterHandle>& outHandles) const;
+
+        /*
+        Checks if a handle refers to a registered parameter.
+        */
+        bool isRegistered(ParameterHandle handle) const { return handle.getID() < m_records.size() && !m_records[handle.getID()].isRemoved; }
+
+        /*
+        Binds a typed handle to a parameter, resolving its name and checking its type once.
+        Parameters:
+        - name: The name of the parameter.
+        Returns:
+        - The bound handle, or an unbound one if there is no parameter with this name or it is not of type T.
+        */
+        template <typename T>
+        ParamHandle<T> bindParameter(const std::string& name) const { return bindParameter<T>(findParameter(name)); }
+
+        template <typename T>
+        ParamHandle<T> bindParameter(ParameterHandle handle) const
+        {
+            if (!isRegistered(handle) || static_cast<ParameterType>(m_records[handle.getID()].type) != ParameterValueTraits<T>::kType)
+                return ParamHandle<T>();
+
+            return ParamHandle<T>(&m_store, resolveSlot(handle.getID()));
+        }
+
+        std::string getName(ParameterHandle handle) const;
+        const std::string& getTypeName(ParameterHandle handle) const { return m_typeNameEntries[getRecord(handle).typeNameID].name; }
+        ParameterType getType(ParameterHandle handle) const { return static_cast<ParameterType>(getRecord(handle).type); }
+
+        /*
+        Typed getters reading the value columns. The handle must refer to a registered parameter of the matching type.
+        */
+        int getInt(ParameterHandle handle) const { return m_store.getInt(getSlot(handle, ParameterType::kParamInt)); }
+        uint32_t getUInt(ParameterHandle handle) const { return m_store.getUInt(getSlot(handle, ParameterType::kParamUInt)); }
+        float getFloat(ParameterHandle handle) const { return m_store.getFloat(getSlot(handle, ParameterType::kParamFloat)); }
+        double getDouble(ParameterHandle handle) const { return m_store.getDouble(getSlot(handle, ParameterType::kParamDouble)); }
+        bool getBool(ParameterHandle handle) const { return m_store.getBool(getSlot(handle, ParameterType::kParamBool)); }
+        const MdpTransitionValue& getTransition(ParameterHandle handle) const { return m_store.getTransition(getSlot(handle, ParameterType::kParamMdpStateTransitionDef)); }
+
+        std::string getString(ParameterHandle handle) const;
+
+        /*
+        Array getters reading the shared payload in place. The views are valid until a parameter is registered or changed.
+        */
+        ParameterArrayView<int> getIntArray(ParameterHandle handle) const { return m_store.getArray<int>(getSlot(handle, ParameterType::kParamIntArray)); }
+        ParameterArrayView<float> getFloatArray(ParameterHandle handle) const { return m_store.getArray<float>(getSlot(handle, ParameterType::kParamFloatArray)); }
+        ParameterArrayView<double> getDoubleArray(ParameterHandle handle) const { return m_store.getArray<double>(getSlot(handle, ParameterType::kParamDoubleArray)); }
+        ParameterArrayView<bool> getBoolArray(ParameterHandle handle) const { return m_store.getArray<bool>(getSlot(handle, ParameterType::kParamBoolArray)); }
 
         /*
         Registers a new parameter type with its corresponding name.
@@ -65,20 +218,83 @@ namespace rlib
         Parameter* registerParameter(const std::string& typeName, const std::string& valueStr);
 
         /*
-        Unregisters a parameter by its index.
+        Unregisters a parameter by its index. The following parameters move down by one index and the indexes are rebuilt, in O(n).
+        The handles of the other parameters stay valid.
         Parameters:
         - index: The index of the parameter to unregister.
         */
         void unregisterParameter(size_t index);
 
         /*
-        Loads parameters from a configuration file.
+        Loads parameters from a configuration file. The file is memory mapped and every line is parsed in place.
+        With several threads the file is split into line aligned chunks parsed in parallel, then merged so that the parameters,
+        their order, their names and the reported errors are the same as with a sequential load.
         Parameters:
         - filename: The path to the configuration file.
+        - numThreads: The number of threads parsing the file, 0 uses all the available cores.
         Returns:
         - true if loading was successful, false otherwise.
         */
-        bool loadFromFile(const std::string& filename);
+        bool loadFromFile(const std::string& filename, unsigned numThreads = 1);
+
+        /*
+        Loads parameters from the contents of a configuration file already in memory, like loadFromFile().
+        Parameters:
+        - data: The contents, which must stay valid for the duration of the call.
+        - size: The size of the contents in bytes.
+        - numThreads: The number of threads parsing the contents, 0 uses all the available cores.
+        Returns:
+        - true if the contents were loaded, false if a line has an unregistered type name. The lines before it are loaded.
+        */
+        bool loadFromBuffer(const char* data, size_t size, unsigned numThreads = 1);
+
+        /*
+        Loads parameters from a configuration file without parsing their values. The file stays mapped and every line is
+        only indexed: its parameter is named and counted like in loadFromFile(), and its value is parsed from the mapping on
+        first access, by a getter, a typed handle, a Parameter view or a snapshot. A value that fails to parse is reported
+        then and reads as the default value of its type, while loadFromFile() skips it and does not name it.
+        The file must not be modified in place while the manager holds it, and the first accesses modify the manager, so
+        a lazily loaded manager must not be read by several threads before all its values are parsed.
+        Parameters:
+        - filename: The path to the configuration file.
+        Returns:
+        - true if the file was mapped, false otherwise.
+        */
+        bool loadFromFileLazy(const std::string& filename);
+
+        /*
+        Saves all the parameters to a binary snapshot, stamped with the size and hash of the text file they were loaded from.
+        Parameters:
+        - filename: The path to the snapshot file.
+        - sourceFilename: The path to the text parameter file the snapshot stands for.
+        Returns:
+        - true if the snapshot was written, false otherwise.
+        */
+        bool saveSnapshot(const std::string& filename, const std::string& sourceFilename) const;
+
+        /*
+        Restores the parameters of a snapshot written by saveSnapshot() into an empty manager. The snapshot is mapped and every
+        value is decoded from its binary form straight into the columns, without parsing any text.
+        Parameters:
+        - filename: The path to the snapshot file.
+        - sourceFilename: The path to the text parameter file, which must still have the size and hash stored in the snapshot.
+        Returns:
+        - true if the parameters were restored, false if the manager is not empty, the snapshot is invalid or out of date,
+          or its type names are not registered with the same types.
+        */
+        bool loadSnapshot(const std::string& filename, const std::string& sourceFilename);
+
+        /*
+        Loads a text parameter file through a snapshot: an up to date snapshot is restored instead of parsing the file,
+        otherwise the file is loaded and the snapshot is rewritten. Only an empty manager uses and writes the snapshot.
+        Parameters:
+        - filename: The path to the text parameter file.
+        - snapshotFilename: The path to the snapshot file, created if missing.
+        - numThreads: The number of threads parsing the file when the snapshot cannot be used.
+        Returns:
+        - true if loading was successful, false otherwise.
+        */
+        bool loadFromFileCached(const std::string& filename, const std::string& snapshotFilename, unsigned numThreads = 1);
 
         /*
         Gets all parameters of a specific ParameterType.
@@ -106,17 +322,181 @@ namespace rlib
         */
         uint32_t getNumParametersOfType(ParameterType type) const;
     private:
+        struct Record
+        {
+            uint32_t nameOffset;        // In m_names
+            uint32_t slot;              // In the column of the type in m_store, or kLazySlot plus the index in m_lazyValues
+            uint32_t typeNameID;        // In m_typeNameEntries
+            uint16_t nameLength;
+            uint8_t type;
+            uint8_t isRemoved;
+        };
+
+        struct TypeNameEntry
+        {
+            std::string name;
+            ParameterType type;
+            size_t firstIndex;                  // Index of the first parameter of the type name, when count > 0
+            uint32_t count;
+            std::unique_ptr<Parameter> scratch; // Reused to parse the values of the type name before they are stored
+        };
+
+        /*
+        Open addressing table of the names of a shard. Every slot packs the low 32 bits of the name hash with the id of the
+        parameter plus one, 0 being an empty slot. Names are compared in the name pool on a hash match, so inserting
+        neither allocates a node nor copies the name.
+        */
+        struct NameShard
+        {
+            std::vector<uint64_t> slots;
+            size_t size;
+
+            NameShard() : size(0) {}
+        };
+
+        // Character range of a value that has not been parsed yet
+        struct LazyValue
+        {
+            const char* begin;
+            const char* end;
+        };
+
+        static const uint32_t kLazySlot = 0x80000000u;
+
+        // Lazy values are parsed by the const accessors on first access
+        ParameterFactory* m_factory;
+        mutable ParameterStore m_store;
+
+        // Indexed by parameter id, ids are never reused so that handles stay valid
+        mutable std::vector<Record> m_records;
+        std::string m_names;
+        mutable std::vector<Parameter*> m_views;
+
+        // Const readers may create the same view concurrently
+        mutable std::mutex m_viewMutex;
+
+        // Ids of the registered parameters, in registration order
+        std::vector<uint32_t> m_order;
+
+        std::vector<TypeNameEntry> m_typeNameEntries;
+        std::unordered_map<std::string, uint32_t> m_typeNameIDs;
+
+        // The name index is split in shards selected by the hash of the name, so that parallel loads fill it concurrently
+        static const size_t kNumNameShards = 64;
+
+        // A name registered twice maps to its first parameter, as a scan would find it
+        std::vector<NameShard> m_nameShards;
+        std::vector<uint32_t> m_numParametersOfType;
+
+        // Files loaded by loadFromFileLazy() and the ranges of their values, kept until the manager is cleared
+        std::vector<std::unique_ptr<MappedFile>> m_lazySources;
+        std::vector<LazyValue> m_lazyValues;
+
+        static size_t hashName(const char* name, size_t length);
+        static size_t getNameShard(size_t hash) { return (hash >> (sizeof(size_t) * 4)) % kNumNameShards; }
+
+        const Record& getRecord(ParameterHandle handle) const
+        {
+            if (!isRegistered(handle))
+                REPORT_PANIC("ParameterManager: invalid parameter handle");
+
+            return m_records[handle.getID()];
+        }
+
+        uint32_t getSlot(ParameterHandle handle, ParameterType type) const
+        {
+            const Record& record = getRecord(handle);
+            if (static_cast<ParameterType>(record.type) != type)
+                REPORT_PANIC(std::string("ParameterManager: parameter is not of type ") + Parameter::parameterTypeAsString(type));
+
+            return resolveSlot(handle.getID());
+        }
+
         /*
-        Checks if a parameter with the given type name already exists.
+        Gets the slot of the value of a parameter, parsing the value first if it is lazy.
+        */
+        uint32_t resolveSlot(uint32_t id) const
+        {
+            const uint32_t slot = m_records[id].slot;
+            return (slot & kLazySlot) == 0 ? slot : parseLazyValue(id);
+        }
+
+        /*
+        Parses a lazy value into the columns.
+        Returns:
+        - The slot of the value.
+        */
+        uint32_t parseLazyValue(uint32_t id) const;
+
+        bool hasName(uint32_t id, const char* name, size_t length) const
+        {
+            const Record& record = m_records[id];
+            return record.nameLength == length && memcmp(m_names.data() + record.nameOffset, name, length) == 0;
+        }
+
+        /*
+        Finds the id of the first parameter with the given name, or ParameterHandle::kInvalidID.
+        */
+        uint32_t findName(const std::string& name) const;
+
+        /*
+        Adds a parameter to its name shard, unless its name is already there.
+        Only touches that shard, so different shards can be filled concurrently.
+        */
+        void insertName(size_t hash, uint32_t id);
+
+        /*
+        Grows the table of a shard so that it holds the given number of names without growing again.
+        */
+        static void reserveNames(NameShard& shard, size_t numNames);
+
+        void clearNames();
+
+        /*
+        Gets the id of a type name, creating its entry on first use. The type name must be registered in the factory.
+        */
+        uint32_t internTypeName(const std::string& typeName);
+
+        /*
+        Stores a parameter: its value in the columns and its name in the pool. It still has to be indexed.
         Parameters:
-        - typeName: The name of the parameter type to check.
+        - value: The value, or nullptr to set the slot of the record later.
         Returns:
-        - true if a parameter with the given type name exists, false otherwise.
+        - The id of the parameter.
         */
-        bool hasDuplicateParameter(const std::string& name) const { return getParameter(name) != nullptr; }
+        uint32_t addRecord(uint32_t typeNameID, const char* name, size_t nameLength, const Parameter* value);
 
-        std::vector<Parameter*> m_parameters;
-        ParameterFactory* m_factory;
+        /*
+        Adds the parameter at the given index to the indexes and counts.
+        */
+        void indexParameter(size_t index);
+
+        /*
+        Gets the view of a parameter, creating it on first access.
+        */
+        Parameter* getView(uint32_t id) const;
+
+        void storeValue(uint32_t id, const Parameter& param) override;
+
+        /*
+        Removes every parameter and its views, keeping the interned type names.
+        */
+        void clear();
+
+        /*
+        Load the lines of a buffer, stopping at the first unregistered type name.
+        Returns:
+        - false if an unregistered type name was found, true otherwise.
+        */
+        bool loadSequential(const char* data, const char* end);
+        bool loadParallel(const char* data, const char* end, unsigned numThreads);
+
+        /*
+        Registers a new parameter parsing its value in place from a character range.
+        Returns:
+        - The id of the parameter, or ParameterHandle::kInvalidID if the value failed to parse.
+        */
+        uint32_t registerParameter(uint32_t typeNameID, const char* valueBegin, const char* valueEnd);
     };
 } // namespace rlib
 #endif
\ No newline at end of file
@@ -0,0 +1,236 @@
+#include "ParameterStore.h"
+
+#include <cstring>
+
+#include "GeneralUtil.h"
+
+namespace rlib
+{
+    const uint32_t ParameterStore::kNumColumns;
+
+    bool ParameterStore::isPayloadType(ParameterType type)
+    {
+        switch (type)
+        {
+        case ParameterType::kParamString:
+        case ParameterType::kParamIntArray:
+        case ParameterType::kParamFloatArray:
+        case ParameterType::kParamDoubleArray:
+        case ParameterType::kParamStringArray:
+        case ParameterType::kParamBoolArray:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    uint32_t ParameterStore::getColumnSize(ParameterType type) const
+    {
+        if (isPayloadType(type))
+            return static_cast<uint32_t>(m_payloadRanges.size());
+
+        switch (type)
+        {
+        case ParameterType::kParamInt:                      return static_cast<uint32_t>(m_ints.size());
+        case ParameterType::kParamUInt:                     return static_cast<uint32_t>(m_uints.size());
+        case ParameterType::kParamFloat:                    return static_cast<uint32_t>(m_floats.size());
+        case ParameterType::kParamDouble:                   return static_cast<uint32_t>(m_doubles.size());
+        case ParameterType::kParamBool:                     return static_cast<uint32_t>(m_bools.size());
+        case ParameterType::kParamMdpStateTransitionDef:    return static_cast<uint32_t>(m_transitions.size());
+        default:                                            return 0;
+        }
+    }
+
+    uint32_t ParameterStore::append(const Parameter& param)
+    {
+        const ParameterType type = param.getType();
+        const uint32_t slot = getColumnSize(type);
+
+        if (isPayloadType(type))
+        {
+            alignPayload();
+
+            PayloadRange range = { m_payload.size(), 0 };
+            param.appendBinary(m_payload);
+            range.size = m_payload.size() - range.offset;
+
+            m_payloadRanges.push_back(range);
+            return slot;
+        }
+
+        switch (type)
+        {
+        case ParameterType::kParamInt:      m_ints.push_back(static_cast<const IntParameter&>(param).getValue()); break;
+        case ParameterType::kParamUInt:     m_uints.push_back(static_cast<const UIntParameter&>(param).getValue()); break;
+        case ParameterType::kParamFloat:    m_floats.push_back(static_cast<const FloatParameter&>(param).getValue()); break;
+        case ParameterType::kParamDouble:   m_doubles.push_back(static_cast<const DoubleParameter&>(param).getValue()); break;
+        case ParameterType::kParamBool:     m_bools.push_back(static_cast<const BoolParameter&>(param).getValue() ? 1 : 0); break;
+
+        case ParameterType::kParamMdpStateTransitionDef:
+        {
+            const MdpStateTransitionDefParameter& def = static_cast<const MdpStateTransitionDefParameter&>(param);
+            MdpTransitionValue value = { def.getStateID(), def.getActionID(), def.getNextStateID(), def.getProbability(), def.getCost() };
+            m_transitions.push_back(value);
+            break;
+        }
+
+        default:
+            REPORT_PANIC("ParameterStore::append: unsupported parameter type " + std::to_string(static_cast<int>(type)));
+        }
+
+        return slot;
+    }
+
+    void ParameterStore::append(const ParameterStore& other, uint32_t* outSlotOffsets)
+    {
+        for (uint32_t t = 0; t < kNumColumns; ++t)
+            outSlotOffsets[t] = getColumnSize(static_cast<ParameterType>(t));
+
+        m_ints.insert(m_ints.end(), other.m_ints.begin(), other.m_ints.end());
+        m_uints.insert(m_uints.end(), other.m_uints.begin(), other.m_uints.end());
+        m_floats.insert(m_floats.end(), other.m_floats.begin(), other.m_floats.end());
+        m_doubles.insert(m_doubles.end(), other.m_doubles.begin(), other.m_doubles.end());
+        m_bools.insert(m_bools.end(), other.m_bools.begin(), other.m_bools.end());
+        m_transitions.insert(m_transitions.end(), other.m_transitions.begin(), other.m_transitions.end());
+
+        // Both payloads are 8 byte aligned, so shifting the offsets by an aligned base keeps every value aligned
+        alignPayload();
+        const uint64_t base = m_payload.size();
+        m_payload.append(other.m_payload);
+
+        m_payloadRanges.reserve(m_payloadRanges.size() + other.m_payloadRanges.size());
+        for (const PayloadRange& range : other.m_payloadRanges)
+        {
+            PayloadRange shifted = { base + range.offset, range.size };
+            m_payloadRanges.push_back(shifted);
+        }
+    }
+
+    void ParameterStore::store(uint32_t slot, const Parameter& param)
+    {
+        const ParameterType type = param.getType();
+
+        if (isPayloadType(type))
+        {
+            m_scratch.clear();
+            param.appendBinary(m_scratch);
+
+            PayloadRange& range = m_payloadRanges[slot];
+            if (range.size != m_scratch.size())
+            {
+                alignPayload();
+                range.offset = m_payload.size();
+                range.size = m_scratch.size();
+                m_payload.append(m_scratch);
+            }
+            else if (!m_scratch.empty())
+            {
+                memcpy(&m_payload[range.offset], m_scratch.data(), m_scratch.size());
+            }
+
+            return;
+        }
+
+        switch (type)
+        {
+        case ParameterType::kParamInt:      m_ints[slot] = static_cast<const IntParameter&>(param).getValue(); break;
+        case ParameterType::kParamUInt:     m_uints[slot] = static_cast<const UIntParameter&>(param).getValue(); break;
+        case ParameterType::kParamFloat:    m_floats[slot] = static_cast<const FloatParameter&>(param).getValue(); break;
+        case ParameterType::kParamDouble:   m_doubles[slot] = static_cast<const DoubleParameter&>(param).getValue(); break;
+        case ParameterType::kParamBool:     m_bools[slot] = static_cast<const BoolParameter&>(param).getValue() ? 1 : 0; break;
+
+        case ParameterType::kParamMdpStateTransitionDef:
+        {
+            const MdpStateTransitionDefParameter& def = static_cast<const MdpStateTransitionDefParameter&>(param);
+            MdpTransitionValue value = { def.getStateID(), def.getActionID(), def.getNextStateID(), def.getProbability(), def.getCost() };
+            m_transitions[slot] = value;
+            break;
+        }
+
+        default:
+            REPORT_PANIC("ParameterStore::store: unsupported parameter type " + std::to_string(static_cast<int>(type)));
+        }
+    }
+
+    bool ParameterStore::load(uint32_t slot, Parameter& param) const
+    {
+        const ParameterType type = param.getType();
+
+        if (isPayloadType(type))
+        {
+            const PayloadRange& range = m_payloadRanges[slot];
+            return param.fromBinary(m_payload.data() + range.offset, m_payload.data() + range.offset + range.size);
+        }
+
+        switch (type)
+        {
+        case ParameterType::kParamInt:      static_cast<IntParameter&>(param).setValue(m_ints[slot]); return true;
+        case ParameterType::kParamUInt:     static_cast<UIntParameter&>(param).setValue(m_uints[slot]); return true;
+        case ParameterType::kParamFloat:    static_cast<FloatParameter&>(param).setValue(m_floats[slot]); return true;
+        case ParameterType::kParamDouble:   static_cast<DoubleParameter&>(param).setValue(m_doubles[slot]); return true;
+        case ParameterType::kParamBool:     static_cast<BoolParameter&>(param).setValue(m_bools[slot] != 0); return true;
+
+        case ParameterType::kParamMdpStateTransitionDef:
+        {
+            MdpStateTransitionDefParameter& def = static_cast<MdpStateTransitionDefParameter&>(param);
+            const MdpTransitionValue& value = m_transitions[slot];
+
+            def.setStateID(value.stateID);
+            def.setActionID(value.actionID);
+            def.setNextStateID(value.nextStateID);
+            def.setProbability(value.probability);
+            def.setCost(value.cost);
+            return true;
+        }
+
+        default:
+            return false;
+        }
+    }
+
+    void ParameterStore::appendBinary(ParameterType type, uint32_t slot, std::string& out) const
+    {
+        if (isPayloadType(type))
+        {
+            const PayloadRange& range = m_payloadRanges[slot];
+            out.append(m_payload.data() + range.offset, range.size);
+            return;
+        }
+
+        // Same layouts as the appendBinary() of the parameter classes
+        switch (type)
+        {
+        case ParameterType::kParamInt:      out.append(reinterpret_cast<const char*>(&m_ints[slot]), sizeof(int)); break;
+        case ParameterType::kParamUInt:     out.append(reinterpret_cast<const char*>(&m_uints[slot]), sizeof(uint32_t)); break;
+        case ParameterType::kParamFloat:    out.append(reinterpret_cast<const char*>(&m_floats[slot]), sizeof(float)); break;
+        case ParameterType::kParamDouble:   out.append(reinterpret_cast<const char*>(&m_doubles[slot]), sizeof(double)); break;
+        case ParameterType::kParamBool:     out += m_bools[slot] != 0 ? '\1' : '\0'; break;
+
+        case ParameterType::kParamMdpStateTransitionDef:
+        {
+            const MdpTransitionValue& value = m_transitions[slot];
+            out.append(reinterpret_cast<const char*>(&value.stateID), sizeof(int));
+            out.append(reinterpret_cast<const char*>(&value.actionID), sizeof(int));
+            out.append(reinterpret_cast<const char*>(&value.nextStateID), sizeof(int));
+            out.append(reinterpret_cast<const char*>(&value.probability), sizeof(real_t));
+            out.append(reinterpret_cast<const char*>(&value.cost), sizeof(real_t));
+            break;
+        }
+
+        default:
+            REPORT_PANIC("ParameterStore::appendBinary: unsupported parameter type " + std::to_string(static_cast<int>(type)));
+        }
+    }
+
+    void ParameterStore::clear()
+    {
+        std::vector<int>().swap(m_ints);
+        std::vector<uint32_t>().swap(m_uints);
+        std::vector<float>().swap(m_floats);
+        std::vector<double>().swap(m_doubles);
+        std::vector<uint8_t>().swap(m_bools);
+        std::vector<MdpTransitionValue>().swap(m_transitions);
+        std::vector<PayloadRange>().swap(m_payloadRanges);
+        std::string().swap(m_payload);
+    }
+} // namespace rlib
\ No newline at end of file
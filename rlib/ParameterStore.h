@@ -0,0 +1,248 @@
+#ifndef PARAMETER_STORE_H
+#define PARAMETER_STORE_H
+
+#include "Parameter.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace rlib
+{
+    /*
+    Read only view of a contiguous array of parameter values, valid until the storage it points into changes.
+    */
+    template <typename T>
+    class ParameterArrayView
+    {
+    public:
+        ParameterArrayView() : m_data(nullptr), m_size(0) {}
+        ParameterArrayView(const T* data, size_t size) : m_data(data), m_size(size) {}
+
+        const T* begin() const { return m_data; }
+        const T* end() const { return m_data + m_size; }
+        const T& operator[](size_t i) const { return m_data[i]; }
+
+        size_t size() const { return m_size; }
+        bool empty() const { return m_size == 0; }
+
+    private:
+        const T* m_data;
+        size_t m_size;
+    };
+
+    /*
+    Value of an mdpStateTransitionDef parameter, see MdpStateTransitionDefParameter.
+    */
+    struct MdpTransitionValue
+    {
+        int stateID;
+        int actionID;
+        int nextStateID;
+        real_t probability;
+        real_t cost;
+    };
+
+    /*
+    Columnar storage of parameter values. Scalar and transition values live in one typed column per ParameterType.
+    Strings and arrays live in one shared payload buffer, in the binary form of Parameter::appendBinary(), every value starting
+    on an 8 byte boundary so that numeric arrays are read in place. A value is addressed by its type and its slot in the column
+    of the type; slots are never reused, the space of replaced or removed values is reclaimed by clear().
+    */
+    class ParameterStore
+    {
+    public:
+        static const uint32_t kNumColumns = static_cast<uint32_t>(ParameterType::kParamNumTypes);
+
+        ParameterStore() {}
+
+        /*
+        Appends the value of a parameter to the column of its type.
+        Returns:
+        - The slot of the value.
+        */
+        uint32_t append(const Parameter& param);
+
+        /*
+        Appends all the values of another store. The slots of the other store are shifted by the sizes the columns had before.
+        Parameters:
+        - other: The store to append.
+        - outSlotOffsets: Receives the shift of the slots of every ParameterType, kNumColumns entries.
+        */
+        void append(const ParameterStore& other, uint32_t* outSlotOffsets);
+
+        /*
+        Replaces the value in a slot with the value of a parameter of the same type. A string or array of a new size is appended
+        to the payload instead of replacing the old one in place.
+        */
+        void store(uint32_t slot, const Parameter& param);
+
+        /*
+        Copies the value in a slot into a parameter of the same type.
+        Returns:
+        - true if the value was copied, false if the parameter rejected it.
+        */
+        bool load(uint32_t slot, Parameter& param) const;
+
+        /*
+        Appends the value in a slot in the binary form of Parameter::appendBinary().
+        */
+        void appendBinary(ParameterType type, uint32_t slot, std::string& out) const;
+
+        /*
+        Gets the number of slots of the column of a type.
+        */
+        uint32_t getColumnSize(ParameterType type) const;
+
+        /*
+        Removes all the values and releases their memory.
+        */
+        void clear();
+
+        int getInt(uint32_t slot) const { return m_ints[slot]; }
+        uint32_t getUInt(uint32_t slot) const { return m_uints[slot]; }
+        float getFloat(uint32_t slot) const { return m_floats[slot]; }
+        double getDouble(uint32_t slot) const { return m_doubles[slot]; }
+        bool getBool(uint32_t slot) const { return m_bools[slot] != 0; }
+        const MdpTransitionValue& getTransition(uint32_t slot) const { return m_transitions[slot]; }
+
+        /*
+        Gets a string or array value in place. Only meaningful for the element type of the array type of the slot:
+        char for strings, int, float, double and bool for the arrays. String arrays are length prefixed and have no view.
+        */
+        template <typename T>
+        ParameterArrayView<T> getArray(uint32_t slot) const
+        {
+            const PayloadRange& range = m_payloadRanges[slot];
+            return ParameterArrayView<T>(reinterpret_cast<const T*>(m_payload.data() + range.offset), range.size / sizeof(T));
+        }
+
+        /*
+        Checks if the values of a type live in the shared payload rather than in a typed column.
+        */
+        static bool isPayloadType(ParameterType type);
+
+    private:
+        struct PayloadRange
+        {
+            uint64_t offset;
+            uint64_t size;
+        };
+
+        std::vector<int> m_ints;
+        std::vector<uint32_t> m_uints;
+        std::vector<float> m_floats;
+        std::vector<double> m_doubles;
+        std::vector<uint8_t> m_bools;
+        std::vector<MdpTransitionValue> m_transitions;
+
+        // Shared by the strings and all the array types, whose slots index m_payloadRanges
+        std::vector<PayloadRange> m_payloadRanges;
+        std::string m_payload;
+
+        // Reused to encode replaced payload values
+        std::string m_scratch;
+
+        /*
+        Pads the payload to the alignment of the next value.
+        */
+        void alignPayload() { m_payload.resize((m_payload.size() + 7) & ~static_cast<size_t>(7), '\0'); }
+    };
+
+    /*
+    Tags naming the array parameter types in ParameterValueTraits and ParamHandle.
+    */
+    struct IntArray {};
+    struct FloatArray {};
+    struct DoubleArray {};
+    struct BoolArray {};
+
+    /*
+    Maps a C++ value type, or an array tag, to its ParameterType and to the read of its column in a ParameterStore.
+    Defined for int, uint32_t, float, double, bool, MdpTransitionValue and the array tags. Strings and string arrays have no
+    in place value of fixed layout and are read through ParameterManager::getString() and the Parameter objects.
+    */
+    template <typename T>
+    struct ParameterValueTraits;
+
+    template <>
+    struct ParameterValueTraits<int>
+    {
+        typedef int ValueType;
+        static const ParameterType kType = ParameterType::kParamInt;
+        static ValueType get(const ParameterStore& store, uint32_t slot) { return store.getInt(slot); }
+    };
+
+    template <>
+    struct ParameterValueTraits<uint32_t>
+    {
+        typedef uint32_t ValueType;
+        static const ParameterType kType = ParameterType::kParamUInt;
+        static ValueType get(const ParameterStore& store, uint32_t slot) { return store.getUInt(slot); }
+    };
+
+    template <>
+    struct ParameterValueTraits<float>
+    {
+        typedef float ValueType;
+        static const ParameterType kType = ParameterType::kParamFloat;
+        static ValueType get(const ParameterStore& store, uint32_t slot) { return store.getFloat(slot); }
+    };
+
+    template <>
+    struct ParameterValueTraits<double>
+    {
+        typedef double ValueType;
+        static const ParameterType kType = ParameterType::kParamDouble;
+        static ValueType get(const ParameterStore& store, uint32_t slot) { return store.getDouble(slot); }
+    };
+
+    template <>
+    struct ParameterValueTraits<bool>
+    {
+        typedef bool ValueType;
+        static const ParameterType kType = ParameterType::kParamBool;
+        static ValueType get(const ParameterStore& store, uint32_t slot) { return store.getBool(slot); }
+    };
+
+    template <>
+    struct ParameterValueTraits<MdpTransitionValue>
+    {
+        typedef const MdpTransitionValue& ValueType;
+        static const ParameterType kType = ParameterType::kParamMdpStateTransitionDef;
+        static ValueType get(const ParameterStore& store, uint32_t slot) { return store.getTransition(slot); }
+    };
+
+    template <>
+    struct ParameterValueTraits<IntArray>
+    {
+        typedef ParameterArrayView<int> ValueType;
+        static const ParameterType kType = ParameterType::kParamIntArray;
+        static ValueType get(const ParameterStore& store, uint32_t slot) { return store.getArray<int>(slot); }
+    };
+
+    template <>
+    struct ParameterValueTraits<FloatArray>
+    {
+        typedef ParameterArrayView<float> ValueType;
+        static const ParameterType kType = ParameterType::kParamFloatArray;
+        static ValueType get(const ParameterStore& store, uint32_t slot) { return store.getArray<float>(slot); }
+    };
+
+    template <>
+    struct ParameterValueTraits<DoubleArray>
+    {
+        typedef ParameterArrayView<double> ValueType;
+        static const ParameterType kType = ParameterType::kParamDoubleArray;
+        static ValueType get(const ParameterStore& store, uint32_t slot) { return store.getArray<double>(slot); }
+    };
+
+    template <>
+    struct ParameterValueTraits<BoolArray>
+    {
+        typedef ParameterArrayView<bool> ValueType;
+        static const ParameterType kType = ParameterType::kParamBoolArray;
+        static ValueType get(const ParameterStore& store, uint32_t slot) { return store.getArray<bool>(slot); }
+    };
+} // namespace rlib
+
+#endif // PARAMETER_STORE_H
\ No newline at end of file
@@ -1,19 +1,195 @@
 #include "Rng.h"
 
+#include <atomic>
+
 namespace rlib
-{    
-    DefaultRng::DefaultRng()
+{
+    namespace
+    {
+        std::atomic<uint64_t> g_globalSeed(0);
+
+        // Incremented by every call to setGlobalSeed(), so that the threads know when to reseed
+        std::atomic<uint64_t> g_seedGeneration(0);
+
+        // Automatic stream of the next thread asking for its generator without having called setThreadStream()
+        std::atomic<uint64_t> g_nextThreadStream(kAutomaticThreadStream);
+
+        struct ThreadRngSlot
+        {
+            XoshiroRng rng;
+            uint64_t generation;
+            uint64_t stream;
+
+            ThreadRngSlot() : generation(UINT64_MAX), stream(g_nextThreadStream++) {}
+        };
+
+        ThreadRngSlot& getThreadRngSlot()
+        {
+            thread_local ThreadRngSlot slot;
+            return slot;
+        }
+    }
+
+    void RngBase::fillUniform(real_t* out, size_t count, real_t lower, real_t upper)
+    {
+        for (size_t i = 0; i < count; ++i)
+            out[i] = getRandomReal(lower, upper);
+    }
+
+    void RngBase::fillInt(int* out, size_t count, int lower, int upper)
+    {
+        for (size_t i = 0; i < count; ++i)
+            out[i] = getRandomInt(lower, upper);
+    }
+
+    void RngBase::fillExponential(real_t* out, size_t count, real_t rate)
+    {
+        fillUniform(out, count);
+
+        for (size_t i = 0; i < count; ++i)
+            out[i] = -std::log1p(-out[i]) / rate;
+    }
+
+    void Xoshiro256PlusPlus::seed(uint64_t seed)
     {
-        m_engine = pseudo_random_engine_from_device();
+        for (int i = 0; i < 4; ++i)
+            m_state[i] = deriveSeed(seed, i);
+    }
+
+    void Xoshiro256PlusPlus::jump()
+    {
+        static const uint64_t kJump[4] = { 0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL };
+        applyJump(kJump);
+    }
+
+    void Xoshiro256PlusPlus::longJump()
+    {
+        static const uint64_t kLongJump[4] = { 0x76e15d3efefdcbbfULL, 0xc5004e441c522fb3ULL, 0x77710069854ee241ULL, 0x39109bb02acbe635ULL };
+        applyJump(kLongJump);
+    }
+
+    void Xoshiro256PlusPlus::applyJump(const uint64_t polynomial[4])
+    {
+        uint64_t state[4] = { 0, 0, 0, 0 };
+
+        for (int i = 0; i < 4; ++i)
+        {
+            for (int b = 0; b < 64; ++b)
+            {
+                if (polynomial[i] & (1ULL << b))
+                {
+                    for (int k = 0; k < 4; ++k)
+                        state[k] ^= m_state[k];
+                }
+
+                (*this)();
+            }
+        }
+
+        for (int k = 0; k < 4; ++k)
+            m_state[k] = state[k];
+    }
+
+    constexpr Pcg64::uint128_t Pcg64::kMultiplier;
+
+    void Pcg64::seed(uint64_t seed, uint64_t stream)
+    {
+        m_increment = (static_cast<uint128_t>(stream) << 1) | 1;
+        m_state = 0;
+        (*this)();
+        m_state += seed;
+        (*this)();
+    }
+
+    void Pcg64::advance(uint64_t delta)
+    {
+        // Jump ahead by composing the affine step with itself, one squaring per bit of delta
+        uint128_t currentMultiplier = kMultiplier;
+        uint128_t currentIncrement = m_increment;
+        uint128_t multiplier = 1;
+        uint128_t increment = 0;
+
+        while (delta > 0)
+        {
+            if (delta & 1)
+            {
+                multiplier *= currentMultiplier;
+                increment = increment * currentMultiplier + currentIncrement;
+            }
+
+            currentIncrement = (currentMultiplier + 1) * currentIncrement;
+            currentMultiplier *= currentMultiplier;
+            delta >>= 1;
+        }
+
+        m_state = multiplier * m_state + increment;
+    }
+
+    void setGlobalSeed(uint64_t seed)
+    {
+        g_globalSeed = seed;
+        g_seedGeneration++;
+    }
+
+    uint64_t getGlobalSeed()
+    {
+        return g_globalSeed;
+    }
+
+    uint64_t generateRandomSeed()
+    {
+        std::random_device device;
+
+        return (static_cast<uint64_t>(device()) << 32) ^ device();
+    }
+
+    XoshiroRng& getThreadRng()
+    {
+        ThreadRngSlot& slot = getThreadRngSlot();
+
+        const uint64_t generation = g_seedGeneration;
+        if (slot.generation != generation)
+        {
+            slot.rng.seed(deriveSeed(g_globalSeed, slot.stream));
+            slot.generation = generation;
+        }
+
+        return slot.rng;
+    }
+
+    void setThreadStream(uint64_t stream)
+    {
+        ThreadRngSlot& slot = getThreadRngSlot();
+
+        slot.stream = stream;
+        slot.generation = UINT64_MAX;
     }
 
     real_t DefaultRng::getRandomReal(real_t lower, real_t upper)
+    {
+        return getThreadRng().getRandomReal(lower, upper);
+    }
+
+    int DefaultRng::getRandomInt(int lower, int upper)
+    {
+        return getThreadRng().getRandomInt(lower, upper);
+    }
+
+    real_t SeededRng::getRandomReal(real_t lower, real_t upper)
     {
         std::uniform_real_distribution<real_t> dist(lower, upper);
         return dist(m_engine);
     }
 
-    int DefaultRng::getRandomInt(int lower, int upper)
+    void SeededRng::fillUniform(real_t* out, size_t count, real_t lower, real_t upper)
+    {
+        std::uniform_real_distribution<real_t> dist(lower, upper);
+
+        for (size_t i = 0; i < count; ++i)
+            out[i] = dist(m_engine);
+    }
+
+    int SeededRng::getRandomInt(int lower, int upper)
     {
         std::uniform_int_distribution<int> dist(lower, upper);
         return dist(m_engine);
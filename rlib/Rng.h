@@ -1,11 +1,273 @@
 #ifndef RNG_H
 #define RNG_H
 
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
 #include "Singleton.inl"
 #include "../mocc/mocc.hpp"
 
 namespace rlib
 {
+    /*
+    Derives the seed of an independent stream from a base seed and a stream index, e.g. one stream per trajectory.
+    The result only depends on its arguments, which makes parallel simulations reproducible.
+    Parameters:
+    - seed: The base seed.
+    - stream: The index of the stream.
+    Returns:
+    - A well mixed seed (SplitMix64 finalizer).
+    */
+    inline uint64_t deriveSeed(uint64_t seed, uint64_t stream)
+    {
+        uint64_t z = seed + (stream + 1) * 0x9E3779B97F4A7C15ULL;
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+
+        return z ^ (z >> 31);
+    }
+
+    /*
+    Converts 64 random bits to a uniform real number in [0, 1), using the top 53 bits.
+    */
+    inline real_t uniformRealFromBits(uint64_t bits)
+    {
+        return static_cast<real_t>(bits >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    /*
+    The xoshiro256++ generator by Blackman and Vigna: 256 bits of state, period 2^256 - 1, a few cycles per output.
+    Satisfies the standard UniformRandomBitGenerator requirements, so it can also drive the <random> distributions.
+    */
+    class Xoshiro256PlusPlus
+    {
+    public:
+        typedef uint64_t result_type;
+
+        explicit Xoshiro256PlusPlus(uint64_t seed = 0) { this->seed(seed); }
+
+        /*
+        Fills the state from a 64 bit seed with SplitMix64, as recommended by the authors.
+        */
+        void seed(uint64_t seed);
+
+        result_type operator()()
+        {
+            const uint64_t result = rotl(m_state[0] + m_state[3], 23) + m_state[0];
+            const uint64_t t = m_state[1] << 17;
+
+            m_state[2] ^= m_state[0];
+            m_state[3] ^= m_state[1];
+            m_state[1] ^= m_state[2];
+            m_state[0] ^= m_state[3];
+            m_state[2] ^= t;
+            m_state[3] = rotl(m_state[3], 45);
+
+            return result;
+        }
+
+        /*
+        Advances the generator by 2^128 steps. Calling jump() k times on copies of one generator gives k non overlapping streams,
+        e.g. one per thread, each of length 2^128.
+        */
+        void jump();
+
+        /*
+        Advances the generator by 2^192 steps, to split streams that are themselves split with jump().
+        */
+        void longJump();
+
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return UINT64_MAX; }
+
+    private:
+        uint64_t m_state[4];
+
+        static uint64_t rotl(uint64_t x, int k) { return (x << k) | (x >> (64 - k)); }
+        void applyJump(const uint64_t polynomial[4]);
+    };
+
+    /*
+    The PCG64 generator by O'Neill (XSL RR 128/64): a 128 bit linear congruential state with a permuted output.
+    Every odd increment selects a different stream, and advance() jumps ahead by any number of steps in O(log n).
+    */
+    class Pcg64
+    {
+    public:
+        typedef uint64_t result_type;
+
+        explicit Pcg64(uint64_t seed = 0, uint64_t stream = 0) { this->seed(seed, stream); }
+
+        /*
+        Seeds the generator.
+        Parameters:
+        - seed: The initial state.
+        - stream: The stream index. Generators with different streams produce independent sequences from the same seed.
+        */
+        void seed(uint64_t seed, uint64_t stream = 0);
+
+        result_type operator()()
+        {
+            m_state = m_state * kMultiplier + m_increment;
+
+            const uint64_t value = static_cast<uint64_t>(m_state >> 64) ^ static_cast<uint64_t>(m_state);
+            const unsigned rotation = static_cast<unsigned>(m_state >> 122);
+
+            return (value >> rotation) | (value << ((64 - rotation) & 63));
+        }
+
+        /*
+        Advances the generator by delta steps.
+        */
+        void advance(uint64_t delta);
+
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return UINT64_MAX; }
+
+    private:
+        // A compiler extension supported by GCC and Clang on 64 bit targets
+        __extension__ typedef unsigned __int128 uint128_t;
+
+        static constexpr uint128_t kMultiplier = (static_cast<uint128_t>(2549297995355413924ULL) << 64) | 4865540595714422341ULL;
+
+        uint128_t m_state;
+        uint128_t m_increment;
+    };
+
+    /*
+    The Philox4x32-10 counter based generator by Salmon et al. (Random123). Every 128 bit counter is mapped to 128 random bits
+    by a keyed bijection, so the n-th value of a stream is computed directly, without generating the previous ones.
+    A generator is keyed by a seed and addresses its values by (stream, position): with one stream per trajectory and one position
+    per step, any value of any trajectory can be reproduced on its own, in any order and on any thread.
+    Each counter yields two 64 bit outputs: position p is the half p % 2 of the block p / 2.
+    */
+    class Philox4x32
+    {
+    public:
+        typedef uint64_t result_type;
+
+        explicit Philox4x32(uint64_t seed = 0, uint64_t stream = 0) { this->seed(seed); setStream(stream); }
+
+        /*
+        Sets the key and moves to the beginning of stream 0.
+        */
+        void seed(uint64_t seed)
+        {
+            m_key[0] = static_cast<uint32_t>(seed);
+            m_key[1] = static_cast<uint32_t>(seed >> 32);
+            setStream(0);
+        }
+
+        /*
+        Moves to the beginning of the given stream.
+        */
+        void setStream(uint64_t stream)
+        {
+            m_stream = stream;
+            setPosition(0);
+        }
+
+        /*
+        Moves to the given position of the current stream, in O(1).
+        */
+        void setPosition(uint64_t position)
+        {
+            m_position = position;
+            m_block = UINT64_MAX;
+        }
+
+        uint64_t getStream() const { return m_stream; }
+        uint64_t getPosition() const { return m_position; }
+
+        result_type operator()()
+        {
+            const uint64_t block = m_position >> 1;
+
+            if (block != m_block)
+            {
+                generateBlock(m_key, m_stream, block, m_output);
+                m_block = block;
+            }
+
+            return m_output[m_position++ & 1];
+        }
+
+        /*
+        Returns the value at a position of a stream without any state.
+        Parameters:
+        - seed: The key.
+        - stream: The stream, e.g. the trajectory index.
+        - position: The position in the stream, e.g. the step.
+        */
+        static uint64_t valueAt(uint64_t seed, uint64_t stream, uint64_t position)
+        {
+            uint64_t output[2];
+            blockAt(seed, stream, position >> 1, output);
+
+            return output[position & 1];
+        }
+
+        /*
+        Computes the two values of a block of a stream, i.e. the positions 2 * block and 2 * block + 1, without any state.
+        */
+        static void blockAt(uint64_t seed, uint64_t stream, uint64_t block, uint64_t output[2])
+        {
+            const uint32_t key[2] = { static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32) };
+            generateBlock(key, stream, block, output);
+        }
+
+        /*
+        Applies the ten Philox rounds to a counter.
+        Parameters:
+        - counter: The 128 bit counter, replaced by the random output.
+        - key: The 64 bit key.
+        */
+        static void applyRounds(uint32_t counter[4], const uint32_t key[2])
+        {
+            uint32_t k0 = key[0];
+            uint32_t k1 = key[1];
+
+            for (int round = 0; round < 10; ++round)
+            {
+                const uint64_t p0 = static_cast<uint64_t>(0xD2511F53u) * counter[0];
+                const uint64_t p1 = static_cast<uint64_t>(0xCD9E8D57u) * counter[2];
+
+                const uint32_t c0 = static_cast<uint32_t>(p1 >> 32) ^ counter[1] ^ k0;
+                const uint32_t c2 = static_cast<uint32_t>(p0 >> 32) ^ counter[3] ^ k1;
+
+                counter[0] = c0;
+                counter[1] = static_cast<uint32_t>(p1);
+                counter[2] = c2;
+                counter[3] = static_cast<uint32_t>(p0);
+
+                k0 += 0x9E3779B9u;
+                k1 += 0xBB67AE85u;
+            }
+        }
+
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return UINT64_MAX; }
+
+    private:
+        uint32_t m_key[2];
+        uint64_t m_stream;
+        uint64_t m_position;
+        uint64_t m_block;
+        uint64_t m_output[2];
+
+        static void generateBlock(const uint32_t key[2], uint64_t stream, uint64_t block, uint64_t output[2])
+        {
+            uint32_t counter[4] = { static_cast<uint32_t>(block), static_cast<uint32_t>(block >> 32), static_cast<uint32_t>(stream), static_cast<uint32_t>(stream >> 32) };
+
+            applyRounds(counter, key);
+
+            output[0] = counter[0] | (static_cast<uint64_t>(counter[1]) << 32);
+            output[1] = counter[2] | (static_cast<uint64_t>(counter[3]) << 32);
+        }
+    };
+
     class RngBase
     {
     public:
@@ -13,17 +275,184 @@ namespace rlib
 
         virtual real_t getRandomReal(real_t lower = 0.0, real_t upper = 1.0) = 0;
         virtual int getRandomInt(int lower, int upper) = 0;
+
+        /*
+        Fills an array with random real numbers in the range [lower, upper), one virtual call for the whole array.
+        The values are the same that count calls to getRandomReal() would return.
+        Parameters:
+        - out: The array to fill.
+        - count: The number of values.
+        - lower: The inclusive lower bound.
+        - upper: The exclusive upper bound.
+        */
+        virtual void fillUniform(real_t* out, size_t count, real_t lower = 0.0, real_t upper = 1.0);
+
+        /*
+        Fills an array with random integers, with the same range convention as getRandomInt().
+        */
+        virtual void fillInt(int* out, size_t count, int lower, int upper);
+
+        /*
+        Fills an array with exponentially distributed random numbers.
+        Parameters:
+        - out: The array to fill.
+        - count: The number of values.
+        - rate: The rate of the distribution, i.e. the inverse of its mean.
+        */
+        virtual void fillExponential(real_t* out, size_t count, real_t rate = 1.0);
+    };
+
+    /*
+    Sets the seed all the thread local generators returned by getThreadRng() derive from. Threads reseed their generator
+    the next time they call getThreadRng(), so a run is reproducible as long as every thread draws the same numbers.
+    The initial seed is 0.
+    Parameters:
+    - seed: The global seed.
+    */
+    void setGlobalSeed(uint64_t seed);
+    uint64_t getGlobalSeed();
+
+    /*
+    Returns a seed from the operating system entropy source, for runs that must not be reproducible.
+    */
+    uint64_t generateRandomSeed();
+
+    /*
+    A generator with an explicit seed, running a given engine. Unlike DefaultRng, any number of instances can be created,
+    e.g. one per thread or per simulated agent.
+    */
+    template <typename Engine>
+    class EngineRng final : public RngBase
+    {
+    public:
+        explicit EngineRng(uint64_t seed = 0) : m_engine(seed) {}
+        virtual ~EngineRng() override = default;
+
+        void seed(uint64_t seed) { m_engine.seed(seed); }
+
+        /*
+        Returns a random real number in the range [lower, upper).
+        */
+        virtual real_t getRandomReal(real_t lower = 0.0, real_t upper = 1.0) override { return lower + (upper - lower) * uniformRealFromBits(m_engine()); }
+
+        /*
+        Returns a random integer in the range [lower, upper], like the other generators.
+        */
+        virtual int getRandomInt(int lower, int upper) override
+        {
+            std::uniform_int_distribution<int> dist(lower, upper);
+            return dist(m_engine);
+        }
+
+        // The engine is inlined into the loops, which only pay one virtual call per array. It is copied to a local so that
+        // its state stays in registers, instead of being reloaded after every store to an array that might alias it.
+        virtual void fillUniform(real_t* out, size_t count, real_t lower = 0.0, real_t upper = 1.0) override
+        {
+            Engine engine = m_engine;
+            const real_t range = upper - lower;
+
+            for (size_t i = 0; i < count; ++i)
+                out[i] = lower + range * uniformRealFromBits(engine());
+
+            m_engine = engine;
+        }
+
+        virtual void fillInt(int* out, size_t count, int lower, int upper) override
+        {
+            Engine engine = m_engine;
+            std::uniform_int_distribution<int> dist(lower, upper);
+
+            for (size_t i = 0; i < count; ++i)
+                out[i] = dist(engine);
+
+            m_engine = engine;
+        }
+
+        virtual void fillExponential(real_t* out, size_t count, real_t rate = 1.0) override
+        {
+            // The logarithms are computed in a separate pass, free of the sequential dependency of the engine
+            fillUniform(out, count);
+
+            for (size_t i = 0; i < count; ++i)
+                out[i] = -std::log1p(-out[i]) / rate;
+        }
+
+        Engine& getEngine() { return m_engine; }
+
+        // The generator is also a non virtual UniformRandomBitGenerator, which is what drawUniformReal() inlines
+        typedef typename Engine::result_type result_type;
+        static constexpr result_type min() { return Engine::min(); }
+        static constexpr result_type max() { return Engine::max(); }
+        result_type operator()() { return m_engine(); }
+
+    private:
+        Engine m_engine;
     };
 
+    typedef EngineRng<Xoshiro256PlusPlus> XoshiroRng;
+    typedef EngineRng<Pcg64> Pcg64Rng;
+    typedef EngineRng<Philox4x32> PhiloxRng;
+
+    /*
+    Draws a uniform real number in [0, 1) from a generator whose type is known at compile time, which lets the compiler
+    inline the draw into the caller's loop. Accepts any UniformRandomBitGenerator producing 64 bits, e.g. Xoshiro256PlusPlus,
+    Pcg64, XoshiroRng or std::mt19937_64.
+    */
+    template <typename Generator>
+    inline typename std::enable_if<Generator::min() == 0 && Generator::max() == UINT64_MAX, real_t>::type drawUniformReal(Generator& generator)
+    {
+        return uniformRealFromBits(generator());
+    }
+
+    /*
+    Overload for any other generator, drawing through the virtual RngBase interface.
+    */
+    inline real_t drawUniformReal(RngBase& rng)
+    {
+        return rng.getRandomReal();
+    }
+
+    /*
+    Returns the generator of the calling thread, created on first use. The generator of stream i is seeded with
+    deriveSeed(getGlobalSeed(), i), so its numbers only depend on the global seed and on the stream, not on the other threads.
+    A thread that did not call setThreadStream() gets an automatic stream in order of first use, which is only reproducible
+    if the threads start drawing in the same order on every run.
+    */
+    XoshiroRng& getThreadRng();
+
+    /*
+    Gives the calling thread an explicit stream, e.g. the threadIndex passed by ThreadPool::parallelFor(), and reseeds its
+    generator from the global seed. Two threads using the same stream draw the same numbers, which makes parallel runs
+    reproducible whatever the scheduling.
+    Parameters:
+    - stream: The index of the stream, below kAutomaticThreadStream so that it never collides with an automatic stream.
+    */
+    void setThreadStream(uint64_t stream);
+
+    // First stream handed out to the threads that did not call setThreadStream()
+    static const uint64_t kAutomaticThreadStream = 1ULL << 63;
+
+    /*
+    Legacy shared generator. It forwards every draw to getThreadRng(), so it is safe to use from several threads;
+    new code should call getThreadRng() directly.
+    */
     class DefaultRng final : public Singleton<DefaultRng>, public RngBase
     {
         friend class Singleton<DefaultRng>;
     private:
-        urng_t m_engine;
-
-        DefaultRng();
+        DefaultRng() = default;
         virtual ~DefaultRng() override = default;
     public:
+        /*
+        Returns the instance, created on first use. Unlike Singleton::getInstance(), the creation is thread safe
+        since the instance is a function local static.
+        */
+        static DefaultRng* getInstance()
+        {
+            static DefaultRng instance;
+            return &instance;
+        }
+
         /*
         Returns a random real number in the range [lower, upper).
         Returns:
@@ -32,11 +461,33 @@ namespace rlib
         virtual real_t getRandomReal(real_t lower = 0.0, real_t upper = 1.0) override;
 
         /*
-        Returns a random integer in the range [lower, upper).
+        Returns a random integer in the range [lower, upper].
         Returns:
-        - A random integer between lower (inclusive) and upper (exclusive).
+        - A random integer between lower and upper, both inclusive.
+        */
+        virtual int getRandomInt(int lower, int upper) override;
+    };
+
+    /*
+    A non shared generator with an explicit seed. Unlike DefaultRng, any number of instances can be created,
+    e.g. one per thread or per simulated agent.
+    */
+    class SeededRng final : public RngBase
+    {
+    private:
+        urng_t m_engine;
+    public:
+        SeededRng(uint32_t seed) : m_engine(seed) {}
+        virtual ~SeededRng() override = default;
+
+        /*
+        Reseeds the underlying engine.
         */
+        void seed(uint32_t seed) { m_engine.seed(seed); }
+
+        virtual real_t getRandomReal(real_t lower = 0.0, real_t upper = 1.0) override;
         virtual int getRandomInt(int lower, int upper) override;
+        virtual void fillUniform(real_t* out, size_t count, real_t lower = 0.0, real_t upper = 1.0) override;
     };
 } // namespace rlib
 
@@ -0,0 +1,110 @@
+#include "Sobol.h"
+
+#include "Rng.h"
+#include "GeneralUtil.h"
+
+namespace rlib
+{
+    const uint32_t SobolSequence::kMaxDimensions;
+    const uint32_t SobolSequence::kNumBits;
+
+    namespace
+    {
+        struct PrimitivePolynomial
+        {
+            uint32_t degree;
+            uint32_t coefficients;      // Inner coefficients of the polynomial, the leading and constant ones are implicit
+            uint32_t initialNumbers[6]; // The odd numbers m_1..m_degree, m_i < 2^i
+        };
+
+        // Joe and Kuo, new-joe-kuo-6.21201, dimensions 2 to 16. The first dimension is the van der Corput sequence.
+        const PrimitivePolynomial kPolynomials[SobolSequence::kMaxDimensions - 1] =
+        {
+            { 1, 0, { 1 } },
+            { 2, 1, { 1, 3 } },
+            { 3, 1, { 1, 3, 1 } },
+            { 3, 2, { 1, 1, 1 } },
+            { 4, 1, { 1, 1, 3, 3 } },
+            { 4, 4, { 1, 3, 5, 13 } },
+            { 5, 2, { 1, 1, 5, 5, 17 } },
+            { 5, 4, { 1, 1, 5, 5, 5 } },
+            { 5, 7, { 1, 1, 7, 11, 19 } },
+            { 5, 11, { 1, 1, 5, 1, 1 } },
+            { 5, 13, { 1, 1, 1, 3, 11 } },
+            { 5, 14, { 1, 3, 5, 5, 31 } },
+            { 6, 1, { 1, 3, 3, 9, 7, 49 } },
+            { 6, 13, { 1, 1, 1, 15, 21, 21 } },
+            { 6, 16, { 1, 3, 1, 13, 27, 49 } }
+        };
+
+        /*
+        Multiplies a binary matrix, given by its rows, by the vector of the digits of x.
+        */
+        uint32_t multiply(const uint32_t rows[SobolSequence::kNumBits], uint32_t x)
+        {
+            uint32_t result = 0;
+
+            for (uint32_t k = 0; k < SobolSequence::kNumBits; ++k)
+                result |= static_cast<uint32_t>(__builtin_parity(rows[k] & x)) << (SobolSequence::kNumBits - 1 - k);
+
+            return result;
+        }
+    }
+
+    SobolSequence::SobolSequence(uint32_t numDimensions) : m_numDimensions(numDimensions)
+    {
+        if (numDimensions == 0 || numDimensions > kMaxDimensions)
+            REPORT_PANIC("SobolSequence::SobolSequence: the number of dimensions must be between 1 and kMaxDimensions");
+
+        m_directions.resize(numDimensions * kNumBits);
+        m_shifts.assign(numDimensions, 0);
+
+        for (uint32_t j = 0; j < kNumBits; ++j)
+            m_directions[j] = 1u << (kNumBits - 1 - j);
+
+        for (uint32_t d = 1; d < numDimensions; ++d)
+        {
+            const PrimitivePolynomial& polynomial = kPolynomials[d - 1];
+            const uint32_t s = polynomial.degree;
+            uint32_t* v = &m_directions[d * kNumBits];
+
+            for (uint32_t j = 0; j < s; ++j)
+                v[j] = polynomial.initialNumbers[j] << (kNumBits - 1 - j);
+
+            // Recurrence of the direction numbers given by the polynomial
+            for (uint32_t j = s; j < kNumBits; ++j)
+            {
+                v[j] = v[j - s] ^ (v[j - s] >> s);
+
+                for (uint32_t k = 1; k < s; ++k)
+                {
+                    if ((polynomial.coefficients >> (s - 1 - k)) & 1)
+                        v[j] ^= v[j - k];
+                }
+            }
+        }
+    }
+
+    void SobolSequence::scramble(uint64_t seed)
+    {
+        for (uint32_t d = 0; d < m_numDimensions; ++d)
+        {
+            // Row k of the random lower triangular matrix: the digit k itself plus random more significant digits
+            uint32_t rows[kNumBits];
+            for (uint32_t k = 0; k < kNumBits; ++k)
+            {
+                const uint32_t digit = 1u << (kNumBits - 1 - k);
+                const uint32_t moreSignificant = ~(digit | (digit - 1));
+
+                rows[k] = digit | (static_cast<uint32_t>(Philox4x32::valueAt(seed, d, k)) & moreSignificant);
+            }
+
+            // The scrambling is linear, so it can be applied to the direction numbers once instead of to every point
+            uint32_t* v = &m_directions[d * kNumBits];
+            for (uint32_t j = 0; j < kNumBits; ++j)
+                v[j] = multiply(rows, v[j]);
+
+            m_shifts[d] = multiply(rows, m_shifts[d]) ^ static_cast<uint32_t>(Philox4x32::valueAt(seed, d, kNumBits));
+        }
+    }
+} // namespace rlib
\ No newline at end of file
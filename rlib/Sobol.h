@@ -0,0 +1,71 @@
+#ifndef SOBOL_H
+#define SOBOL_H
+
+#include <cstdint>
+#include <vector>
+
+#include "../mocc/mocc.hpp"
+
+namespace rlib
+{
+    /*
+    The Sobol low discrepancy sequence, with the Joe-Kuo direction numbers. In every dimension, each of the first 2^m points
+    falls in a different interval of width 2^-m, which makes the quasi Monte Carlo integration error of smooth integrands
+    decrease almost as 1/n instead of 1/sqrt(n).
+    The points of a scrambled sequence are uniformly distributed while keeping this stratification, so that independent
+    scramblings give independent, unbiased estimates whose spread measures the error.
+    */
+    class SobolSequence
+    {
+    public:
+        static const uint32_t kMaxDimensions = 16;
+        static const uint32_t kNumBits = 32;
+
+        /*
+        Creates the unscrambled sequence.
+        Parameters:
+        - numDimensions: The number of dimensions, at most kMaxDimensions.
+        */
+        explicit SobolSequence(uint32_t numDimensions);
+
+        /*
+        Applies a random linear matrix scrambling (Matousek) and a random digital shift to every dimension.
+        Scrambling an already scrambled sequence gives another valid randomization.
+        Parameters:
+        - seed: The seed of the scrambling, each seed gives an independent randomization of the sequence.
+        */
+        void scramble(uint64_t seed);
+
+        uint32_t getNumDimensions() const { return m_numDimensions; }
+
+        /*
+        Returns the 32 bit fixed point coordinate of a point in a dimension, computed directly from the index in O(log(index)).
+        */
+        uint32_t getBits(uint32_t index, uint32_t dimension) const
+        {
+            const uint32_t* directions = &m_directions[dimension * kNumBits];
+            uint32_t x = m_shifts[dimension];
+
+            // Gray code order, so that consecutive points differ by a single direction number
+            for (uint32_t gray = index ^ (index >> 1), j = 0; gray != 0; gray >>= 1, ++j)
+            {
+                if (gray & 1)
+                    x ^= directions[j];
+            }
+
+            return x;
+        }
+
+        /*
+        Returns the coordinate of a point in a dimension, in [0, 1).
+        */
+        real_t getValue(uint32_t index, uint32_t dimension) const { return getBits(index, dimension) * (1.0 / 4294967296.0); }
+
+    private:
+        uint32_t m_numDimensions;
+        std::vector<uint32_t> m_directions;     // kNumBits direction numbers per dimension, the most significant digit first
+        std::vector<uint32_t> m_shifts;
+    };
+} // namespace rlib
+
+#endif // SOBOL_H
\ No newline at end of file
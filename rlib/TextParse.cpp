@@ -0,0 +1,202 @@
+#include "TextParse.h"
+
+#include <cerrno>
+#include <climits>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace rlib
+{
+    namespace
+    {
+        // Powers of ten exactly representable as doubles
+        const double kExactPowersOfTen[23] =
+        {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+
+        /*
+        Parses the digits of an unsigned decimal, failing if there are none or if the value exceeds maxValue.
+        */
+        bool parseDigits(const char* begin, const char* end, uint64_t maxValue, uint64_t& outValue)
+        {
+            uint64_t value = 0;
+
+            for (const char* p = begin; p < end; ++p)
+            {
+                const unsigned digit = static_cast<unsigned>(*p - '0');
+                if (digit > 9)
+                    return false;
+
+                value = value * 10 + digit;
+                if (value > maxValue)
+                    return false;
+            }
+
+            outValue = value;
+
+            return begin < end;
+        }
+
+        /*
+        Fast path of parseDouble(): [sign] digits [. digits] [e [sign] digits], exact when the mantissa and the power of ten
+        are both exactly representable (Clinger). Returns false to hand any other case over to strtod.
+        */
+        bool parseSimpleDouble(const char* p, const char* end, double& outValue)
+        {
+            const bool isNegative = p < end && *p == '-';
+            if (p < end && (*p == '-' || *p == '+'))
+                ++p;
+
+            uint64_t mantissa = 0;
+            int numDigits = 0;
+            int exponent = 0;
+            bool hasDigits = false;
+
+            for (; p < end && static_cast<unsigned>(*p - '0') <= 9; ++p, hasDigits = true)
+            {
+                if (mantissa == 0 && *p == '0')
+                    continue;
+
+                mantissa = mantissa * 10 + (*p - '0');
+                if (++numDigits > 19)
+                    return false;
+            }
+
+            if (p < end && *p == '.')
+            {
+                for (++p; p < end && static_cast<unsigned>(*p - '0') <= 9; ++p, hasDigits = true)
+                {
+                    exponent--;
+
+                    if (mantissa == 0 && *p == '0')
+                        continue;
+
+                    mantissa = mantissa * 10 + (*p - '0');
+                    if (++numDigits > 19)
+                        return false;
+                }
+            }
+
+            if (!hasDigits)
+                return false;
+
+            if (p < end && (*p == 'e' || *p == 'E'))
+            {
+                ++p;
+
+                const bool isExponentNegative = p < end && *p == '-';
+                if (p < end && (*p == '-' || *p == '+'))
+                    ++p;
+
+                uint64_t explicitExponent;
+                if (!parseDigits(p, end, 1000, explicitExponent))
+                    return false;
+
+                exponent += isExponentNegative ? -static_cast<int>(explicitExponent) : static_cast<int>(explicitExponent);
+                p = end;
+            }
+
+            if (p != end || mantissa > (1ull << 53) || exponent < -22 || exponent > 22)
+                return false;
+
+            double value = static_cast<double>(mantissa);
+            value = exponent < 0 ? value / kExactPowersOfTen[-exponent] : value * kExactPowersOfTen[exponent];
+
+            outValue = isNegative ? -value : value;
+
+            return true;
+        }
+
+        bool equalsIgnoringCase(const char* begin, const char* end, const char* word)
+        {
+            const size_t length = strlen(word);
+            if (static_cast<size_t>(end - begin) != length)
+                return false;
+
+            for (size_t i = 0; i < length; ++i)
+            {
+                if ((begin[i] | 0x20) != word[i])
+                    return false;
+            }
+
+            return true;
+        }
+    }
+
+    bool parseInt(const char* begin, const char* end, int& outValue)
+    {
+        const bool isNegative = begin < end && *begin == '-';
+        if (begin < end && (*begin == '-' || *begin == '+'))
+            ++begin;
+
+        uint64_t magnitude;
+        if (!parseDigits(begin, end, isNegative ? static_cast<uint64_t>(INT_MAX) + 1 : INT_MAX, magnitude))
+            return false;
+
+        outValue = isNegative ? static_cast<int>(-static_cast<int64_t>(magnitude)) : static_cast<int>(magnitude);
+
+        return true;
+    }
+
+    bool parseUInt(const char* begin, const char* end, uint32_t& outValue)
+    {
+        if (begin < end && *begin == '+')
+            ++begin;
+
+        uint64_t value;
+        if (!parseDigits(begin, end, UINT32_MAX, value))
+            return false;
+
+        outValue = static_cast<uint32_t>(value);
+
+        return true;
+    }
+
+    bool parseDouble(const char* begin, const char* end, double& outValue)
+    {
+        if (parseSimpleDouble(begin, end, outValue))
+            return true;
+
+        // strtod needs a terminated string, mapped lines are not
+        char buffer[128];
+        const size_t length = end - begin;
+
+        if (length == 0 || length >= sizeof(buffer) || isBlank(*begin))
+            return false;
+
+        memcpy(buffer, begin, length);
+        buffer[length] = '\0';
+
+        char* parsedEnd = nullptr;
+        errno = 0;
+        outValue = strtod(buffer, &parsedEnd);
+
+        return parsedEnd == buffer + length && errno != ERANGE;
+    }
+
+    bool parseFloat(const char* begin, const char* end, float& outValue)
+    {
+        double value;
+        if (!parseDouble(begin, end, value) || (std::isfinite(value) && std::fabs(value) > 3.4028234663852886e38))
+            return false;
+
+        outValue = static_cast<float>(value);
+
+        return true;
+    }
+
+    bool parseBool(const char* begin, const char* end, bool& outValue)
+    {
+        if (equalsIgnoringCase(begin, end, "true") || (end - begin == 1 && *begin == '1'))
+            outValue = true;
+        else if (equalsIgnoringCase(begin, end, "false") || (end - begin == 1 && *begin == '0'))
+            outValue = false;
+        else
+            return false;
+
+        return true;
+    }
+} // namespace rlib
\ No newline at end of file
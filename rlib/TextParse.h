@@ -0,0 +1,68 @@
+#ifndef TEXT_PARSE_H
+#define TEXT_PARSE_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace rlib
+{
+    /*
+    Non throwing parsers working in place on character ranges [begin, end), which need not be null terminated,
+    e.g. the lines of a mapped file. Every parser succeeds only if it consumes the whole range.
+    */
+
+    inline bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+    /*
+    Splits the next blank separated token off [p, end), advancing p past it.
+    Returns:
+    - true if a token was found, false if only blanks were left.
+    */
+    inline bool nextToken(const char*& p, const char* end, const char*& outBegin, const char*& outEnd)
+    {
+        while (p < end && isBlank(*p))
+            ++p;
+
+        outBegin = p;
+
+        while (p < end && !isBlank(*p))
+            ++p;
+
+        outEnd = p;
+
+        return outBegin < outEnd;
+    }
+
+    /*
+    Removes the leading and trailing blanks of a range.
+    */
+    inline void trimBlanks(const char*& begin, const char*& end)
+    {
+        while (begin < end && isBlank(*begin))
+            ++begin;
+
+        while (end > begin && isBlank(end[-1]))
+            --end;
+    }
+
+    /*
+    Parses a decimal integer with an optional sign, failing on overflow.
+    */
+    bool parseInt(const char* begin, const char* end, int& outValue);
+    bool parseUInt(const char* begin, const char* end, uint32_t& outValue);
+
+    /*
+    Parses a floating point number. Plain decimals ("-12.5", "3e-4") with up to 19 significant digits are converted exactly
+    without a library call, the other forms (hexadecimal, inf, nan, long mantissas) go through strtod, so the result is
+    always the correctly rounded value.
+    */
+    bool parseDouble(const char* begin, const char* end, double& outValue);
+    bool parseFloat(const char* begin, const char* end, float& outValue);
+
+    /*
+    Parses "true", "false", "1" or "0", ignoring the case.
+    */
+    bool parseBool(const char* begin, const char* end, bool& outValue);
+} // namespace rlib
+
+#endif // TEXT_PARSE_H
\ No newline at end of file
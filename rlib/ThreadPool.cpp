@@ -0,0 +1,95 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace rlib
+{
+    ThreadPool::ThreadPool(unsigned numThreads) : m_task(nullptr), m_taskCount(0), m_numParts(0), m_generation(0), m_numPending(0), m_isStopping(false)
+    {
+        if (numThreads == 0)
+            numThreads = std::max(1u, std::thread::hardware_concurrency());
+
+        for (unsigned i = 1; i < numThreads; ++i)
+            m_workers.push_back(std::thread(&ThreadPool::workerLoop, this, i));
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_isStopping = true;
+        }
+
+        m_workAvailable.notify_all();
+
+        for (size_t i = 0; i < m_workers.size(); ++i)
+            m_workers[i].join();
+    }
+
+    void ThreadPool::parallelFor(size_t count, const std::function<void(size_t, size_t, unsigned)>& fn)
+    {
+        // With fewer items than threads, every item still gets a thread of its own
+        const unsigned numParts = static_cast<unsigned>(std::min<size_t>(count, getNumThreads()));
+
+        if (numParts <= 1)
+        {
+            fn(0, count, 0);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_task = &fn;
+            m_taskCount = count;
+            m_numParts = numParts;
+            m_numPending = numParts - 1;
+            m_generation++;
+        }
+
+        m_workAvailable.notify_all();
+
+        fn(0, count / numParts, 0);
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_workDone.wait(lock, [this]() { return m_numPending == 0; });
+        m_task = nullptr;
+    }
+
+    void ThreadPool::workerLoop(unsigned threadIndex)
+    {
+        uint64_t lastGeneration = 0;
+
+        for (;;)
+        {
+            const std::function<void(size_t, size_t, unsigned)>* task;
+            size_t count;
+            unsigned numParts;
+
+            {
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_workAvailable.wait(lock, [this, lastGeneration]() { return m_isStopping || m_generation != lastGeneration; });
+
+                if (m_isStopping)
+                    return;
+
+                lastGeneration = m_generation;
+                task = m_task;
+                count = m_taskCount;
+                numParts = m_numParts;
+            }
+
+            // The workers beyond the number of parts have nothing to do in this loop
+            if (threadIndex >= numParts)
+                continue;
+
+            (*task)(count * threadIndex / numParts, count * (threadIndex + 1) / numParts, threadIndex);
+
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                m_numPending--;
+            }
+
+            m_workDone.notify_one();
+        }
+    }
+} // namespace rlib
\ No newline at end of file
@@ -0,0 +1,59 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace rlib
+{
+    /*
+    A fixed set of worker threads executing data parallel loops.
+    The workers are created once and sleep between calls, so the pool can be reused for many short parallel sweeps.
+    */
+    class ThreadPool
+    {
+    public:
+        /*
+        Creates the pool.
+        Parameters:
+        - numThreads: The total number of threads taking part in a loop, including the calling thread. 0 uses all the available cores.
+        */
+        ThreadPool(unsigned numThreads = 0);
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        unsigned getNumThreads() const { return static_cast<unsigned>(m_workers.size()) + 1; }
+
+        /*
+        Splits the range [0, count) into min(count, getNumThreads()) contiguous chunks and runs fn(begin, end, threadIndex) on each chunk,
+        one chunk per thread. The calling thread processes the first chunk. Returns when all the chunks have been processed.
+        Parameters:
+        - count: The number of items.
+        - fn: The function processing the items in [begin, end), threadIndex is in [0, getNumThreads()).
+        */
+        void parallelFor(size_t count, const std::function<void(size_t, size_t, unsigned)>& fn);
+
+    private:
+        void workerLoop(unsigned threadIndex);
+
+        std::vector<std::thread> m_workers;
+        std::mutex m_mutex;
+        std::condition_variable m_workAvailable;
+        std::condition_variable m_workDone;
+
+        const std::function<void(size_t, size_t, unsigned)>* m_task;
+        size_t m_taskCount;
+        unsigned m_numParts;        // Number of threads taking part in the current loop
+        uint64_t m_generation;
+        unsigned m_numPending;
+        bool m_isStopping;
+    };
+} // namespace rlib
+
+#endif // THREAD_POOL_H
\ No newline at end of file
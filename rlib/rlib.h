@@ -2,9 +2,24 @@
 #define RLIB_H
 
 #include "Mdp.h"
+#include "MdpModel.h"
+#include "MdpModelBuilder.h"
+#include "MdpRunner.h"
+#include "MdpBatchRunner.h"
+#include "MdpRollout.h"
+#include "MdpSolver.h"
+#include "ActionMdpModel.h"
+#include "ActionMdpSolver.h"
+#include "ThreadPool.h"
+#include "Arena.h"
+#include "MappedFile.h"
+#include "Sobol.h"
 #include "Rng.h"
 #include "GeneralUtil.h"
 #include "Debug.h"
+#include "ParameterStore.h"
 #include "ParameterManager.h"
+#include "LiveParameterManager.h"
+#include "TextParse.h"
 
 #endif // RLIB_H
\ No newline at end of file
@@ -1,6 +1,16 @@
 #include "../rlib/rlib.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <random>
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <sstream>
 
 void reportTestResultTest()
 {
@@ -20,9 +30,723 @@ void logTest()
     LOG_ERROR("This is a log error message.\n");
 }
 
+void buildTestMdp(rlib::MDP& mdp)
+{
+    // Same chain as parameters.txt: 0 -> 1 -> {2, 3}, 2 -> 3, 3 is terminal
+    mdp.getStateAt(0)->addTransition(new rlib::MDP::StateTransition(0, 1, 1.0, 100.0));
+    mdp.getStateAt(1)->addTransition(new rlib::MDP::StateTransition(1, 2, 0.7, 100.0));
+    mdp.getStateAt(1)->addTransition(new rlib::MDP::StateTransition(2, 3, 0.3, 150.0));
+    mdp.getStateAt(2)->addTransition(new rlib::MDP::StateTransition(3, 3, 1.0, 100.0));
+    mdp.getStateAt(3)->addTransition(new rlib::MDP::StateTransition(4, 3, 1.0, 0.0));
+}
+
 void mdpTest()
 {
     printf("------MDP test------\n");
+
+    rlib::MDP mdp(4);
+    buildTestMdp(mdp);
+    mdp.initialize();
+
+    const rlib::MdpModel& model = mdp.getModel();
+
+    REPORT_TEST_RESULT(mdp.isSealed() && model.getNumStates() == 4 && model.getNumTransitions() == 5, "Sealed MDP should have 4 states and 5 transitions");
+    REPORT_TEST_RESULT(model.getRowBegin(1) == 1 && model.getRowEnd(1) == 3, "State 1 transitions should occupy the range [1, 3)");
+    REPORT_TEST_RESULT(model.isTerminal(3) && !model.isTerminal(0), "Only state 3 should be terminal");
+    REPORT_TEST_RESULT(mdp.getStateAt(1)->getTransitionToState(3)->getId() == 2, "Transition from state 1 to state 3 should have ID 2");
+    REPORT_TEST_RESULT(mdp.getStateAt(0)->getTransitionToState(2) == nullptr, "There should be no transition from state 0 to state 2");
+
+    int numSteps = 0;
+    while (!mdp.isTerminal() && numSteps < 10)
+    {
+        mdp.update();
+        numSteps++;
+    }
+
+    real_t cost = mdp.getTotalCost();
+    REPORT_TEST_RESULT(mdp.isTerminal() && (ARE_REALS_EQUAL(cost, 250.0) || ARE_REALS_EQUAL(cost, 300.0)), "Trajectory cost should be 250 or 300 (got %.1f)", cost);
+}
+
+void mdpArenaTest()
+{
+    printf("------MDP arena test------\n");
+
+    rlib::MDP mdp;
+    for (uint32_t i = 0; i < 4; ++i)
+        mdp.createState(i);
+
+    mdp.getState(0)->createTransition(0, 1, 1.0, 100.0);
+    mdp.getState(1)->createTransition(1, 2, 0.7, 100.0);
+    mdp.getState(1)->createTransition(2, 3, 0.3, 150.0);
+    mdp.getState(2)->createTransition(3, 3, 1.0, 100.0);
+    mdp.getState(3)->createTransition(4, 3, 1.0, 0.0);
+
+    const rlib::Arena& arena = mdp.getArena();
+    REPORT_TEST_RESULT(arena.getNumBlocks() == 1 && arena.owns(mdp.getState(1)) && arena.owns(mdp.getState(1)->getTransitionToState(3)), "States and transitions should live in a single arena block");
+
+    rlib::MdpSolverResult result = rlib::MdpCostSolver(mdp.getSharedModel()).solve();
+    REPORT_TEST_RESULT(result.converged && std::fabs(result.values[0] - 285.0) < 1e-6, "Arena built MDP should behave like a heap built one");
+
+    mdp.finalize();
+    REPORT_TEST_RESULT(mdp.getNumStates() == 0 && arena.getNumBlocks() == 0 && arena.getBytesUsed() == 0, "Finalize should release the arena");
+}
+
+void mdpLookupTest()
+{
+    printf("------MDP lookup test------\n");
+
+    rlib::MDP mdp;
+    const uint32_t ids[3] = { 30, 10, 20 };
+    for (int i = 0; i < 3; ++i)
+        mdp.addState(new rlib::MDP::State(&mdp, ids[i]));
+
+    REPORT_TEST_RESULT(mdp.getState(10) == mdp.getStateAt(1) && mdp.getState(20) == mdp.getStateAt(2), "States should be found by ID");
+
+    rlib::MDP::State* state = mdp.getState(30);
+    state->addTransition(new rlib::MDP::StateTransition(0, 20, 0.25, 1.0));
+    state->addTransition(new rlib::MDP::StateTransition(1, 10, 0.25, 2.0));
+    state->addTransition(new rlib::MDP::StateTransition(2, 30, 0.5, 3.0));
+    mdp.getState(10)->addTransition(new rlib::MDP::StateTransition(3, 10, 1.0, 0.0));
+    mdp.getState(20)->addTransition(new rlib::MDP::StateTransition(4, 20, 1.0, 0.0));
+
+    bool sorted = true;
+    for (size_t i = 1; i < state->getNumTransitions(); ++i)
+        sorted = sorted && state->getTransition(i - 1)->getNextStateID() <= state->getTransition(i)->getNextStateID();
+
+    REPORT_TEST_RESULT(sorted, "Transitions should be sorted by next state ID");
+    REPORT_TEST_RESULT(state->getTransitionToState(10)->getId() == 1 && state->getTransitionToState(30)->getId() == 2 && state->getTransitionToState(40) == nullptr, "Transitions should be found by next state ID");
+
+    mdp.seal();
+    const rlib::MdpModel& model = mdp.getModel();
+    uint32_t transition = model.findTransition(0, 2);
+    REPORT_TEST_RESULT(transition != rlib::MdpModel::kInvalidIndex && ARE_REALS_EQUAL(model.getCost(transition), 1.0), "Compiled model should find the transition to state index 2");
+}
+
+void mdpSamplingTest()
+{
+    printf("------MDP sampling test------\n");
+
+    const real_t probs[4] = { 0.1, 0.2, 0.3, 0.4 };
+    const rlib::MdpSamplingMode modes[3] = { rlib::MdpSamplingMode::kSamplingLinear, rlib::MdpSamplingMode::kSamplingCumulative, rlib::MdpSamplingMode::kSamplingAlias };
+    const char* modeNames[3] = { "linear", "cumulative", "alias" };
+
+    for (int m = 0; m < 3; ++m)
+    {
+        rlib::MdpModel model;
+        model.setSamplingMode(modes[m]);
+        model.addState();
+        for (uint32_t i = 0; i < 4; ++i)
+            model.addTransition(i, probs[i], 0.0);
+        for (uint32_t i = 1; i < 4; ++i)
+            model.addState();
+        model.compile();
+
+        // A uniform grid of draws must reproduce the transition probabilities
+        const int numDraws = 100000;
+        int counts[4] = { 0, 0, 0, 0 };
+        for (int i = 0; i < numDraws; ++i)
+            counts[model.sampleTransition(0, (i + 0.5) / numDraws)]++;
+
+        bool matches = true;
+        for (int i = 0; i < 4; ++i)
+            matches = matches && std::fabs(counts[i] / (real_t)numDraws - probs[i]) < 1e-3;
+
+        REPORT_TEST_RESULT(matches, "%s sampling should follow the transition probabilities", modeNames[m]);
+
+        if (modes[m] == rlib::MdpSamplingMode::kSamplingAlias)
+        {
+            bool agrees = true;
+            for (int i = 0; agrees && i < numDraws; ++i)
+                agrees = model.sampleTransitionAliasBranchless(0, (i + 0.5) / numDraws) == model.sampleTransitionAlias(0, (i + 0.5) / numDraws);
+
+            REPORT_TEST_RESULT(agrees, "Branchless alias sampling should select the same transitions");
+        }
+    }
+}
+
+void mdpValidationTest()
+{
+    printf("------MDP validation test------\n");
+
+    rlib::MDP mdp(3);
+    mdp.getStateAt(0)->addTransition(new rlib::MDP::StateTransition(0, 1, 0.5, 1.0));
+    mdp.getStateAt(1)->addTransition(new rlib::MDP::StateTransition(1, 2, 1.0, 1.0));
+    mdp.getStateAt(2)->addTransition(new rlib::MDP::StateTransition(2, 0, 0.7, 1.0));
+    mdp.getStateAt(2)->addTransition(new rlib::MDP::StateTransition(3, 1, 0.7, 1.0));
+
+    bool panicked = false;
+    rlib::setPanicMode(rlib::PanicMode::kPanicModeThrowException);
+
+    try
+    {
+        mdp.seal();
+    }
+    catch (const std::exception& e)
+    {
+        panicked = std::string(e.what()).find("2 state(s)") != std::string::npos;
+    }
+
+    rlib::setPanicMode(rlib::PanicMode::kPanicModeAbort);
+
+    REPORT_TEST_RESULT(panicked && !mdp.isSealed(), "Sealing should report both invalid states at once");
+
+    rlib::MdpModel model;
+    model.addState();
+    model.addTransition(1, 0.5, 1.0);
+    model.addState();
+    model.addTransition(0, 1.0, 1.0);
+    model.addState();
+    model.addTransition(0, 1.2, 1.0);
+    model.addTransition(1, -0.2, 1.0);
+
+    std::vector<uint32_t> invalidStates;
+    REPORT_TEST_RESULT(!model.validate(&invalidStates) && invalidStates.size() == 2 && invalidStates[0] == 0 && invalidStates[1] == 2, "Model validation should list states 0 and 2");
+}
+
+void mdpGeneratorPolicyTest()
+{
+    printf("------MDP generator policy test------\n");
+
+    rlib::MDP mdp(4);
+    buildTestMdp(mdp);
+
+    // The same xoshiro256++ stream, inlined as a bare engine and through the virtual interface
+    rlib::Xoshiro256PlusPlus engine(3);
+    rlib::XoshiroRng virtualRng(3);
+    rlib::RngBase& rngBase = virtualRng;
+
+    real_t inlinedCost = 0.0;
+    real_t virtualCost = 0.0;
+
+    for (int n = 0; n < 1000; ++n)
+    {
+        mdp.reset();
+        while (!mdp.isTerminal())
+            mdp.update(engine);
+        inlinedCost += mdp.getTotalCost();
+
+        mdp.reset();
+        while (!mdp.isTerminal())
+            mdp.update(rngBase);
+        virtualCost += mdp.getTotalCost();
+    }
+
+    REPORT_TEST_RESULT(inlinedCost == virtualCost && std::fabs(inlinedCost / 1000 - 285.0) < 10.0, "Inlined and virtual generators should produce the same trajectories");
+
+    rlib::SeededRng seededRng(5);
+    rlib::Pcg64 pcg(5);
+    mdp.getStateAt(1)->update(seededRng);
+    bool legacyMoved = mdp.getCurrentStateIndex() == 2 || mdp.getCurrentStateIndex() == 3;
+    mdp.getStateAt(1)->update(pcg);
+    legacyMoved = legacyMoved && (mdp.getCurrentStateIndex() == 2 || mdp.getCurrentStateIndex() == 3);
+
+    REPORT_TEST_RESULT(legacyMoved, "State::update should accept any generator");
+}
+
+void mdpRunnerTest()
+{
+    printf("------MDP runner test------\n");
+
+    rlib::MDP mdp(4);
+    buildTestMdp(mdp);
+
+    std::shared_ptr<const rlib::MdpModel> model = mdp.getSharedModel();
+
+    // Several runners step concurrently against the same model, each with its own generator
+    const int numThreads = 4;
+    const int numTrajectories = 1000;
+    std::vector<std::thread> threads;
+    std::vector<int> numValidTrajectories(numThreads, 0);
+
+    for (int i = 0; i < numThreads; ++i)
+    {
+        threads.push_back(std::thread([&model, &numValidTrajectories, i]()
+        {
+            rlib::SeededRng rng(1234 + i);
+            rlib::MdpRunner runner(model, &rng);
+
+            for (int n = 0; n < numTrajectories; ++n)
+            {
+                runner.reset();
+                while (!runner.isTerminal() && runner.getNumSteps() < 10)
+                    runner.update();
+
+                real_t cost = runner.getTotalCost();
+                if (runner.isTerminal() && (ARE_REALS_EQUAL(cost, 250.0) || ARE_REALS_EQUAL(cost, 300.0)))
+                    numValidTrajectories[i]++;
+            }
+        }));
+    }
+
+    for (size_t i = 0; i < threads.size(); ++i)
+        threads[i].join();
+
+    bool allValid = true;
+    for (int i = 0; i < numThreads; ++i)
+        allValid = allValid && numValidTrajectories[i] == numTrajectories;
+
+    REPORT_TEST_RESULT(allValid, "Concurrent runners should all reach the terminal state with a valid cost");
+
+    // Resealing the MDP builds a new model and leaves the shared one untouched
+    mdp.setSamplingMode(rlib::MdpSamplingMode::kSamplingAlias);
+    mdp.seal();
+    REPORT_TEST_RESULT(&mdp.getModel() != model.get() && model->getSamplingMode() == rlib::MdpSamplingMode::kSamplingLinear, "Shared model should be immutable after resealing");
+}
+
+void mdpBatchRunnerTest()
+{
+    printf("------MDP batch runner test------\n");
+
+    rlib::MDP mdp(4);
+    buildTestMdp(mdp);
+    mdp.setSamplingMode(rlib::MdpSamplingMode::kSamplingAlias);
+    mdp.seal();
+
+    const size_t numChains = 10000;
+    rlib::MdpBatchRunner batch(mdp.getSharedModel(), numChains, 7);
+    uint32_t numSteps = batch.run(100);
+
+    real_t meanCost = 0.0;
+    bool allValid = batch.getNumActiveChains() == 0;
+    for (size_t i = 0; i < numChains; ++i)
+    {
+        real_t cost = batch.getTotalCosts()[i];
+        uint32_t steps = batch.getNumSteps()[i];
+        allValid = allValid && batch.getStates()[i] == 3 && ((steps == 2 && ARE_REALS_EQUAL(cost, 250.0)) || (steps == 3 && ARE_REALS_EQUAL(cost, 300.0)));
+        meanCost += cost / numChains;
+    }
+
+    REPORT_TEST_RESULT(allValid && numSteps == 3, "All the chains should reach the terminal state with a valid cost");
+    REPORT_TEST_RESULT(std::fabs(meanCost - 285.0) < 2.0, "Mean cost of the chains should be close to 285 (got %.3f)", meanCost);
+
+    std::vector<real_t> costs = batch.getTotalCosts();
+    batch.reset();
+    REPORT_TEST_RESULT(batch.getNumActiveChains() == numChains && batch.getTotalCosts()[0] == 0.0 && batch.getStates()[0] == 0, "Reset should move every chain back to the initial state");
+
+    // The trajectory of a chain only depends on the seed and on its index
+    batch.run(100);
+    rlib::MdpBatchRunner smallBatch(mdp.getSharedModel(), 100, 7);
+    smallBatch.run(100);
+
+    REPORT_TEST_RESULT(batch.getTotalCosts() == costs && std::equal(smallBatch.getTotalCosts().begin(), smallBatch.getTotalCosts().end(), costs.begin()), "Chains should not depend on the number of chains or on resets");
+}
+
+void mdpRolloutTest()
+{
+    printf("------MDP rollout test------\n");
+
+    rlib::MDP mdp(4);
+    buildTestMdp(mdp);
+
+    rlib::MdpRolloutEngine engine(mdp.getSharedModel());
+    rlib::MdpRolloutOptions options;
+    options.numTrajectories = 100000;
+    options.seed = 42;
+
+    options.numThreads = 1;
+    rlib::MdpRolloutResult singleThreaded = engine.run(options);
+    options.numThreads = 4;
+    rlib::MdpRolloutResult multiThreaded = engine.run(options);
+
+    // Exact expected values: cost 0.7 * 300 + 0.3 * 250 = 285, length 0.7 * 3 + 0.3 * 2 = 2.7
+    REPORT_TEST_RESULT(multiThreaded.numTrajectories == 100000 && multiThreaded.numTruncated == 0, "All the trajectories should terminate");
+    REPORT_TEST_RESULT(std::fabs(multiThreaded.meanCost - 285.0) < 1.0, "Mean cost should be close to 285 (got %.3f)", multiThreaded.meanCost);
+    REPORT_TEST_RESULT(std::fabs(multiThreaded.meanLength - 2.7) < 0.01 && multiThreaded.minLength == 2 && multiThreaded.maxLength == 3, "Trajectory lengths should be 2 or 3 with mean 2.7 (got %.3f)", multiThreaded.meanLength);
+    REPORT_TEST_RESULT(singleThreaded.meanCost == multiThreaded.meanCost && singleThreaded.stddevCost == multiThreaded.stddevCost, "Results should not depend on the number of threads");
+
+    // Any trajectory can be reproduced on its own, and the chains of a batch runner with the same seed follow the same trajectories
+    rlib::MdpTrajectory trajectory = engine.replay(options, 12345, true);
+    rlib::MdpTrajectory again = engine.replay(options, 12345);
+    rlib::MdpBatchRunner batch(mdp.getSharedModel(), 12346, 42);
+    batch.run(100);
+
+    REPORT_TEST_RESULT(trajectory.states.size() == trajectory.numSteps + 1 && trajectory.states.back() == 3 && trajectory.totalCost == again.totalCost && trajectory.numSteps == again.numSteps,
+        "Replaying a trajectory should be reproducible");
+    REPORT_TEST_RESULT(batch.getTotalCosts()[12345] == trajectory.totalCost && batch.getNumSteps()[12345] == trajectory.numSteps, "Batch chains should follow the rollout trajectories");
+
+    // The whole 64 bit seed keys the generator, like the rollout seed
+    rlib::MdpBatchRunner wideSeedBatch(mdp.getSharedModel(), 12346, (1ULL << 32) + 42);
+    wideSeedBatch.run(100);
+    options.seed = (1ULL << 32) + 42;
+    trajectory = engine.replay(options, 12345);
+
+    REPORT_TEST_RESULT(wideSeedBatch.getTotalCosts() != batch.getTotalCosts() && wideSeedBatch.getTotalCosts()[12345] == trajectory.totalCost, "Batch runner seeds should not be truncated to 32 bits");
+}
+
+void mdpVarianceReductionTest()
+{
+    printf("------MDP variance reduction test------\n");
+
+    rlib::MDP mdp(4);
+    buildTestMdp(mdp);
+
+    rlib::MdpRolloutEngine engine(mdp.getSharedModel());
+    rlib::MdpRolloutOptions options;
+    options.numTrajectories = 1 << 16;
+    options.seed = 42;
+    options.numThreads = 2;
+
+    rlib::MdpRolloutResult plain = engine.run(options);
+    options.varianceReduction = rlib::MdpVarianceReduction::kAntithetic;
+    rlib::MdpRolloutResult antithetic = engine.run(options);
+    options.varianceReduction = rlib::MdpVarianceReduction::kQuasiRandom;
+    rlib::MdpRolloutResult quasiRandom = engine.run(options);
+
+    // The cost is 300 if the second uniform is below 0.7, 250 otherwise: antithetic pairs have variance 150 instead of 2 * 525 / 4
+    REPORT_TEST_RESULT(plain.varianceReductionFactor == 1.0 && std::fabs(plain.stderrCost - std::sqrt(525.0 / options.numTrajectories)) < 0.01, "Plain Monte Carlo should report its standard error");
+    REPORT_TEST_RESULT(std::fabs(antithetic.meanCost - 285.0) < 4.0 * antithetic.stderrCost && std::fabs(antithetic.varianceReductionFactor - 1.75) < 0.1,
+        "Antithetic variates should be unbiased with a variance reduction factor close to 1.75 (got %.3f)", antithetic.varianceReductionFactor);
+    REPORT_TEST_RESULT(std::fabs(quasiRandom.meanCost - 285.0) < 0.1 && quasiRandom.varianceReductionFactor > 100.0,
+        "Quasi random uniforms should reduce the variance by orders of magnitude (got %.1f)", quasiRandom.varianceReductionFactor);
+
+    rlib::MdpRolloutOptions oddOptions = options;
+    oddOptions.numTrajectories = 1;
+    oddOptions.varianceReduction = rlib::MdpVarianceReduction::kAntithetic;
+    rlib::MdpRolloutResult single = engine.run(oddOptions);
+    oddOptions.numTrajectories = 2;
+    rlib::MdpRolloutResult pair = engine.run(oddOptions);
+    REPORT_TEST_RESULT(single.numTrajectories == 2 && single.meanCost == pair.meanCost, "Antithetic runs should round an odd number of trajectories up to whole pairs");
+
+    rlib::MdpTrajectory trajectory = engine.replay(options, 1234);
+    rlib::MdpTrajectory again = engine.replay(options, 1234);
+    REPORT_TEST_RESULT(trajectory.totalCost == again.totalCost && trajectory.numSteps == again.numSteps, "Quasi random trajectories should be replayable");
+
+    // The same chain with a cheaper branch: common random numbers only leave the cost of the branch as noise
+    rlib::MDP cheaper(4);
+    cheaper.getStateAt(0)->addTransition(new rlib::MDP::StateTransition(0, 1, 1.0, 100.0));
+    cheaper.getStateAt(1)->addTransition(new rlib::MDP::StateTransition(1, 2, 0.7, 100.0));
+    cheaper.getStateAt(1)->addTransition(new rlib::MDP::StateTransition(2, 3, 0.3, 150.0));
+    cheaper.getStateAt(2)->addTransition(new rlib::MDP::StateTransition(3, 3, 1.0, 90.0));
+    cheaper.getStateAt(3)->addTransition(new rlib::MDP::StateTransition(4, 3, 1.0, 0.0));
+    rlib::MdpRolloutEngine cheaperEngine(cheaper.getSharedModel());
+
+    options.varianceReduction = rlib::MdpVarianceReduction::kNone;
+    rlib::MdpRolloutComparison comparison = engine.compare(cheaperEngine, options);
+
+    REPORT_TEST_RESULT(std::fabs(comparison.meanDifference - 7.0) < 4.0 * comparison.stderrDifference && comparison.varianceReductionFactor > 10.0,
+        "Common random numbers should estimate the difference of 7 with a large variance reduction (got %.3f, factor %.1f)", comparison.meanDifference, comparison.varianceReductionFactor);
+    REPORT_TEST_RESULT(comparison.first.meanCost == plain.meanCost, "Compared models should follow the plain rollout streams");
+}
+
+void mdpSolverTest()
+{
+    printf("------MDP solver test------\n");
+
+    rlib::MDP mdp(4);
+    buildTestMdp(mdp);
+
+    rlib::MdpCostSolver solver(mdp.getSharedModel());
+    rlib::MdpSolverResult result = solver.solve();
+
+    const real_t expected[4] = { 285.0, 185.0, 100.0, 0.0 };
+    bool matches = result.converged && result.values.size() == 4;
+    for (size_t i = 0; matches && i < 4; ++i)
+        matches = std::fabs(result.values[i] - expected[i]) < 1e-6;
+
+    REPORT_TEST_RESULT(matches, "Expected costs to absorption should be 285, 185, 100, 0");
+
+    rlib::MdpSolverOptions options;
+    options.relaxation = 1.2;
+    result = solver.solve(options);
+    REPORT_TEST_RESULT(result.converged && std::fabs(result.values[0] - 285.0) < 1e-6, "SOR should converge to the same values");
+}
+
+void mdpFileTest()
+{
+    printf("------MDP file test------\n");
+
+    rlib::MDP mdp(4);
+    buildTestMdp(mdp);
+    mdp.setSamplingMode(rlib::MdpSamplingMode::kSamplingAlias);
+    mdp.seal();
+
+    const rlib::MdpModel& model = mdp.getModel();
+    REPORT_TEST_RESULT(model.saveToFile("testModel.mdp"), "Compiled model should be saved");
+
+    std::shared_ptr<rlib::MdpModel> mapped = rlib::MdpModel::mapFromFile("testModel.mdp");
+    bool matches = mapped != nullptr && mapped->isMapped() && mapped->isValidated() && mapped->getSamplingMode() == rlib::MdpSamplingMode::kSamplingAlias
+        && mapped->getNumStates() == model.getNumStates() && mapped->getNumTransitions() == model.getNumTransitions();
+
+    for (uint32_t s = 0; matches && s < model.getNumStates(); ++s)
+    {
+        matches = mapped->getRowBegin(s) == model.getRowBegin(s) && mapped->getRowEnd(s) == model.getRowEnd(s) && mapped->isTerminal(s) == model.isTerminal(s);
+
+        for (uint32_t t = model.getRowBegin(s); matches && t < model.getRowEnd(s); ++t)
+        {
+            matches = mapped->getNextState(t) == model.getNextState(t) && mapped->getProbability(t) == model.getProbability(t)
+                && mapped->getCost(t) == model.getCost(t) && mapped->sampleTransition(s, 0.35) == model.sampleTransition(s, 0.35);
+        }
+    }
+
+    REPORT_TEST_RESULT(matches, "Mapped model should match the saved one");
+
+    if (mapped != nullptr)
+    {
+        rlib::MdpCostSolver solver(mapped);
+        rlib::MdpSolverResult result = solver.solve();
+        REPORT_TEST_RESULT(result.converged && std::fabs(result.values[0] - 285.0) < 1e-6, "Mapped model should be usable by the solver");
+    }
+
+    // A next state out of range must be rejected instead of being followed by the runners, the section offsets follow the
+    // magic, four 32 bit fields and the two counts
+    {
+        std::ifstream in("testModel.mdp", std::ios::binary);
+        std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+        uint64_t nextStatesOffset;
+        memcpy(&nextStatesOffset, contents.data() + 8 + 4 * sizeof(uint32_t) + 2 * sizeof(uint64_t) + sizeof(uint64_t), sizeof(nextStatesOffset));
+
+        const uint32_t invalidState = static_cast<uint32_t>(model.getNumStates());
+        memcpy(&contents[nextStatesOffset], &invalidState, sizeof(invalidState));
+
+        std::ofstream out("testModelCorrupted.mdp", std::ios::binary | std::ios::trunc);
+        out.write(contents.data(), contents.size());
+    }
+
+    REPORT_TEST_RESULT(rlib::MdpModel::mapFromFile("testModelCorrupted.mdp") == nullptr, "Model file with an invalid next state should be rejected");
+    std::remove("testModelCorrupted.mdp");
+
+    // A truncated file must be rejected instead of being read out of bounds
+    {
+        std::ifstream in("testModel.mdp", std::ios::binary);
+        std::string contents((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        std::ofstream out("testModel.mdp", std::ios::binary | std::ios::trunc);
+        out.write(contents.data(), contents.size() - 8);
+    }
+
+    REPORT_TEST_RESULT(rlib::MdpModel::mapFromFile("testModel.mdp") == nullptr, "Truncated model file should be rejected");
+
+    std::remove("testModel.mdp");
+}
+
+void mdpBuilderTest()
+{
+    printf("------MDP builder test------\n");
+
+    rlib::MdpModelBuilder builder("A");
+    std::shared_ptr<rlib::MdpModel> model = builder.buildFromFile("parameters.txt");
+
+    bool matches = model != nullptr && model->isCompiled() && model->getNumStates() == 4 && model->getNumTransitions() == 5
+        && model->getRowEnd(1) - model->getRowBegin(1) == 2 && !model->isTerminal(2) && model->isTerminal(3);
+
+    REPORT_TEST_RESULT(matches, "Model built from parameters.txt should have 4 states and 5 transitions");
+
+    if (model != nullptr)
+    {
+        rlib::MdpCostSolver solver(model);
+        rlib::MdpSolverResult result = solver.solve();
+        REPORT_TEST_RESULT(std::fabs(result.values[0] - 285.0) < 1e-6 && std::fabs(result.values[1] - 185.0) < 1e-6, "Expected costs of the built model should be 285 and 185");
+    }
+
+    std::istringstream stream("N 2\nA 0 1 0.25 4\r\nA 0 0 0.75 2\n\nA 1 1 1 0\n");
+    model = builder.buildFromStream(stream);
+    REPORT_TEST_RESULT(model != nullptr && model->getNumTransitions() == 3 && model->getNextState(model->getRowBegin(0)) == 0, "Model should be built from a stream");
+
+    std::istringstream actionStream("A 0 1 1 1 1\n");
+    std::istringstream invalidStream("A 0 1 0.5x 1\n");
+    REPORT_TEST_RESULT(builder.buildFromStream(actionStream) == nullptr && builder.buildFromStream(invalidStream) == nullptr, "Malformed transition definitions should be rejected");
+
+    std::istringstream sparseStream("A 0 2000000000 1 0\nA 2000000000 2000000000 1 0\n");
+    REPORT_TEST_RESULT(builder.buildFromStream(sparseStream) == nullptr, "State IDs far above the number of transitions should be rejected");
+
+    // A dense chain listed from its highest state down, whose first line is far above the number of lines read so far
+    const uint32_t chainLength = rlib::MdpModelBuilder::kMaxStateIDGap + 1000;
+    std::string chain;
+    for (uint32_t s = chainLength; s > 0; --s)
+        chain += "A " + std::to_string(s - 1) + " " + std::to_string(s) + " 1 1\n";
+    std::istringstream chainStream(chain);
+    model = builder.buildFromStream(chainStream);
+
+    REPORT_TEST_RESULT(model != nullptr && model->getNumStates() == chainLength + 1 && model->isTerminal(chainLength), "Dense state IDs should be accepted whatever the order of the lines");
+}
+
+void actionMdpTest()
+{
+    printf("------Action MDP test------\n");
+
+    rlib::ParameterManager paramManager;
+    paramManager.registerParameterType("N", rlib::ParameterType::kParamInt);
+    paramManager.registerParameterType("A", rlib::ParameterType::kParamMdpStateTransitionDef);
+    paramManager.loadFromFile("actionParameters.txt");
+
+    std::shared_ptr<rlib::ActionMdpModel> model = rlib::ActionMdpModel::fromParameters(paramManager);
+
+    REPORT_TEST_RESULT(model->getNumStates() == 4 && model->getNumActions() == 6 && model->getNumTransitions() == 7, "Action MDP should have 4 states, 6 actions and 7 transitions");
+
+    rlib::ActionMdpSolver solver(model);
+    rlib::ActionMdpSolverOptions options;
+    options.numThreads = 3;
+
+    // Optimal costs: v(3) = 0, v(1) = 1, v(2) = min(20, 0.5 * (1 + 1) + 0.5 * 30) = 16, v(0) = min(10 + 1, 1 + 16) = 11
+    const real_t expectedValues[4] = { 11.0, 1.0, 16.0, 0.0 };
+    const uint32_t expectedActionIDs[3] = { 0, 0, 1 };
+
+    rlib::ActionMdpSolution solutions[2] = { solver.valueIteration(options), solver.policyIteration(options) };
+    const char* names[2] = { "Value iteration", "Policy iteration" };
+
+    for (int i = 0; i < 2; ++i)
+    {
+        bool matches = solutions[i].converged;
+        for (uint32_t s = 0; matches && s < 4; ++s)
+            matches = std::fabs(solutions[i].values[s] - expectedValues[s]) < 1e-6;
+        for (uint32_t s = 0; matches && s < 3; ++s)
+            matches = model->getActionID(solutions[i].policy[s]) == expectedActionIDs[s];
+
+        REPORT_TEST_RESULT(matches, "%s should find the optimal values and policy", names[i]);
+    }
+
+    // Fewer items than threads still run in parallel, one item per thread
+    rlib::ThreadPool pool(4);
+    unsigned itemThreads[2] = { 99, 99 };
+    pool.parallelFor(2, [&itemThreads](size_t begin, size_t end, unsigned threadIndex)
+    {
+        for (size_t i = begin; i < end; ++i)
+            itemThreads[i] = threadIndex;
+    });
+
+    REPORT_TEST_RESULT(itemThreads[0] == 0 && itemThreads[1] == 1, "A parallel loop shorter than the pool should give every item its own thread");
+}
+
+void rngTest()
+{
+    printf("------RNG test------\n");
+
+    rlib::Xoshiro256PlusPlus a(42);
+    rlib::Xoshiro256PlusPlus b(42);
+    rlib::Xoshiro256PlusPlus jumped(42);
+    jumped.jump();
+
+    bool reproducible = true;
+    bool differs = false;
+    for (int i = 0; i < 1000; ++i)
+    {
+        uint64_t x = a();
+        reproducible = reproducible && x == b();
+        differs = differs || x != jumped();
+    }
+
+    REPORT_TEST_RESULT(reproducible && differs, "xoshiro256++ should be reproducible and jumped streams should differ");
+
+    rlib::Pcg64 stepped(7, 3);
+    rlib::Pcg64 advanced(7, 3);
+    for (int i = 0; i < 12345; ++i)
+        stepped();
+    advanced.advance(12345);
+
+    rlib::Pcg64 otherStream(7, 4);
+    REPORT_TEST_RESULT(stepped() == advanced() && rlib::Pcg64(7, 3)() != otherStream(), "PCG64 advance() should match stepping and streams should differ");
+
+    rlib::XoshiroRng xoshiroRng(1);
+    rlib::Pcg64Rng pcgRng(1);
+    real_t xoshiroMean = 0.0;
+    real_t pcgMean = 0.0;
+    const int numDraws = 1000000;
+
+    for (int i = 0; i < numDraws; ++i)
+    {
+        xoshiroMean += xoshiroRng.getRandomReal() / numDraws;
+        pcgMean += pcgRng.getRandomReal() / numDraws;
+    }
+
+    REPORT_TEST_RESULT(std::fabs(xoshiroMean - 0.5) < 1e-3 && std::fabs(pcgMean - 0.5) < 1e-3, "Uniform draws should have mean 0.5 (got %.5f and %.5f)", xoshiroMean, pcgMean);
+
+    // Bulk fills return the same values as one call per value
+    rlib::XoshiroRng single(9);
+    rlib::XoshiroRng bulk(9);
+    std::vector<real_t> values(1000);
+    bulk.fillUniform(values.data(), values.size(), 2.0, 3.0);
+
+    bool sameValues = true;
+    for (size_t i = 0; i < values.size(); ++i)
+        sameValues = sameValues && values[i] == single.getRandomReal(2.0, 3.0);
+
+    REPORT_TEST_RESULT(sameValues, "Bulk uniform fill should match individual draws");
+
+    std::vector<real_t> exponentials(numDraws);
+    pcgRng.fillExponential(exponentials.data(), exponentials.size(), 4.0);
+    real_t exponentialMean = 0.0;
+    for (size_t i = 0; i < exponentials.size(); ++i)
+        exponentialMean += exponentials[i] / numDraws;
+
+    std::vector<int> ints(10000);
+    rlib::SeededRng seededRng(3);
+    seededRng.fillInt(ints.data(), ints.size(), -2, 2);
+    bool inRange = true;
+    for (size_t i = 0; i < ints.size(); ++i)
+        inRange = inRange && ints[i] >= -2 && ints[i] <= 2;
+
+    REPORT_TEST_RESULT(std::fabs(exponentialMean - 0.25) < 1e-3 && inRange, "Bulk exponential and integer fills should follow their distributions (mean %.5f)", exponentialMean);
+
+    // Every thread gets its own stream, and reseeding makes the draws of a thread reproducible
+    rlib::setGlobalSeed(5);
+    real_t first = rlib::getThreadRng().getRandomReal();
+    real_t otherThread = 0.0;
+    std::thread thread([&otherThread]() { otherThread = rlib::getThreadRng().getRandomReal(); });
+    thread.join();
+    rlib::setGlobalSeed(5);
+
+    REPORT_TEST_RESULT(rlib::getThreadRng().getRandomReal() == first && otherThread != first, "Thread generators should be reproducible and independent");
+
+    // An explicit stream gives the same draws whatever the thread and the order the threads started in
+    real_t streamDraws[3] = { 0.0, 0.0, 0.0 };
+    std::thread firstStream([&streamDraws]() { rlib::getThreadRng(); rlib::setThreadStream(7); streamDraws[0] = rlib::getThreadRng().getRandomReal(); });
+    firstStream.join();
+    std::thread secondStream([&streamDraws]() { rlib::setThreadStream(7); streamDraws[1] = rlib::getThreadRng().getRandomReal(); });
+    std::thread thirdStream([&streamDraws]() { rlib::setThreadStream(8); streamDraws[2] = rlib::getThreadRng().getRandomReal(); });
+    secondStream.join();
+    thirdStream.join();
+
+    REPORT_TEST_RESULT(streamDraws[0] == streamDraws[1] && streamDraws[0] != streamDraws[2], "Threads sharing an explicit stream should draw the same numbers");
+
+    // Known answers of the Philox4x32-10 reference implementation
+    const uint32_t philoxKeys[3][2] = { { 0, 0 }, { 0xffffffff, 0xffffffff }, { 0xa4093822, 0x299f31d0 } };
+    uint32_t philoxCounters[3][4] = { { 0, 0, 0, 0 }, { 0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff }, { 0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344 } };
+    const uint32_t philoxExpected[3][4] = { { 0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8 }, { 0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd }, { 0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1 } };
+
+    bool knownAnswers = true;
+    for (int i = 0; i < 3; ++i)
+    {
+        rlib::Philox4x32::applyRounds(philoxCounters[i], philoxKeys[i]);
+        knownAnswers = knownAnswers && std::equal(philoxCounters[i], philoxCounters[i] + 4, philoxExpected[i]);
+    }
+
+    REPORT_TEST_RESULT(knownAnswers, "Philox rounds should match the reference known answers");
+
+    // Any position of any stream can be reached directly
+    rlib::Philox4x32 philox(11, 3);
+    std::vector<uint64_t> sequence(101);
+    for (size_t i = 0; i < sequence.size(); ++i)
+        sequence[i] = philox();
+
+    philox.setPosition(77);
+    uint64_t philoxJumped = philox();
+    philox.setStream(4);
+
+    REPORT_TEST_RESULT(philoxJumped == sequence[77] && rlib::Philox4x32::valueAt(11, 3, 100) == sequence[100] && rlib::Philox4x32::valueAt(11, 3, 0) == sequence[0] && philox() != sequence[0],
+        "Philox random access should match the sequential output and streams should differ");
+
+    // The first 2^m points of every dimension fall in distinct intervals of width 2^-m, with or without scrambling
+    rlib::SobolSequence sobol(rlib::SobolSequence::kMaxDimensions);
+    rlib::SobolSequence scrambledSobol(rlib::SobolSequence::kMaxDimensions);
+    scrambledSobol.scramble(17);
+
+    const uint32_t numPoints = 1024;
+    bool stratified = true;
+    for (uint32_t d = 0; d < rlib::SobolSequence::kMaxDimensions; ++d)
+    {
+        std::vector<bool> plainCells(numPoints, false);
+        std::vector<bool> scrambledCells(numPoints, false);
+
+        for (uint32_t i = 0; i < numPoints; ++i)
+        {
+            plainCells[static_cast<size_t>(sobol.getValue(i, d) * numPoints)] = true;
+            scrambledCells[static_cast<size_t>(scrambledSobol.getValue(i, d) * numPoints)] = true;
+        }
+
+        stratified = stratified && std::count(plainCells.begin(), plainCells.end(), true) == numPoints && std::count(scrambledCells.begin(), scrambledCells.end(), true) == numPoints;
+    }
+
+    REPORT_TEST_RESULT(stratified && sobol.getValue(1, 3) == 0.5 && scrambledSobol.getValue(1, 3) != 0.5, "Sobol points should be stratified in every dimension");
 }
 
 void parameterTest()
@@ -78,6 +802,52 @@ void parameterTest()
     REPORT_TEST_RESULT(boolParam.getValue() == true, "BoolParameter value should be true");
 }
 
+void textParseTest()
+{
+    printf("------Text parse test------\n");
+
+    // The fast path must give the correctly rounded value, as strtod does
+    std::mt19937_64 engine(13);
+    bool sameValues = true;
+    char buffer[64];
+    for (int i = 0; i < 100000 && sameValues; ++i)
+    {
+        const double value = std::ldexp(static_cast<double>(engine() >> 11), static_cast<int>(engine() % 80) - 90);
+        const int length = snprintf(buffer, sizeof(buffer), i % 2 == 0 ? "%.17g" : "%.6f", i % 3 == 0 ? -value : value);
+
+        double parsed = 0.0;
+        sameValues = rlib::parseDouble(buffer, buffer + length, parsed) && parsed == strtod(buffer, nullptr);
+    }
+
+    REPORT_TEST_RESULT(sameValues, "parseDouble should match strtod");
+
+    const char* text = "-2147483648 2147483648 12abc 4294967295 1e400 0x1p-2 TRUE";
+    const char* p = text;
+    const char* tokenBegin[7];
+    const char* tokenEnd[7];
+    for (int i = 0; i < 7; ++i)
+        rlib::nextToken(p, text + strlen(text), tokenBegin[i], tokenEnd[i]);
+
+    int intValue = 0;
+    uint32_t uintValue = 0;
+    double doubleValue = 0.0;
+    bool boolValue = false;
+
+    REPORT_TEST_RESULT(rlib::parseInt(tokenBegin[0], tokenEnd[0], intValue) && intValue == INT_MIN && !rlib::parseInt(tokenBegin[1], tokenEnd[1], intValue)
+        && !rlib::parseInt(tokenBegin[2], tokenEnd[2], intValue) && rlib::parseUInt(tokenBegin[3], tokenEnd[3], uintValue) && uintValue == UINT32_MAX,
+        "Integers should be parsed up to their limits, partial tokens should be rejected");
+    REPORT_TEST_RESULT(!rlib::parseDouble(tokenBegin[4], tokenEnd[4], doubleValue) && rlib::parseDouble(tokenBegin[5], tokenEnd[5], doubleValue) && doubleValue == 0.25
+        && rlib::parseBool(tokenBegin[6], tokenEnd[6], boolValue) && boolValue, "Out of range reals should be rejected, other forms should be accepted");
+
+    // The parameters report malformed values instead of throwing
+    rlib::IntParameter intParam("TestInt");
+    rlib::DoubleArrayParameter arrayParam("TestArray");
+    rlib::MdpStateTransitionDefParameter transitionParam("TestTransition");
+
+    REPORT_TEST_RESULT(!intParam.fromString("99999999999") && !arrayParam.fromString("1.5 x") && arrayParam.fromString(" 1.5  2 ") && arrayParam.getNumValues() == 2
+        && !transitionParam.fromString("1 2 abc 4") && transitionParam.fromString("1 2 0.5 4") && transitionParam.getProbability() == 0.5, "Malformed values should be rejected without exceptions");
+}
+
 void parameterLoadTest()
 {
     printf("------Parameter load test------\n");
@@ -104,6 +874,448 @@ void parameterLoadTest()
     {
         LOG_ERROR("Failed to load parameters: %s\n", e.what());
     }
+
+    // An empty file is a valid file without parameters
+    {
+        std::ofstream file("emptyParameters.txt");
+    }
+
+    rlib::ParameterManager emptyManager;
+    rlib::ParameterManager lazyEmptyManager;
+    rlib::LiveParameterManager liveEmpty("emptyParameters.txt", [](rlib::ParameterManager&) {});
+
+    REPORT_TEST_RESULT(emptyManager.loadFromFile("emptyParameters.txt") && emptyManager.getNumParameters() == 0 && lazyEmptyManager.loadFromFileLazy("emptyParameters.txt")
+        && lazyEmptyManager.getNumParameters() == 0 && liveEmpty.reload() && liveEmpty.getVersion() == 1, "An empty parameter file should load without parameters");
+
+    std::remove("emptyParameters.txt");
+}
+
+void parameterIndexTest()
+{
+    printf("------Parameter index test------\n");
+
+    rlib::ParameterManager paramManager;
+    paramManager.registerParameterType("N", rlib::ParameterType::kParamInt);
+    paramManager.registerParameterType("A", rlib::ParameterType::kParamMdpStateTransitionDef);
+
+    paramManager.registerParameter("N", "4");
+    for (int i = 0; i < 3; ++i)
+        paramManager.registerParameter("A", std::to_string(i) + " " + std::to_string(i + 1) + " 1 10");
+    paramManager.registerParameter("int", "7");
+
+    REPORT_TEST_RESULT(paramManager.getParameter("A_3") == paramManager.getParameter(3) && paramManager.getParameter("A_4") == nullptr, "Parameters should be found by name");
+    REPORT_TEST_RESULT(paramManager.getFirstParameterOfTypeName("A") == paramManager.getParameter(1) && paramManager.getFirstParameterOfTypeName("B") == nullptr, "The first parameter of a type name should be found");
+    REPORT_TEST_RESULT(paramManager.getNumParametersOfTypeName("A") == 3 && paramManager.getNumParametersOfType(rlib::ParameterType::kParamInt) == 2, "Parameters should be counted by type name and by type");
+
+    paramManager.unregisterParameter(1);
+    REPORT_TEST_RESULT(paramManager.getParameter("A_1") == nullptr && paramManager.getParameter("A_2") == paramManager.getParameter(1) && paramManager.getFirstParameterOfTypeName("A") == paramManager.getParameter(1)
+        && paramManager.getNumParametersOfTypeName("A") == 2 && paramManager.getNumParametersOfType(rlib::ParameterType::kParamMdpStateTransitionDef) == 2, "Unregistering should update the indexes");
+}
+
+void parameterParallelLoadTest()
+{
+    printf("------Parameter parallel load test------\n");
+
+    // Mixed type names, a line without delimiter and a value failing to parse, so that the chunks have to agree on the names
+    {
+        std::ofstream file("parallelParameters.txt");
+        for (int i = 0; i < 2000; ++i)
+        {
+            file << "N " << i << "\n";
+            if (i % 3 == 0)
+                file << "A " << i << " " << i + 1 << " 1 " << i << "\r\n";
+            if (i % 7 == 0)
+                file << "D " << i * 0.5 << "\n\n";
+            if (i == 1000)
+                file << "invalid\nN abc\n";
+        }
+    }
+
+    rlib::ParameterManager managers[2];
+    const unsigned numThreads[2] = { 1, 4 };
+
+    for (int m = 0; m < 2; ++m)
+    {
+        managers[m].registerParameterType("N", rlib::ParameterType::kParamInt);
+        managers[m].registerParameterType("A", rlib::ParameterType::kParamMdpStateTransitionDef);
+        managers[m].registerParameterType("D", rlib::ParameterType::kParamDouble);
+        managers[m].registerParameter("D", "0.25");
+        managers[m].loadFromFile("parallelParameters.txt", numThreads[m]);
+    }
+
+    bool isSame = managers[0].getNumParameters() == managers[1].getNumParameters();
+    for (size_t i = 0; isSame && i < managers[0].getNumParameters(); ++i)
+    {
+        rlib::Parameter* param = managers[1].getParameter(i);
+        isSame = param->getName() == managers[0].getParameter(i)->getName() && param->getValueString() == managers[0].getParameter(i)->getValueString()
+            && managers[1].getParameter(param->getName()) == param;
+    }
+
+    REPORT_TEST_RESULT(isSame && managers[0].getNumParameters() == 1 + 2000 + 667 + 286, "Loading in parallel should register the same parameters in the same order");
+    REPORT_TEST_RESULT(managers[1].getParameter("D_1")->getValueString() == managers[0].getParameter("D_1")->getValueString() && managers[1].getParameter("D_287") != nullptr
+        && managers[1].getFirstParameterOfTypeName("A") == managers[1].getParameter(2) && managers[1].getNumParametersOfTypeName("N") == 2000
+        && managers[1].getNumParametersOfType(rlib::ParameterType::kParamDouble) == 287, "Loading in parallel should build the same indexes");
+
+    std::remove("parallelParameters.txt");
+}
+
+bool haveSameParameters(const rlib::ParameterManager& a, const rlib::ParameterManager& b)
+{
+    if (a.getNumParameters() != b.getNumParameters())
+        return false;
+
+    for (size_t i = 0; i < a.getNumParameters(); ++i)
+    {
+        const rlib::Parameter* paramA = a.getParameter(i);
+        const rlib::Parameter* paramB = b.getParameter(i);
+
+        if (paramA->getName() != paramB->getName() || paramA->getTypeName() != paramB->getTypeName() || paramA->getType() != paramB->getType()
+            || paramA->getValueString() != paramB->getValueString())
+            return false;
+    }
+
+    return true;
+}
+
+void parameterSnapshotTest()
+{
+    printf("------Parameter snapshot test------\n");
+
+    {
+        std::ofstream file("snapshotParameters.txt");
+        file << "N 3\nA 0 1 0.25 10\nA 0 2 1 0.75 -2.5\nD 0.1\nstring hello world\nbool true\nintArray 1 -2 3\ndoubleArray 0.5 1e-300\n";
+        file << "stringArray a bb ccc\nboolArray true false true\nfloatArray 1.5\nuint 4000000000\nN 7\n";
+    }
+    std::remove("snapshotParameters.bin");
+
+    rlib::ParameterManager text;
+    rlib::ParameterManager restored;
+    rlib::ParameterManager mismatched;
+    rlib::ParameterManager* managers[3] = { &text, &restored, &mismatched };
+
+    for (rlib::ParameterManager* manager : managers)
+    {
+        manager->registerParameterType("N", manager != &mismatched ? rlib::ParameterType::kParamInt : rlib::ParameterType::kParamUInt);
+        manager->registerParameterType("A", rlib::ParameterType::kParamMdpStateTransitionDef);
+        manager->registerParameterType("D", rlib::ParameterType::kParamDouble);
+    }
+
+    // The first load parses the file and writes the snapshot, the second one restores it
+    text.loadFromFileCached("snapshotParameters.txt", "snapshotParameters.bin");
+    const bool isRestored = restored.loadSnapshot("snapshotParameters.bin", "snapshotParameters.txt");
+
+    REPORT_TEST_RESULT(isRestored && text.getNumParameters() == 13 && haveSameParameters(text, restored), "A snapshot should restore every parameter");
+    REPORT_TEST_RESULT(restored.getParameter("A_2") == restored.getParameter(2) && restored.getFirstParameterOfTypeName("D") == restored.getParameter(3)
+        && restored.getNumParametersOfTypeName("N") == 2 && restored.getNumParametersOfType(rlib::ParameterType::kParamInt) == 2, "A restored snapshot should be indexed");
+
+    const rlib::Parameter* added = restored.registerParameter("N", "9");
+    restored.unregisterParameter(0);
+    REPORT_TEST_RESULT(added != nullptr && added->getName() == "N_3" && restored.getParameter("N_1") == nullptr && restored.getNumParameters() == 13,
+        "Restored parameters should be managed like loaded ones");
+
+    REPORT_TEST_RESULT(!mismatched.loadSnapshot("snapshotParameters.bin", "snapshotParameters.txt") && mismatched.getNumParameters() == 0
+        && !restored.loadSnapshot("snapshotParameters.bin", "snapshotParameters.txt"), "A snapshot should only be restored with the same types into an empty manager");
+
+    // Changing the source invalidates the snapshot, which the next cached load rewrites
+    {
+        std::ofstream file("snapshotParameters.txt", std::ios::app);
+        file << "N 8\n";
+    }
+
+    rlib::ParameterManager stale;
+    rlib::ParameterManager reloaded;
+    for (rlib::ParameterManager* manager : { &stale, &reloaded })
+    {
+        manager->registerParameterType("N", rlib::ParameterType::kParamInt);
+        manager->registerParameterType("A", rlib::ParameterType::kParamMdpStateTransitionDef);
+        manager->registerParameterType("D", rlib::ParameterType::kParamDouble);
+    }
+
+    const bool isStale = !stale.loadSnapshot("snapshotParameters.bin", "snapshotParameters.txt");
+    stale.loadFromFileCached("snapshotParameters.txt", "snapshotParameters.bin");
+
+    REPORT_TEST_RESULT(isStale && stale.getNumParameters() == 14 && reloaded.loadSnapshot("snapshotParameters.bin", "snapshotParameters.txt") && haveSameParameters(stale, reloaded),
+        "A snapshot should be invalidated by a change to its source");
+
+    // A truncated snapshot is rejected
+    {
+        std::string bytes;
+        {
+            std::ifstream file("snapshotParameters.bin", std::ios::binary);
+            bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+
+        std::ofstream file("snapshotParameters.bin", std::ios::binary | std::ios::trunc);
+        file.write(bytes.data(), bytes.size() - 1);
+    }
+
+    rlib::ParameterManager truncated;
+    truncated.registerParameterType("N", rlib::ParameterType::kParamInt);
+    truncated.registerParameterType("A", rlib::ParameterType::kParamMdpStateTransitionDef);
+    truncated.registerParameterType("D", rlib::ParameterType::kParamDouble);
+    REPORT_TEST_RESULT(!truncated.loadSnapshot("snapshotParameters.bin", "snapshotParameters.txt") && truncated.getNumParameters() == 0, "A corrupted snapshot should be rejected");
+
+    std::remove("snapshotParameters.txt");
+    std::remove("snapshotParameters.bin");
+}
+
+void parameterStoreTest()
+{
+    printf("------Parameter store test------\n");
+
+    rlib::ParameterManager manager;
+    manager.registerParameterType("N", rlib::ParameterType::kParamInt);
+    manager.registerParameterType("A", rlib::ParameterType::kParamMdpStateTransitionDef);
+    manager.registerParameterType("string", rlib::ParameterType::kParamString);
+    manager.registerParameterType("doubleArray", rlib::ParameterType::kParamDoubleArray);
+
+    manager.registerParameter("N", "3");
+    manager.registerParameter("A", "0 1 0.25 10");
+    manager.registerParameter("string", "hello world");
+    manager.registerParameter("doubleArray", "0.5 1.5 2.5");
+    manager.registerParameter("N", "4");
+
+    // Handles read the typed columns without creating parameter objects
+    rlib::ParameterHandle n2 = manager.findParameter("N_2");
+    rlib::ParameterHandle a1 = manager.findParameter("A_1");
+    rlib::ParameterHandle string1 = manager.findParameter("string_1");
+    rlib::ParameterHandle array1 = manager.findParameter("doubleArray_1");
+    rlib::ParameterArrayView<double> array = manager.getDoubleArray(array1);
+
+    REPORT_TEST_RESULT(n2.isValid() && manager.getInt(n2) == 4 && manager.getName(n2) == "N_2" && manager.getTypeName(n2) == "N" && !manager.findParameter("N_3").isValid(),
+        "A handle should read the value and name of a parameter");
+    REPORT_TEST_RESULT(manager.getTransition(a1).stateID == 0 && manager.getTransition(a1).nextStateID == 1 && manager.getTransition(a1).cost == 10
+        && manager.getString(string1) == "hello world" && array.size() == 3 && array[2] == 2.5, "Typed getters should read every kind of value");
+
+    // Concurrent readers creating the same view get a single one
+    const rlib::ParameterManager& readOnly = manager;
+    rlib::Parameter* views[4] = { nullptr, nullptr, nullptr, nullptr };
+    std::vector<std::thread> readers;
+    for (int i = 0; i < 4; ++i)
+        readers.push_back(std::thread([&readOnly, &views, a1, i]() { views[i] = readOnly.getParameter(a1); }));
+    for (size_t i = 0; i < readers.size(); ++i)
+        readers[i].join();
+
+    REPORT_TEST_RESULT(views[0] != nullptr && views[0] == views[1] && views[0] == views[2] && views[0] == views[3], "Concurrent readers should share the views they create");
+
+    // Parameters are views over the columns, their setters write through
+    rlib::IntParameter* n1 = static_cast<rlib::IntParameter*>(manager.getParameter("N_1"));
+    n1->setValue(42);
+    static_cast<rlib::DoubleArrayParameter*>(manager.getParameter(array1))->setValue(0, -1.0);
+    manager.getParameter(string1)->fromString("a longer value than before");
+
+    REPORT_TEST_RESULT(manager.getInt(manager.getHandle(0)) == 42 && manager.getDoubleArray(array1)[0] == -1.0 && manager.getString(string1) == "a longer value than before"
+        && manager.getParameter(string1) == manager.getParameter("string_1"), "Parameter setters should write to the columns");
+
+    // Handles stay valid when the parameters before them are unregistered
+    manager.unregisterParameter(0);
+    REPORT_TEST_RESULT(manager.isRegistered(n2) && manager.getInt(n2) == 4 && manager.getHandle(3) == n2 && !manager.findParameter("N_1").isValid()
+        && manager.getNumParametersOfType(rlib::ParameterType::kParamInt) == 1 && manager.getFirstParameterOfTypeName("N") == manager.getParameter(n2),
+        "Handles should be stable across unregistrations");
+}
+
+void parameterTypedHandleTest()
+{
+    printf("------Parameter typed handle test------\n");
+
+    rlib::ParameterManager manager;
+    manager.registerParameterType("D", rlib::ParameterType::kParamDouble);
+    manager.registerParameterType("A", rlib::ParameterType::kParamMdpStateTransitionDef);
+    manager.registerParameterType("doubleArray", rlib::ParameterType::kParamDoubleArray);
+    manager.registerParameterType("boolArray", rlib::ParameterType::kParamBoolArray);
+
+    manager.registerParameter("D", "0.5");
+    manager.registerParameter("A", "1 2 3 0.25 10");
+    manager.registerParameter("doubleArray", "1 2 3");
+    manager.registerParameter("boolArray", "true false");
+
+    rlib::ParamHandle<double> d1 = manager.bindParameter<double>("D_1");
+    rlib::ParamHandle<rlib::MdpTransitionValue> a1 = manager.bindParameter<rlib::MdpTransitionValue>("A_1");
+    rlib::ParamHandle<rlib::DoubleArray> array1 = manager.bindParameter<rlib::DoubleArray>("doubleArray_1");
+    rlib::ParamHandle<rlib::BoolArray> bools1 = manager.bindParameter<rlib::BoolArray>("boolArray_1");
+
+    REPORT_TEST_RESULT(d1.isBound() && *d1 == 0.5 && a1.get().actionID == 2 && a1.get().probability == 0.25 && array1.get().size() == 3 && array1.get()[1] == 2.0
+        && bools1.get().size() == 2 && bools1.get()[0] && !bools1.get()[1], "A typed handle should read the value of its parameter");
+    REPORT_TEST_RESULT(!manager.bindParameter<int>("D_1").isBound() && !manager.bindParameter<double>("D_2").isBound() && !rlib::ParamHandle<float>().isBound(),
+        "A typed handle should only bind to an existing parameter of its type");
+
+    // The columns grow and the values change under the bound handles
+    for (int i = 0; i < 1000; ++i)
+        manager.registerParameter("D", std::to_string(i));
+
+    static_cast<rlib::DoubleParameter*>(manager.getParameter("D_1"))->setValue(-4.0);
+    manager.getParameter("doubleArray_1")->fromString("4 5 6 7");
+    manager.unregisterParameter(1);
+
+    REPORT_TEST_RESULT(*d1 == -4.0 && array1.get().size() == 4 && array1.get()[3] == 7.0 && *manager.bindParameter<double>("D_1001") == 999.0,
+        "A typed handle should follow its parameter as the manager changes");
+}
+
+void writeLiveParameters(const char* filename, int value)
+{
+    // Written aside and renamed in place, as deployment tools do, so that a reload never sees a partial file
+    {
+        std::ofstream file("liveParameters.tmp");
+        file << "N " << value << "\nN " << value << "\n";
+    }
+    std::rename("liveParameters.tmp", filename);
+}
+
+void liveParameterTest()
+{
+    printf("------Live parameter test------\n");
+
+    writeLiveParameters("liveParameters.txt", 1);
+
+    rlib::LiveParameterManager live("liveParameters.txt", [](rlib::ParameterManager& manager)
+    {
+        manager.registerParameterType("N", rlib::ParameterType::kParamInt);
+    });
+
+    {
+        rlib::LiveParameterManager::ReadGuard empty(live);
+        REPORT_TEST_RESULT(empty.getVersion() == 0 && empty->getNumParameters() == 0 && live.reload() && live.getVersion() == 1, "A live manager should start empty and load on reload");
+    }
+
+    // A pinned version survives the reloads, and is reclaimed once released
+    {
+        rlib::LiveParameterManager::ReadGuard pinned(live);
+        writeLiveParameters("liveParameters.txt", 2);
+        live.reload();
+
+        rlib::LiveParameterManager::ReadGuard current(live);
+        REPORT_TEST_RESULT(pinned->getInt(pinned->findParameter("N_1")) == 1 && current->getInt(current->findParameter("N_1")) == 2 && current.getVersion() == 2
+            && live.reclaim() == 1, "A guard should keep its version alive across a reload");
+    }
+    REPORT_TEST_RESULT(live.reclaim() == 0, "A released version should be reclaimed");
+
+    // Readers check that both parameters of every version they see are equal while the file is reloaded under them
+    std::atomic<bool> isStopping(false);
+    std::atomic<size_t> numInconsistent(0);
+    std::atomic<size_t> numReads(0);
+    std::vector<std::thread> readers;
+
+    for (int t = 0; t < 3; ++t)
+    {
+        readers.push_back(std::thread([&]()
+        {
+            while (!isStopping)
+            {
+                rlib::LiveParameterManager::ReadGuard guard(live);
+                rlib::ParamHandle<int> n1 = guard->bindParameter<int>("N_1");
+                rlib::ParamHandle<int> n2 = guard->bindParameter<int>("N_2");
+
+                if (!n1.isBound() || !n2.isBound() || *n1 != *n2 || static_cast<uint64_t>(*n1) != guard.getVersion())
+                    numInconsistent++;
+
+                numReads++;
+            }
+        }));
+    }
+
+    for (int value = 3; value <= 40; ++value)
+    {
+        writeLiveParameters("liveParameters.txt", value);
+        live.reload();
+    }
+
+    isStopping = true;
+    for (std::thread& reader : readers)
+        reader.join();
+
+    REPORT_TEST_RESULT(numInconsistent == 0 && numReads > 0 && live.getVersion() == 40 && live.reclaim() == 0, "Concurrent readers should only see complete versions");
+
+    // A file with an unknown type name is rejected and the current version kept
+    {
+        std::ofstream file("liveParameters.tmp");
+        file << "N 50\nbogusType 2\n";
+    }
+    std::rename("liveParameters.tmp", "liveParameters.txt");
+
+    const bool isRejected = !live.reload();
+    {
+        rlib::LiveParameterManager::ReadGuard guard(live);
+        REPORT_TEST_RESULT(isRejected && live.getVersion() == 40 && guard->getInt(guard->findParameter("N_1")) == 40 && live.reclaim() == 0,
+            "A reload of an invalid file should keep the current version");
+    }
+
+    // The watch thread reloads the file when it is replaced
+    bool isReloaded = false;
+    if (live.startWatching())
+    {
+        writeLiveParameters("liveParameters.txt", 41);
+
+        for (int i = 0; i < 500 && !isReloaded; ++i)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            rlib::LiveParameterManager::ReadGuard guard(live);
+            isReloaded = guard->getInt(guard->findParameter("N_2")) == 41;
+        }
+
+        live.stopWatching();
+    }
+    REPORT_TEST_RESULT(isReloaded && !live.isWatching(), "A watched file should be reloaded when it changes");
+
+    std::remove("liveParameters.txt");
+}
+
+void parameterLazyLoadTest()
+{
+    printf("------Parameter lazy load test------\n");
+
+    {
+        std::ofstream file("lazyParameters.txt");
+        file << "N 3\nA 0 1 0.25 10\nD 0.1\nstring hello world\nintArray 1 -2 3\ndoubleArray 0.5 1e-300\nstringArray a bb ccc\nN 7\nN 9\n";
+    }
+    {
+        std::ofstream file("lazyInvalidParameters.txt");
+        file << "N abc\nN 5\n";
+    }
+
+    rlib::ParameterManager eager;
+    rlib::ParameterManager lazy;
+    for (rlib::ParameterManager* manager : { &eager, &lazy })
+    {
+        manager->registerParameterType("N", rlib::ParameterType::kParamInt);
+        manager->registerParameterType("A", rlib::ParameterType::kParamMdpStateTransitionDef);
+        manager->registerParameterType("D", rlib::ParameterType::kParamDouble);
+    }
+
+    eager.loadFromFile("lazyParameters.txt");
+    const bool isLoaded = lazy.loadFromFileLazy("lazyParameters.txt");
+
+    // Lines are named and counted without being parsed
+    REPORT_TEST_RESULT(isLoaded && lazy.getNumParameters() == 9 && lazy.getNumParametersOfTypeName("N") == 3 && lazy.findParameter("N_3").isValid()
+        && lazy.getNumParametersOfType(rlib::ParameterType::kParamIntArray) == 1, "A lazy load should index every line");
+
+    rlib::ParamHandle<rlib::IntArray> intArray = lazy.bindParameter<rlib::IntArray>("intArray_1");
+    REPORT_TEST_RESULT(lazy.getInt(lazy.findParameter("N_2")) == 7 && intArray.get().size() == 3 && intArray.get()[1] == -2
+        && lazy.getString(lazy.findParameter("string_1")) == "hello world", "Lazy values should be parsed on first access");
+    REPORT_TEST_RESULT(haveSameParameters(eager, lazy), "A lazy load should end with the values of an eager load");
+
+    // An invalid value is only found when it is read, its parameter keeps its name and the default value
+    lazy.loadFromFileLazy("lazyInvalidParameters.txt");
+    REPORT_TEST_RESULT(lazy.getNumParameters() == 11 && lazy.getInt(lazy.findParameter("N_4")) == 0 && lazy.getInt(lazy.findParameter("N_5")) == 5,
+        "A lazy value failing to parse should read as the default value");
+
+    // A snapshot of a lazy manager parses the values that were never read
+    rlib::ParameterManager lazySnapshot;
+    lazySnapshot.registerParameterType("N", rlib::ParameterType::kParamInt);
+    lazySnapshot.registerParameterType("A", rlib::ParameterType::kParamMdpStateTransitionDef);
+    lazySnapshot.registerParameterType("D", rlib::ParameterType::kParamDouble);
+    lazySnapshot.loadFromFileLazy("lazyParameters.txt");
+
+    rlib::ParameterManager restored;
+    restored.registerParameterType("N", rlib::ParameterType::kParamInt);
+    restored.registerParameterType("A", rlib::ParameterType::kParamMdpStateTransitionDef);
+    restored.registerParameterType("D", rlib::ParameterType::kParamDouble);
+
+    REPORT_TEST_RESULT(lazySnapshot.saveSnapshot("lazyParameters.bin", "lazyParameters.txt") && restored.loadSnapshot("lazyParameters.bin", "lazyParameters.txt")
+        && haveSameParameters(eager, restored), "A lazy manager should save the snapshot of its values");
+
+    std::remove("lazyParameters.txt");
+    std::remove("lazyInvalidParameters.txt");
+    std::remove("lazyParameters.bin");
 }
 
 void panicTest()
@@ -126,8 +1338,30 @@ int main()
     reportTestResultTest();
     logTest();
     mdpTest();
+    mdpArenaTest();
+    mdpLookupTest();
+    mdpSamplingTest();
+    mdpValidationTest();
+    mdpGeneratorPolicyTest();
+    mdpRunnerTest();
+    mdpBatchRunnerTest();
+    mdpRolloutTest();
+    mdpVarianceReductionTest();
+    mdpSolverTest();
+    mdpFileTest();
+    mdpBuilderTest();
+    actionMdpTest();
+    rngTest();
     parameterTest();
+    textParseTest();
     parameterLoadTest();
+    parameterIndexTest();
+    parameterParallelLoadTest();
+    parameterSnapshotTest();
+    parameterStoreTest();
+    parameterTypedHandleTest();
+    liveParameterTest();
+    parameterLazyLoadTest();
     panicTest();
     
     return EXIT_SUCCESS;